@@ -19,5 +19,8 @@ rm ${_arg} ./*.S || true
 # *.o (linker object)
 rm ${_arg} ./*.o || true
 
+# *.payload (transformed blob contents)
+rm ${_arg} ./*.payload || true
+
 # emblob_*.h (generated header)
 rm ${_arg} emblob_*.h || true
@@ -0,0 +1,138 @@
+/*
+ * emblob_simple.h
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_SIMPLE_H_INCLUDED
+#define _EMBLOB_SIMPLE_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdalign.h>
+
+#if defined(__cplusplus)
+# if !defined(EMBLOB_ALIGNAS)
+#  define EMBLOB_ALIGNAS alignas
+# endif
+# if !defined(EMBLOB_EXTERNAL)
+#  define EMBLOB_EXTERNAL extern "C"
+# endif
+#else
+# if !defined(EMBLOB_ALIGNAS)
+#  if __STDC_VERSION__ < 201710L
+#   define EMBLOB_ALIGNAS _Alignas
+#  elif __STDC_VERSION__ >= 201710L
+#   define EMBLOB_ALIGNAS alignas
+#  endif
+# endif
+# if !defined(EMBLOB_EXTERNAL)
+#  define EMBLOB_EXTERNAL extern
+# endif
+#endif
+
+#if defined(__APPLE__)
+# define EMBLOB_SIMPLE simple_data
+#else
+# define EMBLOB_SIMPLE _simple_data
+#endif
+
+/**
+ * The address of the embedded blob, stored as a pointer-sized unsigned integer.
+ */
+EMBLOB_EXTERNAL uintptr_t EMBLOB_SIMPLE;
+
+#if !defined(EMBLOB_SIMPLE_ADDRESS)
+# define EMBLOB_SIMPLE_ADDRESS (&EMBLOB_SIMPLE)
+#endif
+#if !defined(EMBLOB_SIMPLE_SIZE)
+# define EMBLOB_SIMPLE_SIZE UINT64_C(15)
+#endif
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the size of the embedded blob, in bytes.
+ */
+static inline
+uint64_t emblob_get_simple_size(void)
+{
+    return EMBLOB_SIMPLE_SIZE;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data one byte (8-bits) at a time.
+ */
+static inline
+const uint8_t* emblob_get_simple_8(void)
+{
+    return (const uint8_t*)EMBLOB_SIMPLE_ADDRESS;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data two bytes (16-bits) at a time.
+ */
+static inline
+const uint16_t* emblob_get_simple_16(void)
+{
+    return (const uint16_t*)EMBLOB_SIMPLE_ADDRESS;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data four bytes (32-bits) at a time.
+ */
+static inline
+const uint32_t* emblob_get_simple_32(void)
+{
+    return (const uint32_t*)EMBLOB_SIMPLE_ADDRESS;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data eight bytes (64-bits) at a time.
+ */
+static inline
+const uint64_t* emblob_get_simple_64(void)
+{
+    return (const uint64_t*)EMBLOB_SIMPLE_ADDRESS;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data arbitrarily.
+ */
+static inline
+const void* emblob_get_simple_raw(void)
+{
+    return (const void*)EMBLOB_SIMPLE_ADDRESS;
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+
+#endif // !_EMBLOB_SIMPLE_H_INCLUDED
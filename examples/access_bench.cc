@@ -0,0 +1,272 @@
+/*
+ * access_bench.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "emblob_access_small.h"
+#include "emblob_access_large.h"
+#include "emblob_access_sparse.h"
+#include "emblob_access_pack.h"
+#include "emblob_access_dir.h"
+
+/*
+ * Measures the runtime cost of accessing blobs embedded in each mode: a 1 MiB
+ * and a 64 MiB blob in .rodata (the default), a 64 MiB blob half of which is
+ * zeros (--sparse), a 64 MiB blob in a pack file (--pack), and a directory of
+ * 1000 4 KiB members.
+ *
+ * Each run executes a fresh copy of this program (after evicting it and the
+ * pack file from the page cache, best effort) which reports:
+ *
+ * - startup: from just before fork() in the parent to the start of main().
+ * - first touch: obtaining the blob's address and reading its first byte,
+ *   including any one-time work the mode does (mapping the pack file,
+ *   reconstructing the sparse blob).
+ * - the minor and major page faults (getrusage) incurred by the first touch
+ *   and a first sequential pass over the whole blob, and that pass's time.
+ * - a second (warm) sequential pass, and RANDOM_READS 64-byte reads at random
+ *   offsets.
+ * - for the directory, the mean time to look up a member by name.
+ */
+
+namespace
+{
+    constexpr int RUNS = 10;
+    constexpr int RANDOM_READS = 1 << 16;
+    constexpr size_t READ_SIZE = 64;
+
+    struct blob {
+        const char* name;
+        const uint8_t* (*data)(void);
+        uint64_t (*size)(void);
+    };
+
+    const blob blobs[] = {
+        { "rodata 1 MiB", &emblob_get_access_small_8, &emblob_get_access_small_size },
+        { "rodata 64 MiB", &emblob_get_access_large_8, &emblob_get_access_large_size },
+        { "sparse 64 MiB", &emblob_get_access_sparse_8, &emblob_get_access_sparse_size },
+        { "pack 64 MiB", &emblob_get_access_pack_8, &emblob_get_access_pack_size },
+        { "directory 1000", &emblob_get_access_dir_8, &emblob_get_access_dir_size }
+    };
+
+    struct sample {
+        int64_t startup_ns;
+        int64_t first_touch_ns;
+        int64_t minflt;
+        int64_t majflt;
+        int64_t seq_cold_ns;
+        int64_t seq_warm_ns;
+        int64_t random_ns;
+        int64_t lookup_ns;
+        uint64_t size;
+    };
+
+    int64_t now_ns() {
+        struct timespec ts {};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    void faults(int64_t& minflt, int64_t& majflt) {
+        struct rusage ru {};
+        getrusage(RUSAGE_SELF, &ru);
+        minflt = ru.ru_minflt;
+        majflt = ru.ru_majflt;
+    }
+
+    uint64_t sum(const uint8_t* data, uint64_t size) {
+        uint64_t total = 0;
+        for (uint64_t n = 0; n + sizeof(uint64_t) <= size; n += sizeof(uint64_t)) {
+            uint64_t v = 0;
+            memcpy(&v, data + n, sizeof(v));
+            total += v;
+        }
+
+        return total;
+    }
+
+    /* runs in the freshly executed child; the result is written to out_fd. */
+    int child(size_t index, int64_t spawned_ns, int out_fd) {
+        sample s {};
+        s.startup_ns = now_ns() - spawned_ns;
+
+        int64_t minflt = 0, majflt = 0;
+        faults(minflt, majflt);
+
+        const auto& b = blobs[index];
+        auto start = now_ns();
+        auto data = b.data();
+        [[maybe_unused]] volatile uint8_t first = *data;
+        s.first_touch_ns = now_ns() - start;
+        s.size = b.size();
+
+        volatile uint64_t sink = 0;
+        start = now_ns();
+        sink = sink + sum(data, s.size);
+        s.seq_cold_ns = now_ns() - start;
+
+        int64_t minflt_after = 0, majflt_after = 0;
+        faults(minflt_after, majflt_after);
+        s.minflt = minflt_after - minflt;
+        s.majflt = majflt_after - majflt;
+
+        start = now_ns();
+        sink = sink + sum(data, s.size);
+        s.seq_warm_ns = now_ns() - start;
+
+        std::mt19937_64 rng(index);
+        std::vector<uint64_t> offsets(RANDOM_READS);
+        for (auto& o : offsets) {
+            o = rng() % (s.size - READ_SIZE);
+        }
+
+        uint8_t buf[READ_SIZE];
+        start = now_ns();
+        for (auto o : offsets) {
+            memcpy(buf, data + o, READ_SIZE);
+            sink = sink + buf[o % READ_SIZE];
+        }
+        s.random_ns = now_ns() - start;
+
+        if (data == emblob_get_access_dir_8()) {
+            std::vector<std::string> names;
+            for (uint64_t n = 0; n < emblob_access_dir_member_count(); n++) {
+                names.emplace_back(emblob_access_dir_member_name(n));
+            }
+
+            start = now_ns();
+            for (const auto& name : names) {
+                sink = sink + static_cast<uint64_t>(emblob_access_dir_findn(name.data(), name.size()));
+            }
+            s.lookup_ns = (now_ns() - start) / static_cast<int64_t>(std::max<size_t>(1, names.size()));
+        }
+
+        return write(out_fd, &s, sizeof(s)) == static_cast<ssize_t>(sizeof(s)) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    void evict(const char* fname) {
+        int fd = open(fname, O_RDONLY | O_CLOEXEC);
+        if (fd != -1) {
+            [[maybe_unused]] auto ret = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+
+    bool run(size_t index, sample& s) {
+        int fds[2] = { -1, -1 };
+        if (0 != pipe(fds)) {
+            perror("pipe");
+            return false;
+        }
+
+        evict("/proc/self/exe");
+        evict(EMBLOB_ACCESS_PACK_PATH);
+
+        auto index_str = std::to_string(index);
+        auto spawned_str = std::to_string(now_ns());
+        auto fd_str = std::to_string(fds[1]);
+
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            return false;
+        } else if (pid == 0) {
+            close(fds[0]);
+            execl("/proc/self/exe", "access_bench", "--child", index_str.c_str(), spawned_str.c_str(),
+                fd_str.c_str(), nullptr);
+            _exit(127);
+        }
+
+        close(fds[1]);
+        auto got = read(fds[0], &s, sizeof(s));
+        close(fds[0]);
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+
+        if (got != static_cast<ssize_t>(sizeof(s)) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "child process failed\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    template<typename T>
+    int64_t median(std::vector<sample>& samples, T sample::*field) {
+        std::sort(samples.begin(), samples.end(), [field](const sample& a, const sample& b) {
+            return a.*field < b.*field;
+        });
+        return static_cast<int64_t>(samples[samples.size() / 2].*field);
+    }
+
+    double mb_per_s(uint64_t bytes, int64_t ns) {
+        return ns > 0 ? static_cast<double>(bytes) * 1000.0 / static_cast<double>(ns) : 0.0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 5 && 0 == strcmp(argv[1], "--child")) {
+        return child(strtoul(argv[2], nullptr, 10), strtoll(argv[3], nullptr, 10),
+            atoi(argv[4]));
+    }
+
+    printf("%d runs per mode (medians); bandwidth in MB/s, times in us unless noted\n", RUNS);
+    printf("%-16s %9s %11s %8s %7s %9s %9s %9s %10s\n", "mode", "startup", "first touch",
+        "minflt", "majflt", "seq cold", "seq warm", "random", "lookup ns");
+
+    for (size_t index = 0; index < std::size(blobs); index++) {
+        std::vector<sample> samples(RUNS);
+        for (auto& s : samples) {
+            if (!run(index, s))
+                return EXIT_FAILURE;
+        }
+
+        auto size = samples.front().size;
+        printf("%-16s %9.1f %11.1f %8" PRId64 " %7" PRId64 " %9.0f %9.0f %9.0f %10" PRId64 "\n",
+            blobs[index].name,
+            static_cast<double>(median(samples, &sample::startup_ns)) / 1000.0,
+            static_cast<double>(median(samples, &sample::first_touch_ns)) / 1000.0,
+            median(samples, &sample::minflt), median(samples, &sample::majflt),
+            mb_per_s(size, median(samples, &sample::seq_cold_ns)),
+            mb_per_s(size, median(samples, &sample::seq_warm_ns)),
+            mb_per_s(RANDOM_READS * READ_SIZE, median(samples, &sample::random_ns)),
+            median(samples, &sample::lookup_ns));
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,389 @@
+/*
+ * emblob_bench.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+
+/*
+ * Measures end-to-end generation time, throughput and peak memory of the
+ * emblob executable itself, for synthesized inputs: single files from 1 KiB up
+ * to --max-size (each 16 times the size of the last), and directories of up to
+ * --max-files files, in each output mode which applies to them. The results
+ * are printed as JSON (schema "emblob-bench/1"), one object per mode and input,
+ * so that they may be compared across releases and machines.
+ *
+ * Each configuration is run --runs times, in a fresh directory; the timings
+ * are of the whole process (including the assembler which emblob runs), and
+ * the peak RSS and subprocess time are those that emblob reports with
+ * --stats=json.
+ */
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr uint64_t KIB = 1024;
+    constexpr uint64_t MIB = 1024 * KIB;
+    constexpr uint64_t GIB = 1024 * MIB;
+    constexpr uint64_t BATCH_FILE_SIZE = 4 * KIB;
+    constexpr size_t CHUNK_SIZE = 4 * MIB;
+
+    struct options {
+        std::string emblob = EMBLOB_BENCH_EMBLOB;
+        std::string work_dir;
+        std::string out_file;
+        uint64_t max_size = 256 * MIB;
+        uint64_t max_files = 10000;
+        int runs = 3;
+    };
+
+    struct mode {
+        const char* name;
+        std::vector<std::string> args;
+    };
+
+    struct result {
+        std::string mode;
+        std::string input;
+        uint64_t files = 0;
+        uint64_t bytes = 0;
+        std::vector<int64_t> wall_us;
+        int64_t peak_rss_bytes = 0;
+        int64_t subprocess_us = 0;
+        int exit_code = 0;
+    };
+
+    bool parse_size(const char* str, uint64_t& out) {
+        char* end = nullptr;
+        auto value = strtoull(str, &end, 10);
+        if (end == str) {
+            return false;
+        }
+
+        switch (*end) {
+            case 'k': case 'K': value *= KIB; end++; break;
+            case 'm': case 'M': value *= MIB; end++; break;
+            case 'g': case 'G': value *= GIB; end++; break;
+            default: break;
+        }
+
+        out = value;
+        return *end == '\0';
+    }
+
+    /* text made of words from a small vocabulary, so that it compresses like
+     * typical assets do; the same seed always produces the same text. */
+    std::string synthesize(uint64_t size, uint64_t seed) {
+        static const char* const words[] = {
+            "emblob", "blob", "asset", "header", "section", "linker", "object", "member",
+            "<div>", "</div>", "{", "}", "\"key\":", "0x1f", "color:", "#fff;", "\n"
+        };
+
+        std::mt19937_64 rng(seed);
+        std::string out;
+        out.reserve(size + 16);
+        while (out.size() < size) {
+            out += words[rng() % std::size(words)];
+            out += ' ';
+        }
+
+        out.resize(size);
+        return out;
+    }
+
+    bool write_file(const fs::path& path, uint64_t size, uint64_t seed) {
+        std::ofstream strm(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        auto chunk = synthesize(std::min<uint64_t>(size, CHUNK_SIZE), seed);
+        for (uint64_t written = 0; strm && written < size; written += chunk.size()) {
+            auto len = std::min<uint64_t>(chunk.size(), size - written);
+            strm.write(chunk.data(), static_cast<std::streamsize>(len));
+        }
+
+        return static_cast<bool>(strm);
+    }
+
+    int64_t json_number(const std::string& json, const std::string& key) {
+        auto pos = json.find("\"" + key + "\":");
+        return pos != std::string::npos ? strtoll(json.c_str() + pos + key.size() + 3, nullptr, 10) : 0;
+    }
+
+    /* runs emblob in dir, returning its exit code (or -1), and its standard
+     * output in out. */
+    int run_emblob(const options& opts, const fs::path& dir, const std::vector<std::string>& args,
+        std::string& out) {
+        int fds[2] = { -1, -1 };
+        if (0 != pipe(fds)) {
+            perror("pipe");
+            return -1;
+        }
+
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(opts.emblob.c_str()));
+        for (const auto& a : args) {
+            argv.push_back(const_cast<char*>(a.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            return -1;
+        } else if (pid == 0) {
+            int null_fd = open("/dev/null", O_WRONLY);
+            if (0 != chdir(dir.c_str()) || -1 == dup2(fds[1], STDOUT_FILENO) ||
+                -1 == dup2(null_fd, STDERR_FILENO)) {
+                _exit(127);
+            }
+
+            close(fds[0]);
+            execv(argv[0], argv.data());
+            _exit(127);
+        }
+
+        close(fds[1]);
+        char buf[4096];
+        ssize_t got = 0;
+        while ((got = read(fds[0], buf, sizeof(buf))) > 0) {
+            out.append(buf, static_cast<size_t>(got));
+        }
+        close(fds[0]);
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    result measure(const options& opts, const fs::path& input, const mode& m, const char* kind,
+        uint64_t files, uint64_t bytes) {
+        result r;
+        r.mode  = m.name;
+        r.input = kind;
+        r.files = files;
+        r.bytes = bytes;
+
+        for (int n = 0; n < opts.runs; n++) {
+            auto dir = fs::path(opts.work_dir) / "run";
+            fs::remove_all(dir);
+            fs::create_directories(dir);
+
+            std::vector<std::string> args = { "-i", fs::absolute(input).string() };
+            args.insert(args.end(), m.args.begin(), m.args.end());
+            args.insert(args.end(), { "--stats=json", "-l", "error" });
+
+            std::string out;
+            auto start = std::chrono::steady_clock::now();
+            r.exit_code = run_emblob(opts, dir, args, out);
+            auto end = std::chrono::steady_clock::now();
+
+            r.wall_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+            r.peak_rss_bytes = std::max(r.peak_rss_bytes, json_number(out, "peak_rss_bytes"));
+            if (auto pos = out.find("\"subprocess\":"); pos != std::string::npos) {
+                r.subprocess_us = std::max(r.subprocess_us, json_number(out.substr(pos), "wall_time_us"));
+            }
+
+            fs::remove_all(dir);
+            if (r.exit_code != 0) {
+                break;
+            }
+        }
+
+        std::sort(r.wall_us.begin(), r.wall_us.end());
+        fprintf(stderr, "%-12s %-9s %6" PRIu64 " files %12" PRIu64 " bytes: %10" PRId64 " us%s\n",
+            r.mode.c_str(), r.input.c_str(), r.files, r.bytes, r.wall_us[r.wall_us.size() / 2],
+            r.exit_code != 0 ? " (failed)" : "");
+        return r;
+    }
+
+    std::string emblob_version(const options& opts) {
+        std::string out;
+        if (0 != run_emblob(opts, fs::current_path(), { "--version" }, out)) {
+            return "unknown";
+        }
+
+        while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) {
+            out.pop_back();
+        }
+
+        return out;
+    }
+
+    void print_json(FILE* f, const options& opts, const std::vector<result>& results) {
+        struct utsname un {};
+        uname(&un);
+
+        fprintf(f, "{\"schema\":\"emblob-bench/1\",\"emblob\":\"%s\",", emblob_version(opts).c_str());
+        fprintf(f, "\"machine\":{\"os\":\"%s\",\"release\":\"%s\",\"arch\":\"%s\",\"cpus\":%ld},",
+            un.sysname, un.release, un.machine, sysconf(_SC_NPROCESSORS_ONLN));
+        fprintf(f, "\"runs\":%d,\"results\":[\n", opts.runs);
+
+        for (size_t n = 0; n < results.size(); n++) {
+            const auto& r = results[n];
+            auto median = r.wall_us[r.wall_us.size() / 2];
+            auto mb_per_s = median > 0 ? static_cast<double>(r.bytes) / static_cast<double>(median) : 0.0;
+
+            fprintf(f, "{\"mode\":\"%s\",\"input\":\"%s\",\"files\":%" PRIu64 ",\"bytes\":%" PRIu64 ","
+                "\"wall_us\":{\"min\":%" PRId64 ",\"median\":%" PRId64 ",\"max\":%" PRId64 "},"
+                "\"mb_per_s\":%.3f,\"peak_rss_bytes\":%" PRId64 ",\"subprocess_us\":%" PRId64 ","
+                "\"exit_code\":%d}%s\n", r.mode.c_str(), r.input.c_str(), r.files, r.bytes,
+                r.wall_us.front(), median, r.wall_us.back(), mb_per_s, r.peak_rss_bytes,
+                r.subprocess_us, r.exit_code, n + 1 < results.size() ? "," : "");
+        }
+
+        fprintf(f, "]}\n");
+    }
+
+    int usage() {
+        fprintf(stderr, "usage: emblob_bench [--emblob PATH] [--max-size SIZE[K|M|G]] [--max-files N]\n"
+            "                    [--runs N] [--work-dir DIR] [--out FILE]\n");
+        return EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            return usage();
+        }
+
+        bool ok = true;
+        if (arg == "--emblob") {
+            opts.emblob = value;
+        } else if (arg == "--max-size") {
+            ok = parse_size(value, opts.max_size);
+        } else if (arg == "--max-files") {
+            ok = parse_size(value, opts.max_files);
+        } else if (arg == "--runs") {
+            opts.runs = std::max(1, atoi(value));
+        } else if (arg == "--work-dir") {
+            opts.work_dir = value;
+        } else if (arg == "--out") {
+            opts.out_file = value;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            return usage();
+        }
+
+        i++;
+    }
+
+    bool own_work_dir = opts.work_dir.empty();
+    if (own_work_dir) {
+        char tmpl[] = "/tmp/emblob_bench.XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            perror("mkdtemp");
+            return EXIT_FAILURE;
+        }
+        opts.work_dir = tmpl;
+    }
+
+    opts.emblob = fs::absolute(opts.emblob).string();
+
+    const std::vector<mode> file_modes = {
+        { "asm", {} },
+        { "pack", { "--pack", "input.pak" } },
+    };
+
+    const std::vector<mode> dir_modes = {
+        { "directory", {} },
+        { "deflate", { "-c", "deflate" } },
+        { "http", { "--http", "identity" } },
+    };
+
+    std::vector<result> results;
+    auto inputs = fs::path(opts.work_dir) / "inputs";
+
+    for (uint64_t size = KIB; size <= opts.max_size; size *= 16) {
+        fs::create_directories(inputs);
+        auto input = inputs / "input.bin";
+        if (!write_file(input, size, size)) {
+            fprintf(stderr, "failed to write %s\n", input.c_str());
+            return EXIT_FAILURE;
+        }
+
+        for (const auto& m : file_modes) {
+            results.push_back(measure(opts, input, m, "file", 1, size));
+        }
+
+        fs::remove_all(inputs);
+    }
+
+    for (uint64_t files = 1; files <= opts.max_files; files *= 10) {
+        auto input = inputs / "input";
+        fs::create_directories(input);
+        for (uint64_t n = 0; n < files; n++) {
+            auto name = input / std::string("d").append(std::to_string(n % 100)) /
+                std::string("f").append(std::to_string(n)).append(".txt");
+            fs::create_directories(name.parent_path());
+            if (!write_file(name, BATCH_FILE_SIZE, n)) {
+                fprintf(stderr, "failed to write %s\n", name.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+
+        for (const auto& m : dir_modes) {
+            results.push_back(measure(opts, input, m, "directory", files, files * BATCH_FILE_SIZE));
+        }
+
+        fs::remove_all(inputs);
+    }
+
+    FILE* out = stdout;
+    if (!opts.out_file.empty() && !(out = fopen(opts.out_file.c_str(), "w"))) {
+        perror("fopen");
+        return EXIT_FAILURE;
+    }
+
+    print_json(out, opts, results);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    if (own_work_dir) {
+        fs::remove_all(opts.work_dir);
+    }
+
+    return EXIT_SUCCESS;
+}
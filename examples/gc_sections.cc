@@ -0,0 +1,43 @@
+/*
+ * gc_sections.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <cstring>
+#include "emblob_gc_used.h"
+
+/*
+ * Links against an object holding three blobs (see gc_blobs in CMakeLists.txt),
+ * and references only one of them, gc_used, so that the test registered
+ * alongside it can check that --gc-sections (-dead_strip) discards the other
+ * two, and keeps gc_used intact.
+ */
+int main()
+{
+    const char expected[] = GC_SECTIONS_USED_CONTENTS;
+    auto size = emblob_get_gc_used_size();
+    auto bytes = emblob_get_gc_used_8();
+
+    return size == sizeof(expected) - 1 && memcmp(bytes, expected, size) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,52 @@
+################################################################################
+# emblob/examples: checks that a program linked with --gc-sections (KEPT and
+# DISCARDED are the same program, linked without and with it, against one
+# object holding the blobs gc_used, gc_unused and gc_dir) keeps only gc_used,
+# which it references, and is smaller by at least BLOB_SIZE (the size of
+# gc_unused).
+#
+# SPDX-License-Identifier: MIT
+# SPDX-FileCopyrightText: Copyright (c) 2018-2024 Ryan M. Lederman
+
+foreach (PROGRAM ${KEPT} ${DISCARDED})
+    execute_process(COMMAND ${PROGRAM} RESULT_VARIABLE RESULT)
+    if (NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "${PROGRAM} did not find the contents of gc_used intact")
+    endif()
+endforeach()
+
+execute_process(COMMAND ${NM} ${KEPT} OUTPUT_VARIABLE KEPT_SYMBOLS RESULT_VARIABLE RESULT)
+if (NOT RESULT EQUAL 0)
+    message(FATAL_ERROR "${NM} ${KEPT} failed")
+endif()
+
+execute_process(COMMAND ${NM} ${DISCARDED} OUTPUT_VARIABLE DISCARDED_SYMBOLS RESULT_VARIABLE RESULT)
+if (NOT RESULT EQUAL 0)
+    message(FATAL_ERROR "${NM} ${DISCARDED} failed")
+endif()
+
+foreach (BLOB gc_used gc_unused gc_dir)
+    if (NOT KEPT_SYMBOLS MATCHES " [A-Za-z] _?_${BLOB}_data\n")
+        message(FATAL_ERROR "${BLOB} is missing without --gc-sections")
+    endif()
+endforeach()
+
+if (NOT DISCARDED_SYMBOLS MATCHES " [A-Za-z] _?_gc_used_data\n")
+    message(FATAL_ERROR "the referenced blob gc_used was discarded")
+endif()
+
+foreach (BLOB gc_unused gc_dir)
+    if (DISCARDED_SYMBOLS MATCHES " [A-Za-z] _?_${BLOB}_(data|members)\n")
+        message(FATAL_ERROR "the unreferenced blob ${BLOB} was not discarded")
+    endif()
+endforeach()
+
+file(SIZE ${KEPT} KEPT_SIZE)
+file(SIZE ${DISCARDED} DISCARDED_SIZE)
+
+message(STATUS "without --gc-sections: ${KEPT_SIZE} bytes; with it: ${DISCARDED_SIZE} bytes")
+
+math(EXPR SAVED "${KEPT_SIZE} - ${DISCARDED_SIZE}")
+if (SAVED LESS BLOB_SIZE)
+    message(FATAL_ERROR "only ${SAVED} bytes were discarded; gc_unused alone is ${BLOB_SIZE}")
+endif()
@@ -0,0 +1,275 @@
+/*
+ * json_bench.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <charconv>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <inttypes.h>
+#include "emblob_config.h"
+
+/*
+ * Compares the "startup" cost of consuming an embedded JSON document in two
+ * ways: parsing the raw text into a DOM at runtime (tokenizing, unescaping, and
+ * allocating, as a typical JSON library would), versus walking the tape that
+ * emblob generated with --json-tape. Both extract the same facts from the
+ * document, and the results are checked against each other.
+ */
+
+namespace
+{
+    constexpr int RUNS = 21;
+
+    struct summary {
+        uint64_t items = 0;
+        int64_t id_sum = 0;
+        double weight_sum = 0.0;
+        uint64_t enabled = 0;
+        uint64_t text_bytes = 0;
+
+        bool operator==(const summary&) const = default;
+    };
+
+    /* a minimal, conventional DOM parser. it does no validation beyond what is
+     * needed to not crash, which only flatters it. */
+    struct node {
+        enum class kind { null, boolean, number, string, array, object } type = kind::null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string str;
+        std::vector<node> elements;
+        std::vector<std::pair<std::string, node>> members;
+
+        const node* find(const char* key) const {
+            for (const auto& m : members) {
+                if (m.first == key)
+                    return &m.second;
+            }
+            return nullptr;
+        }
+    };
+
+    class dom_parser
+    {
+    public:
+        dom_parser(const char* data, size_t len) : _cur(data), _end(data + len) { }
+
+        node parse() {
+            node n;
+            _value(n);
+            return n;
+        }
+
+    private:
+        void _ws() {
+            while (_cur < _end && (*_cur == ' ' || *_cur == '\n' || *_cur == '\r' || *_cur == '\t'))
+                _cur++;
+        }
+
+        void _string(std::string& out) {
+            _cur++;
+            while (_cur < _end && *_cur != '"') {
+                if (*_cur == '\\') {
+                    _cur++;
+                    switch (*_cur) {
+                        case 'n': out.push_back('\n'); break;
+                        case 't': out.push_back('\t'); break;
+                        case 'r': out.push_back('\r'); break;
+                        case 'b': out.push_back('\b'); break;
+                        case 'f': out.push_back('\f'); break;
+                        case 'u': {
+                            unsigned cp = 0;
+                            std::from_chars(_cur + 1, _cur + 5, cp, 16);
+                            if (cp < 0x80) {
+                                out.push_back(static_cast<char>(cp));
+                            } else if (cp < 0x800) {
+                                out.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+                                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+                            } else {
+                                out.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+                                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+                                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+                            }
+                            _cur += 4;
+                        }
+                        break;
+                        default: out.push_back(*_cur); break;
+                    }
+                    _cur++;
+                } else {
+                    out.push_back(*_cur++);
+                }
+            }
+            _cur++;
+        }
+
+        void _value(node& n) {
+            _ws();
+            switch (*_cur) {
+                case '{':
+                    n.type = node::kind::object;
+                    _cur++;
+                    _ws();
+                    while (*_cur != '}') {
+                        std::string key;
+                        _string(key);
+                        _ws();
+                        _cur++;
+                        node child;
+                        _value(child);
+                        n.members.emplace_back(std::move(key), std::move(child));
+                        _ws();
+                        if (*_cur == ',') {
+                            _cur++;
+                            _ws();
+                        }
+                    }
+                    _cur++;
+                break;
+                case '[':
+                    n.type = node::kind::array;
+                    _cur++;
+                    _ws();
+                    while (*_cur != ']') {
+                        node child;
+                        _value(child);
+                        n.elements.push_back(std::move(child));
+                        _ws();
+                        if (*_cur == ',')
+                            _cur++;
+                    }
+                    _cur++;
+                break;
+                case '"':
+                    n.type = node::kind::string;
+                    _string(n.str);
+                break;
+                case 't': n.type = node::kind::boolean; n.boolean = true; _cur += 4; break;
+                case 'f': n.type = node::kind::boolean; _cur += 5; break;
+                case 'n': _cur += 4; break;
+                default: {
+                    n.type = node::kind::number;
+                    auto res = std::from_chars(_cur, _end, n.number);
+                    _cur = res.ptr;
+                }
+                break;
+            }
+        }
+
+        const char* _cur;
+        const char* _end;
+    };
+
+    summary summarize_dom() {
+        /* the blob is declared as a single uintptr_t, so GCC's bounds checking
+         * must be prevented from following the pointer back to it. */
+        auto text = reinterpret_cast<const char*>(emblob_get_config_8());
+        __asm__ ("" : "+r"(text));
+
+        dom_parser parser(text, static_cast<size_t>(emblob_get_config_size()));
+        node root = parser.parse();
+
+        summary s;
+        const node* items = root.find("items");
+        for (const auto& item : items->elements) {
+            s.items++;
+            s.id_sum += static_cast<int64_t>(item.find("id")->number);
+            s.weight_sum += item.find("weight")->number;
+            s.enabled += item.find("enabled")->boolean ? 1 : 0;
+            s.text_bytes += item.find("name")->str.size() + item.find("description")->str.size();
+        }
+
+        return s;
+    }
+
+    summary summarize_tape() {
+        emblob_json_value root = emblob_config_json_root();
+        emblob_json_value items = emblob_json_find(root, "items");
+
+        summary s;
+        for (auto item = emblob_json_first(items); emblob_json_valid(item); item = emblob_json_next(item)) {
+            int64_t id = 0;
+            double weight = 0.0;
+            int enabled = 0;
+            size_t name_len = 0;
+            size_t desc_len = 0;
+
+            emblob_json_int64(emblob_json_find(item, "id"), &id);
+            emblob_json_double(emblob_json_find(item, "weight"), &weight);
+            emblob_json_bool(emblob_json_find(item, "enabled"), &enabled);
+            emblob_json_string(emblob_json_find(item, "name"), &name_len);
+            emblob_json_string(emblob_json_find(item, "description"), &desc_len);
+
+            s.items++;
+            s.id_sum += id;
+            s.weight_sum += weight;
+            s.enabled += static_cast<uint64_t>(enabled);
+            s.text_bytes += name_len + desc_len;
+        }
+
+        return s;
+    }
+
+    template<typename TFunc>
+    summary measure(const char* label, const TFunc& func) {
+        std::vector<double> times;
+        summary s;
+
+        for (int n = 0; n < RUNS; n++) {
+            auto start = std::chrono::steady_clock::now();
+            s = func();
+            auto end = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        double first = times.front();
+        std::sort(times.begin(), times.end());
+        printf("%-16s first: %9.3f ms, median: %9.3f ms\n", label, first, times[times.size() / 2]);
+        return s;
+    }
+}
+
+int main()
+{
+    printf("%" PRIu64 " bytes of JSON; %d runs\n", emblob_get_config_size(), RUNS);
+
+    /* the tape is measured first, so that its first run is not flattered by
+     * the DOM parser having already faulted in the raw text. */
+    auto tape = measure("tape walk", summarize_tape);
+    auto dom  = measure("runtime parse", summarize_dom);
+
+    if (!(tape == dom)) {
+        fprintf(stderr, "results differ!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%" PRIu64 " items, %" PRIu64 " enabled\n", tape.items, tape.enabled);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+/*
+ * json_gen.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <cstdio>
+
+/*
+ * Writes a configuration-like JSON document of roughly 4 MiB to stdout, for use
+ * by json_bench.
+ */
+
+int main()
+{
+    constexpr int ITEMS = 20000;
+
+    printf("{\n  \"version\": 3,\n  \"service\": \"emblob-bench\",\n  \"items\": [\n");
+    for (int n = 0; n < ITEMS; n++) {
+        printf("    {\"id\": %d, \"name\": \"item-%d\", \"weight\": %d.%02d, \"enabled\": %s, "
+            "\"tags\": [\"alpha\", \"beta\", \"gamma\"], \"limits\": {\"min\": %d, \"max\": %d}, "
+            "\"description\": \"generated item number %d \\u00e9\\n\"}%s\n",
+            n, n, n % 1000, n % 100, (n % 3) ? "true" : "false", -n, n * 2, n,
+            n == ITEMS - 1 ? "" : ",");
+    }
+    printf("  ]\n}\n");
+
+    return EXIT_SUCCESS;
+}
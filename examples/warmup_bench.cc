@@ -0,0 +1,172 @@
+/*
+ * warmup_bench.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "emblob_warmup.h"
+
+/*
+ * Measures the latency of the first access to pages of an embedded blob in a
+ * freshly started process, with and without the generated paging functions.
+ *
+ * Each run forks a child which (optionally) starts warming the blob up, spends
+ * STARTUP_WORK doing "other initialization", and then reads one byte from each
+ * of SAMPLES randomly chosen pages, timing each access. Before each run, the
+ * executable is evicted from the page cache (best effort) so that the child
+ * incurs major faults when nothing has been done to avoid them.
+ */
+
+namespace
+{
+    constexpr int RUNS = 20;
+    constexpr int SAMPLES = 256;
+    constexpr auto STARTUP_WORK = std::chrono::milliseconds(50);
+
+    enum class strategy {
+        none,
+        willneed,
+        warmup
+    };
+
+    const char* strategy_name(strategy s) {
+        switch (s) {
+            case strategy::none:     return "no warm-up";
+            case strategy::willneed: return "advise(WILLNEED)";
+            case strategy::warmup:   return "background warm-up";
+            default:                 return "";
+        }
+    }
+
+    void child(strategy s, int out_fd, unsigned seed) {
+        if (s == strategy::willneed) {
+            [[maybe_unused]] auto ret = emblob_warmup_advise(EMBLOB_ADVISE_WILLNEED);
+        } else if (s == strategy::warmup) {
+            [[maybe_unused]] auto ret = emblob_warmup_warmup();
+        }
+
+        std::this_thread::sleep_for(STARTUP_WORK);
+
+        auto page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        auto pages = emblob_get_warmup_size() / page_size;
+        std::mt19937_64 rng(seed);
+        std::vector<uint64_t> latencies;
+        latencies.reserve(SAMPLES);
+
+        auto bytes = emblob_get_warmup_8();
+        for (int n = 0; n < SAMPLES; n++) {
+            auto offset = (rng() % pages) * page_size;
+            auto start = std::chrono::steady_clock::now();
+            [[maybe_unused]] auto value = *static_cast<const volatile uint8_t*>(bytes + offset);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        }
+
+        auto len = latencies.size() * sizeof(uint64_t);
+        if (write(out_fd, latencies.data(), len) != static_cast<ssize_t>(len)) {
+            _exit(EXIT_FAILURE);
+        }
+    }
+
+    void evict_executable() {
+        int fd = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+        if (fd != -1) {
+            [[maybe_unused]] auto ret = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+
+    bool run(strategy s, unsigned seed, std::vector<uint64_t>& latencies) {
+        int fds[2] = { -1, -1 };
+        if (0 != pipe(fds)) {
+            perror("pipe");
+            return false;
+        }
+
+        evict_executable();
+
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork");
+            return false;
+        } else if (pid == 0) {
+            close(fds[0]);
+            child(s, fds[1], seed);
+            _exit(EXIT_SUCCESS);
+        }
+
+        close(fds[1]);
+        std::vector<uint64_t> buf(SAMPLES);
+        auto len = buf.size() * sizeof(uint64_t);
+        auto got = read(fds[0], buf.data(), len);
+        close(fds[0]);
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+
+        if (got != static_cast<ssize_t>(len) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "child process failed\n");
+            return false;
+        }
+
+        latencies.insert(latencies.end(), buf.begin(), buf.end());
+        return true;
+    }
+
+    uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+        auto idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+        return sorted[idx];
+    }
+}
+
+int main()
+{
+    printf("%" PRIu64 " bytes; %d runs x %d first accesses\n", emblob_get_warmup_size(),
+        RUNS, SAMPLES);
+
+    for (auto s : { strategy::none, strategy::willneed, strategy::warmup }) {
+        std::vector<uint64_t> latencies;
+        for (int n = 0; n < RUNS; n++) {
+            if (!run(s, static_cast<unsigned>(n), latencies))
+                return EXIT_FAILURE;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        printf("%-20s p50: %8" PRIu64 " ns, p99: %8" PRIu64 " ns, max: %8" PRIu64 " ns\n",
+            strategy_name(s), percentile(latencies, 0.50), percentile(latencies, 0.99),
+            latencies.back());
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+/*
+ * zerocopy_bench.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <inttypes.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include "emblob_zerocopy.h"
+
+/*
+ * Compares serving the embedded blob through write(2) from its mapped address
+ * (which faults its pages in and copies them through user space) with the
+ * generated sendfile(2) and copy_file_range(2) functions.
+ */
+
+namespace
+{
+    constexpr int ITERATIONS = 10;
+    constexpr size_t CHUNK_SIZE = 1024 * 1024;
+
+    struct result
+    {
+        double seconds = 0.0;
+        double cpu_seconds = 0.0;
+        long minor_faults = 0;
+        long major_faults = 0;
+    };
+
+    double timeval_seconds(const timeval& tv) {
+        return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+    }
+
+    template<typename TFunc>
+    result measure(const TFunc& func) {
+        rusage before {};
+        rusage after {};
+
+        getrusage(RUSAGE_THREAD, &before);
+        auto start = std::chrono::steady_clock::now();
+        func();
+        auto end = std::chrono::steady_clock::now();
+        getrusage(RUSAGE_THREAD, &after);
+
+        result r;
+        r.seconds      = std::chrono::duration<double>(end - start).count();
+        r.cpu_seconds  = (timeval_seconds(after.ru_utime) + timeval_seconds(after.ru_stime)) -
+                         (timeval_seconds(before.ru_utime) + timeval_seconds(before.ru_stime));
+        r.minor_faults = after.ru_minflt - before.ru_minflt;
+        r.major_faults = after.ru_majflt - before.ru_majflt;
+        return r;
+    }
+
+    void report(const char* name, std::vector<result>& results) {
+        auto first = results.front();
+        std::sort(results.begin(), results.end(), [](const result& a, const result& b) {
+            return a.seconds < b.seconds;
+        });
+
+        const auto& median = results[results.size() / 2];
+        auto mib = static_cast<double>(emblob_get_zerocopy_size()) / (1024.0 * 1024.0);
+        printf("%-24s median: %8.2f MiB/s, cpu: %7.3f ms, first run faults: %ld minor / %ld major\n",
+            name, mib / median.seconds, median.cpu_seconds * 1e3, first.minor_faults,
+            first.major_faults);
+    }
+
+    bool write_all(int fd, const uint8_t* data, size_t len) {
+        while (len > 0) {
+            auto wrote = write(fd, data, std::min(len, CHUNK_SIZE));
+            if (wrote <= 0) {
+                if (wrote == -1 && errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += wrote;
+            len -= static_cast<size_t>(wrote);
+        }
+        return true;
+    }
+
+    bool sendfile_all(int fd) {
+        uint64_t off = 0;
+        while (off < emblob_get_zerocopy_size()) {
+            auto sent = emblob_zerocopy_sendfile(fd, off, CHUNK_SIZE);
+            if (sent <= 0) {
+                if (sent == -1 && errno == EINTR)
+                    continue;
+                return false;
+            }
+            off += static_cast<uint64_t>(sent);
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    if (emblob_zerocopy_file_offset() == -1) {
+        fprintf(stderr, "unable to determine the blob's offset in the executable\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%" PRIu64 " bytes at file offset %lld; %d iterations\n", emblob_get_zerocopy_size(),
+        static_cast<long long>(emblob_zerocopy_file_offset()), ITERATIONS);
+
+    // Socket transfers (the HTTP serving case): a reader thread drains the
+    // other end of the socket pair.
+    int fds[2] = { -1, -1 };
+    if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+        perror("socketpair");
+        return EXIT_FAILURE;
+    }
+
+    std::thread reader([fd = fds[1]]() {
+        std::vector<char> buf(CHUNK_SIZE);
+        while (read(fd, buf.data(), buf.size()) > 0) { }
+    });
+
+    std::vector<result> write_results;
+    std::vector<result> sendfile_results;
+    for (int n = 0; n < ITERATIONS; n++) {
+        write_results.push_back(measure([&]() {
+            if (!write_all(fds[0], emblob_get_zerocopy_8(), emblob_get_zerocopy_size()))
+                perror("write");
+        }));
+        sendfile_results.push_back(measure([&]() {
+            if (!sendfile_all(fds[0]))
+                perror("sendfile");
+        }));
+    }
+
+    close(fds[0]);
+    reader.join();
+    close(fds[1]);
+
+    report("socket: pointer+write", write_results);
+    report("socket: sendfile", sendfile_results);
+
+    // File extraction.
+    char tmpl[] = "/tmp/emblob_zerocopy_XXXXXX";
+    int out_fd = mkstemp(tmpl);
+    if (out_fd == -1) {
+        perror("mkstemp");
+        return EXIT_FAILURE;
+    }
+    unlink(tmpl);
+
+    write_results.clear();
+    std::vector<result> cfr_results;
+    for (int n = 0; n < ITERATIONS; n++) {
+        [[maybe_unused]] auto t1 = ftruncate(out_fd, 0);
+        lseek(out_fd, 0, SEEK_SET);
+        write_results.push_back(measure([&]() {
+            if (!write_all(out_fd, emblob_get_zerocopy_8(), emblob_get_zerocopy_size()))
+                perror("write");
+        }));
+
+        [[maybe_unused]] auto t2 = ftruncate(out_fd, 0);
+        lseek(out_fd, 0, SEEK_SET);
+        cfr_results.push_back(measure([&]() {
+            if (emblob_zerocopy_copy_file_range(out_fd, 0, emblob_get_zerocopy_size()) !=
+                static_cast<ssize_t>(emblob_get_zerocopy_size()))
+                perror("copy_file_range");
+        }));
+    }
+
+    // Make sure the extracted copy is actually identical to the blob.
+    std::vector<uint8_t> extracted(emblob_get_zerocopy_size());
+    if (pread(out_fd, extracted.data(), extracted.size(), 0) != static_cast<ssize_t>(extracted.size()) ||
+        0 != memcmp(extracted.data(), emblob_get_zerocopy_8(), extracted.size())) {
+        fprintf(stderr, "extracted data does not match the embedded blob!\n");
+        close(out_fd);
+        return EXIT_FAILURE;
+    }
+
+    close(out_fd);
+
+    report("file: pointer+write", write_results);
+    report("file: copy_file_range", cfr_results);
+
+    return EXIT_SUCCESS;
+}
@@ -26,11 +26,21 @@
 #ifndef _EMBLOB_HH_INCLUDED
 # define _EMBLOB_HH_INCLUDED
 
+# include <iosfwd>
 # include <string>
 
 namespace emblob
 {
     void delete_file_on_unclean_exit(const std::string& fname);
+    int inject_main(int argc, char** argv);
+    class command_line;
+
+    int run_main(int argc, char** argv, std::ostream& stats_out, const std::string& compiler_path,
+        bool keep_unchanged_header = false);
+    int watch_main(int argc, char** argv);
+    bool check_command_line(int argc, char** argv, command_line* cmd_line, int& exit_code);
+    int serve_main(const std::string& sock, int argc, char** argv);
+    int connect_main(const std::string& sock, int argc, char** argv);
 } // !namespace emblob
 
 #endif // !_EMBLOB_HH_INCLUDED
@@ -26,14 +26,18 @@
 #ifndef _EMBLOB_APPSTATE_HH_INCLUDED
 # define _EMBLOB_APPSTATE_HH_INCLUDED
 
+# include <string>
+# include <vector>
+
 namespace emblob
 {
     class app_state
     {
     public:
         bool created_hdr_file = false;
-        bool created_asm_file = false;
-        bool created_obj_file = false;
+
+        /* the other files left behind by the generator. */
+        std::vector<std::string> created_files;
     };
 } // !namespace emblob
 
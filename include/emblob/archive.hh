@@ -0,0 +1,606 @@
+/*
+ * archive.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_ARCHIVE_HH_INCLUDED
+# define _EMBLOB_ARCHIVE_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+
+# include <fnmatch.h>
+
+# if defined(EMBLOB_HAVE_ZLIB)
+#  include <zlib.h>
+# endif
+
+namespace emblob
+{
+    /* reads the regular files in a tar archive (optionally gzip-compressed)
+     * or a zip archive, without extracting them to disk.
+     *
+     * a tar archive is read in a single pass, through inflate if need be; the
+     * members which aren't wanted are read past, but not kept. a zip archive
+     * is read by way of its central directory, so the members which aren't
+     * wanted are never read at all. members compressed with DEFLATE (and
+     * gzip-compressed tar archives) require zlib. */
+    class archive_reader
+    {
+    public:
+        CONST_STATIC_X(size_t) BLOCK_SIZE = 512;
+        CONST_STATIC_X(size_t) READ_CHUNK = 1024 * 1024;
+
+        /* the most that DEFLATE can expand its input. */
+        CONST_STATIC_X(uint64_t) MAX_DEFLATE_RATIO = 1032;
+
+        /* whether a member (by name) is wanted, and what to do with it. */
+        using filter_func = std::function<bool(const std::string& name)>;
+        using member_func = std::function<bool(const std::string& name, std::string&& data)>;
+
+        archive_reader() = delete;
+        ~archive_reader() = delete;
+
+        /* true if name matches any of patterns (shell wildcards, as in
+         * fnmatch(3), where * also matches /), or if there are none. */
+        static bool matches(const std::string& name, const std::vector<std::string>& patterns) {
+            return patterns.empty() || std::ranges::any_of(patterns, [&name](const std::string& p) {
+                return 0 == fnmatch(p.c_str(), name.c_str(), 0);
+            });
+        }
+
+        static bool read(const std::string& fname, const filter_func& wanted, const member_func& on_member) {
+            std::ifstream strm(fname, std::ios::in | std::ios::binary);
+            if (!strm.is_open()) {
+                g_logger->error("failed to open %s: %s", fname.c_str(), system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            std::array<unsigned char, 4> magic {};
+            strm.read(reinterpret_cast<char*>(magic.data()), magic.size());
+            strm.clear();
+            strm.seekg(0);
+
+            if (magic[0] == 'P' && magic[1] == 'K' && ((magic[2] == 3 && magic[3] == 4) ||
+                (magic[2] == 5 && magic[3] == 6))) {
+                return _read_zip(fname, strm, wanted, on_member);
+            } else if (magic[0] == 0x1f && magic[1] == 0x8b) {
+# if defined(EMBLOB_HAVE_ZLIB)
+                return _read_gzip_tar(fname, strm, wanted, on_member);
+# else
+                g_logger->error("%s is gzip-compressed, which requires zlib", fname.c_str());
+                return false;
+# endif
+            }
+
+            return _read_tar(fname, [&strm](char* buf, size_t len) {
+                strm.read(buf, static_cast<std::streamsize>(len));
+                return strm.bad() ? -1 : static_cast<ssize_t>(strm.gcount());
+            }, static_cast<uint64_t>(system::file_size(fname)), wanted, on_member);
+        }
+
+    private:
+        /* reads up to len bytes, returning the number read, or -1 on error. */
+        using read_func = std::function<ssize_t(char* buf, size_t len)>;
+
+        static bool _read_exact(const read_func& read_fn, char* buf, size_t len) {
+            while (len > 0) {
+                auto got = read_fn(buf, len);
+                if (got <= 0) {
+                    return false;
+                }
+
+                buf += got;
+                len -= static_cast<size_t>(got);
+            }
+
+            return true;
+        }
+
+        /* members are stored under relative names; a leading ./ or / is not
+         * part of the name. */
+        static std::string _normalize(std::string name) {
+            while (name.starts_with("./") || name.starts_with("/")) {
+                name.erase(0, name.starts_with("/") ? 1 : 2);
+            }
+
+            return name;
+        }
+
+        static uint64_t _tar_number(const char* field, size_t len) {
+            /* GNU base-256, for sizes that don't fit in octal. */
+            if (static_cast<unsigned char>(field[0]) & 0x80) {
+                uint64_t value = static_cast<unsigned char>(field[0]) & 0x7f;
+                for (size_t n = 1; n < len; n++) {
+                    value = (value << 8) | static_cast<unsigned char>(field[n]);
+                }
+
+                return value;
+            }
+
+            uint64_t value = 0;
+            for (size_t n = 0; n < len && field[n] != '\0'; n++) {
+                if (field[n] >= '0' && field[n] <= '7') {
+                    value = (value << 3) | static_cast<uint64_t>(field[n] - '0');
+                }
+            }
+
+            return value;
+        }
+
+        static bool _tar_checksum_ok(const char* block) {
+            uint64_t sum = 0;
+            for (size_t n = 0; n < BLOCK_SIZE; n++) {
+                sum += (n >= 148 && n < 156) ? ' ' : static_cast<unsigned char>(block[n]);
+            }
+
+            return sum == _tar_number(block + 148, 8);
+        }
+
+        static std::string _tar_string(const char* field, size_t len) {
+            return std::string(field, strnlen(field, len));
+        }
+
+        /* input_size is the size of the (uncompressed) archive, if it is known;
+         * no size read from a header is believed if it exceeds what is left. */
+        static bool _read_tar(const std::string& fname, const read_func& raw_read_fn, uint64_t input_size,
+            const filter_func& wanted, const member_func& on_member) {
+            std::array<char, BLOCK_SIZE> block {};
+            std::string long_name;
+            uint64_t pax_size = 0;
+            bool has_pax_size = false;
+            size_t count = 0;
+
+            uint64_t consumed = 0;
+            auto read_fn = [&raw_read_fn, &consumed](char* buf, size_t len) {
+                auto got = raw_read_fn(buf, len);
+                consumed += got > 0 ? static_cast<uint64_t>(got) : 0;
+                return got;
+            };
+
+            for (;;) {
+                if (!_read_exact(read_fn, block.data(), block.size())) {
+                    g_logger->error("%s: unexpected end of archive", fname.c_str());
+                    return false;
+                }
+
+                if (std::ranges::all_of(block, [](char c) { return c == '\0'; })) {
+                    break;
+                }
+
+                if (!_tar_checksum_ok(block.data())) {
+                    g_logger->error("%s is not a tar, gzip-compressed tar, or zip archive", fname.c_str());
+                    return false;
+                }
+
+                auto name = _tar_string(block.data(), 100);
+                if (0 == memcmp(block.data() + 257, "ustar", 5) && block[345] != '\0') {
+                    name = _tar_string(block.data() + 345, 155) + "/" + name;
+                }
+
+                char type = block[156];
+                uint64_t size = _tar_number(block.data() + 124, 12);
+                if (has_pax_size && (type == '0' || type == '\0' || type == '7')) {
+                    size = pax_size;
+                }
+
+                bool regular = type == '0' || type == '\0' || type == '7';
+                bool meta = type == 'L' || type == 'x';
+                if (regular && !long_name.empty()) {
+                    name = long_name;
+                }
+
+                name = _normalize(name);
+                bool keep = meta || (regular && !name.empty() && !name.ends_with("/") && wanted(name));
+
+                if (size > input_size - consumed || size > UINT64_MAX - BLOCK_SIZE) {
+                    g_logger->error("%s: unexpected end of archive", fname.c_str());
+                    return false;
+                }
+
+                /* the data is read in full only if it is kept (in pieces, so
+                 * that no more is allocated than the archive actually holds);
+                 * it is always followed by padding, to the end of its last
+                 * block. */
+                std::string data;
+                uint64_t padded = (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+                if (keep) {
+                    while (data.size() < size) {
+                        auto at  = data.size();
+                        auto len = static_cast<size_t>(std::min<uint64_t>(size - at, READ_CHUNK));
+                        data.resize(at + len);
+                        if (!_read_exact(read_fn, data.data() + at, len)) {
+                            g_logger->error("%s: unexpected end of archive", fname.c_str());
+                            return false;
+                        }
+                    }
+
+                    padded -= size;
+                }
+
+                std::vector<char> skip(std::min<uint64_t>(padded, READ_CHUNK));
+                while (padded > 0) {
+                    auto len = static_cast<size_t>(std::min<uint64_t>(padded, skip.size()));
+                    if (!_read_exact(read_fn, skip.data(), len)) {
+                        g_logger->error("%s: unexpected end of archive", fname.c_str());
+                        return false;
+                    }
+
+                    padded -= len;
+                }
+
+                if (type == 'L') {
+                    long_name = _tar_string(data.data(), data.size());
+                    continue;
+                } else if (type == 'x') {
+                    _parse_pax(data, long_name, pax_size, has_pax_size);
+                    continue;
+                }
+
+                /* GNU long names and pax headers describe the next entry only. */
+                long_name.clear();
+                has_pax_size = false;
+
+                if (keep) {
+                    count++;
+                    if (!on_member(name, std::move(data))) {
+                        return false;
+                    }
+                }
+            }
+
+            g_logger->debug("read %zu members from %s", count, fname.c_str());
+            return true;
+        }
+
+        /* records of the form "<length> <key>=<value>\n". */
+        static void _parse_pax(const std::string& data, std::string& path, uint64_t& size, bool& has_size) {
+            for (size_t pos = 0; pos < data.size();) {
+                auto space = data.find(' ', pos);
+                if (space == std::string::npos) {
+                    break;
+                }
+
+                auto len = static_cast<size_t>(strtoull(data.c_str() + pos, nullptr, 10));
+                if (len == 0 || pos + len > data.size()) {
+                    break;
+                }
+
+                auto record = data.substr(space + 1, pos + len - space - 2);
+                if (record.starts_with("path=")) {
+                    path = record.substr(5);
+                } else if (record.starts_with("size=")) {
+                    size = strtoull(record.c_str() + 5, nullptr, 10);
+                    has_size = true;
+                }
+
+                pos += len;
+            }
+        }
+
+# if defined(EMBLOB_HAVE_ZLIB)
+        static bool _read_gzip_tar(const std::string& fname, std::ifstream& strm, const filter_func& wanted,
+            const member_func& on_member) {
+            z_stream zs {};
+            if (Z_OK != inflateInit2(&zs, 15 + 32)) {
+                g_logger->error("inflateInit2 failed: %s", zs.msg ? zs.msg : "unknown error");
+                return false;
+            }
+
+            std::vector<char> in(READ_CHUNK);
+            bool finished = false;
+            bool failed = false;
+
+            /* at most READ_CHUNK bytes at a time, so that the length fits in
+             * a uInt. */
+            auto read_fn = [&](char* buf, size_t len) -> ssize_t {
+                len = std::min(len, READ_CHUNK);
+                zs.next_out  = reinterpret_cast<Bytef*>(buf);
+                zs.avail_out = static_cast<uInt>(len);
+                while (zs.avail_out == len && !finished) {
+                    if (zs.avail_in == 0) {
+                        strm.read(in.data(), static_cast<std::streamsize>(in.size()));
+                        if (strm.bad() || strm.gcount() == 0) {
+                            failed = true;
+                            return -1;
+                        }
+
+                        zs.next_in  = reinterpret_cast<Bytef*>(in.data());
+                        zs.avail_in = static_cast<uInt>(strm.gcount());
+                    }
+
+                    auto ret = inflate(&zs, Z_NO_FLUSH);
+                    if (ret == Z_STREAM_END) {
+                        finished = true;
+                    } else if (ret != Z_OK) {
+                        failed = true;
+                        return -1;
+                    }
+                }
+
+                return static_cast<ssize_t>(len - zs.avail_out);
+            };
+
+            bool ok = _read_tar(fname, read_fn, UINT64_MAX, wanted, on_member);
+            if (failed) {
+                g_logger->error("failed to decompress %s: %s", fname.c_str(), zs.msg ? zs.msg : "truncated");
+            }
+
+            inflateEnd(&zs);
+            return ok && !failed;
+        }
+# endif
+
+        static uint64_t _le(const char* p, size_t len) {
+            uint64_t value = 0;
+            for (size_t n = len; n > 0; n--) {
+                value = (value << 8) | static_cast<unsigned char>(p[n - 1]);
+            }
+
+            return value;
+        }
+
+        static bool _read_at(std::ifstream& strm, uint64_t offset, char* buf, size_t len) {
+            strm.clear();
+            strm.seekg(static_cast<std::streamoff>(offset));
+            strm.read(buf, static_cast<std::streamsize>(len));
+            return static_cast<size_t>(strm.gcount()) == len;
+        }
+
+        static bool _read_zip(const std::string& fname, std::ifstream& strm, const filter_func& wanted,
+            const member_func& on_member) {
+            constexpr uint32_t EOCD_SIG = 0x06054b50, EOCD64_SIG = 0x06064b50, LOCATOR_SIG = 0x07064b50,
+                CENTRAL_SIG = 0x02014b50, LOCAL_SIG = 0x04034b50;
+            constexpr size_t EOCD_SIZE = 22, LOCATOR_SIZE = 20, EOCD64_SIZE = 56, CENTRAL_SIZE = 46,
+                LOCAL_SIZE = 30;
+
+            auto bad = [&fname](const char* what) {
+                g_logger->error("%s is not a valid zip archive (%s)", fname.c_str(), what);
+                return false;
+            };
+
+            /* the end of central directory record is followed by a comment of
+             * up to 64 KiB. */
+            auto file_size = static_cast<uint64_t>(system::file_size(fname));
+            auto tail_size = static_cast<size_t>(std::min<uint64_t>(file_size, EOCD_SIZE + 65535));
+            std::string tail(tail_size, '\0');
+            if (!_read_at(strm, file_size - tail_size, tail.data(), tail_size)) {
+                return bad("truncated");
+            }
+
+            size_t eocd = std::string::npos;
+            for (size_t n = tail_size >= EOCD_SIZE ? tail_size - EOCD_SIZE + 1 : 0; n-- > 0;) {
+                if (_le(tail.data() + n, 4) == EOCD_SIG) {
+                    eocd = n;
+                    break;
+                }
+            }
+
+            if (eocd == std::string::npos) {
+                return bad("no end of central directory record");
+            }
+
+            uint64_t entries   = _le(tail.data() + eocd + 10, 2);
+            uint64_t cd_size   = _le(tail.data() + eocd + 12, 4);
+            uint64_t cd_offset = _le(tail.data() + eocd + 16, 4);
+
+            if (entries == 0xffff || cd_size == 0xffffffff || cd_offset == 0xffffffff) {
+                uint64_t eocd_offset = file_size - tail_size + eocd;
+                std::array<char, EOCD64_SIZE> rec {};
+                if (eocd_offset < LOCATOR_SIZE || !_read_at(strm, eocd_offset - LOCATOR_SIZE, rec.data(),
+                    LOCATOR_SIZE) || _le(rec.data(), 4) != LOCATOR_SIG) {
+                    return bad("no zip64 end of central directory locator");
+                }
+
+                if (!_read_at(strm, _le(rec.data() + 8, 8), rec.data(), rec.size()) ||
+                    _le(rec.data(), 4) != EOCD64_SIG) {
+                    return bad("no zip64 end of central directory record");
+                }
+
+                entries   = _le(rec.data() + 32, 8);
+                cd_size   = _le(rec.data() + 40, 8);
+                cd_offset = _le(rec.data() + 48, 8);
+            }
+
+            if (cd_offset > file_size || cd_size > file_size - cd_offset) {
+                return bad("truncated central directory");
+            }
+
+            std::string cd(cd_size, '\0');
+            if (!_read_at(strm, cd_offset, cd.data(), cd.size())) {
+                return bad("truncated central directory");
+            }
+
+            size_t count = 0;
+            for (size_t pos = 0, n = 0; n < entries; n++) {
+                if (pos + CENTRAL_SIZE > cd.size() || _le(cd.data() + pos, 4) != CENTRAL_SIG) {
+                    return bad("corrupt central directory");
+                }
+
+                const char* e   = cd.data() + pos;
+                auto flags      = _le(e + 8, 2);
+                auto method     = _le(e + 10, 2);
+                uint64_t crc    = _le(e + 16, 4);
+                uint64_t csize  = _le(e + 20, 4);
+                uint64_t usize  = _le(e + 24, 4);
+                auto name_len   = static_cast<size_t>(_le(e + 28, 2));
+                auto extra_len  = static_cast<size_t>(_le(e + 30, 2));
+                auto cmt_len    = static_cast<size_t>(_le(e + 32, 2));
+                uint64_t offset = _le(e + 42, 4);
+
+                if (pos + CENTRAL_SIZE + name_len + extra_len + cmt_len > cd.size()) {
+                    return bad("corrupt central directory");
+                }
+
+                auto name = _normalize(std::string(e + CENTRAL_SIZE, name_len));
+
+                /* the zip64 extended information field holds (in this order)
+                 * whichever of the sizes and offset didn't fit. */
+                for (size_t x = 0; x + 4 <= extra_len;) {
+                    const char* field = e + CENTRAL_SIZE + name_len + x;
+                    auto id  = _le(field, 2);
+                    auto len = static_cast<size_t>(_le(field + 2, 2));
+                    if (id == 0x0001) {
+                        size_t at = 4;
+                        for (auto* value : { &usize, &csize, &offset }) {
+                            if (*value == 0xffffffff && at + 8 <= len + 4) {
+                                *value = _le(field + at, 8);
+                                at += 8;
+                            }
+                        }
+                    }
+
+                    x += 4 + len;
+                }
+
+                pos += CENTRAL_SIZE + name_len + extra_len + cmt_len;
+
+                if (name.empty() || name.ends_with("/") || !wanted(name)) {
+                    continue;
+                }
+
+                if (flags & 1) {
+                    g_logger->error("%s: %s is encrypted", fname.c_str(), name.c_str());
+                    return false;
+                }
+
+                std::array<char, LOCAL_SIZE> local {};
+                if (offset > file_size || !_read_at(strm, offset, local.data(), local.size()) ||
+                    _le(local.data(), 4) != LOCAL_SIG) {
+                    return bad("corrupt local file header");
+                }
+
+                /* DEFLATE cannot expand anything by more than MAX_DEFLATE_RATIO:1,
+                 * and stored members are the same size either way. */
+                uint64_t data_offset = offset + LOCAL_SIZE + _le(local.data() + 26, 2) + _le(local.data() + 28, 2);
+                if (data_offset > file_size || csize > file_size - data_offset) {
+                    return bad("truncated member");
+                } else if ((method == 0 && usize != csize) || (method == 8 && usize / MAX_DEFLATE_RATIO > csize)) {
+                    return bad("member size mismatch");
+                }
+
+                std::string packed(csize, '\0');
+                if (!_read_at(strm, data_offset, packed.data(), packed.size())) {
+                    return bad("truncated member");
+                }
+
+                std::string data;
+                if (method == 0) {
+                    data = std::move(packed);
+                } else if (method == 8) {
+# if defined(EMBLOB_HAVE_ZLIB)
+                    if (!_inflate_raw(packed, usize, data)) {
+                        g_logger->error("%s: failed to decompress %s", fname.c_str(), name.c_str());
+                        return false;
+                    }
+# else
+                    g_logger->error("%s: %s is compressed with DEFLATE, which requires zlib", fname.c_str(),
+                        name.c_str());
+                    return false;
+# endif
+                } else {
+                    g_logger->error("%s: %s uses an unsupported compression method (%" PRIu64 ")",
+                        fname.c_str(), name.c_str(), method);
+                    return false;
+                }
+
+                if (data.size() != usize) {
+                    return bad("member size mismatch");
+                }
+
+# if defined(EMBLOB_HAVE_ZLIB)
+                if (crc != _crc32(data)) {
+                    g_logger->error("%s: %s is corrupt (CRC mismatch)", fname.c_str(), name.c_str());
+                    return false;
+                }
+# else
+                (void)crc;
+# endif
+
+                count++;
+                if (!on_member(name, std::move(data))) {
+                    return false;
+                }
+            }
+
+            g_logger->debug("read %zu members from %s", count, fname.c_str());
+            return true;
+        }
+
+# if defined(EMBLOB_HAVE_ZLIB)
+        /* zlib's lengths are uInts, so anything larger is fed to it (and read
+         * back from it) READ_CHUNK bytes at a time. */
+        static uint64_t _crc32(const std::string& data) {
+            uLong crc = ::crc32(0, nullptr, 0);
+            for (size_t pos = 0; pos < data.size(); pos += READ_CHUNK) {
+                auto len = std::min(data.size() - pos, READ_CHUNK);
+                crc = ::crc32(crc, reinterpret_cast<const Bytef*>(data.data() + pos), static_cast<uInt>(len));
+            }
+
+            return crc;
+        }
+
+        static bool _inflate_raw(const std::string& in, uint64_t size, std::string& out) {
+            out.clear();
+            if (size == 0) {
+                return true;
+            }
+
+            z_stream zs {};
+            if (Z_OK != inflateInit2(&zs, -15)) {
+                return false;
+            }
+
+            /* the output grows only as fast as inflate fills it; once it is
+             * full, any more output is an error. */
+            size_t in_pos = 0;
+            size_t at = 0;
+            int ret = Z_OK;
+            while (ret == Z_OK) {
+                if (zs.avail_in == 0 && in_pos < in.size()) {
+                    auto len = std::min(in.size() - in_pos, READ_CHUNK);
+                    zs.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(in.data() + in_pos));
+                    zs.avail_in = static_cast<uInt>(len);
+                    in_pos += len;
+                }
+
+                if (at == out.size() && at < size) {
+                    out.resize(static_cast<size_t>(std::min<uint64_t>(size, at + READ_CHUNK)));
+                }
+
+                zs.next_out  = reinterpret_cast<Bytef*>(out.data() + at);
+                zs.avail_out = static_cast<uInt>(out.size() - at);
+                ret = inflate(&zs, Z_NO_FLUSH);
+                at = static_cast<size_t>(reinterpret_cast<char*>(zs.next_out) - out.data());
+            }
+
+            out.resize(at);
+            inflateEnd(&zs);
+            return ret == Z_STREAM_END;
+        }
+# endif
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_ARCHIVE_HH_INCLUDED
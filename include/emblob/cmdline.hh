@@ -29,6 +29,9 @@
 # include "emblob/util.hh"
 # include "emblob/logger.hh"
 # include "emblob/system.hh"
+# include "emblob/element.hh"
+# include "emblob/filter.hh"
+# include "emblob/http.hh"
 # include "emblob/version.hh"
 # include "emblob/ansimacros.h"
 
@@ -39,6 +42,7 @@ namespace emblob
     public:
         CONST_STATIC_STRING EXT_ASM = ".S";
         CONST_STATIC_STRING EXT_OBJ = ".o";
+        CONST_STATIC_STRING EXT_PAYLOAD = ".payload";
 
         CONST_STATIC_STRING FLAG_INPUT_FILE = "--infile";
         CONST_STATIC_STRING S_FLAG_INPUT_FILE = "-i";
@@ -46,6 +50,81 @@ namespace emblob
         CONST_STATIC_STRING FLAG_OUTPUT_FILE = "--outfile";
         CONST_STATIC_STRING S_FLAG_OUTPUT_FILE = "-o";
 
+        CONST_STATIC_STRING FLAG_ZERO_COPY = "--zero-copy";
+        CONST_STATIC_STRING S_FLAG_ZERO_COPY = "-z";
+
+        CONST_STATIC_STRING FLAG_PAGING = "--paging";
+        CONST_STATIC_STRING S_FLAG_PAGING = "-p";
+
+        CONST_STATIC_STRING FLAG_INDEX = "--index";
+        CONST_STATIC_STRING S_FLAG_INDEX = "-x";
+
+        CONST_STATIC_STRING FLAG_DELIMITER = "--delimiter";
+        CONST_STATIC_STRING S_FLAG_DELIMITER = "";
+
+        CONST_STATIC_STRING INDEX_NONE = "none";
+        CONST_STATIC_STRING INDEX_LINES = "lines";
+
+        CONST_STATIC_STRING FLAG_ELEMENT = "--element";
+        CONST_STATIC_STRING S_FLAG_ELEMENT = "-e";
+
+        CONST_STATIC_STRING FLAG_SOURCE_ENDIAN = "--source-endian";
+        CONST_STATIC_STRING S_FLAG_SOURCE_ENDIAN = "";
+
+        CONST_STATIC_STRING FLAG_COMPRESS = "--compress";
+        CONST_STATIC_STRING S_FLAG_COMPRESS = "-c";
+
+        CONST_STATIC_STRING COMPRESS_NONE = "none";
+        CONST_STATIC_STRING COMPRESS_DEFLATE = "deflate";
+
+        CONST_STATIC_STRING FLAG_HTTP = "--http";
+        CONST_STATIC_STRING S_FLAG_HTTP = "";
+
+        CONST_STATIC_STRING FLAG_ARCHIVE = "--archive";
+        CONST_STATIC_STRING S_FLAG_ARCHIVE = "-a";
+
+        CONST_STATIC_STRING FLAG_MEMBERS = "--members";
+        CONST_STATIC_STRING S_FLAG_MEMBERS = "";
+
+        CONST_STATIC_STRING FLAG_INJECTED = "--injected";
+        CONST_STATIC_STRING S_FLAG_INJECTED = "";
+
+        CONST_STATIC_STRING FLAG_PACK = "--pack";
+        CONST_STATIC_STRING S_FLAG_PACK = "";
+
+        CONST_STATIC_STRING FLAG_REGISTRY = "--registry";
+        CONST_STATIC_STRING S_FLAG_REGISTRY = "-r";
+
+        CONST_STATIC_STRING FLAG_PROFILE = "--profile";
+        CONST_STATIC_STRING S_FLAG_PROFILE = "";
+
+        CONST_STATIC_STRING FLAG_SPARSE = "--sparse";
+        CONST_STATIC_STRING S_FLAG_SPARSE = "-s";
+
+        CONST_STATIC_STRING FLAG_JSON_TAPE = "--json-tape";
+        CONST_STATIC_STRING S_FLAG_JSON_TAPE = "-j";
+
+        CONST_STATIC_STRING FLAG_FILTER = "--filter";
+        CONST_STATIC_STRING S_FLAG_FILTER = "-f";
+
+        CONST_STATIC_STRING FLAG_TRACE = "--trace";
+        CONST_STATIC_STRING S_FLAG_TRACE = "";
+
+        CONST_STATIC_STRING FLAG_STATS = "--stats";
+        CONST_STATIC_STRING S_FLAG_STATS = "";
+
+        CONST_STATIC_STRING FLAG_WATCH = "--watch";
+        CONST_STATIC_STRING S_FLAG_WATCH = "-w";
+
+        CONST_STATIC_STRING FLAG_SERVE = "--serve";
+        CONST_STATIC_STRING S_FLAG_SERVE = "";
+
+        CONST_STATIC_STRING FLAG_CONNECT = "--connect";
+        CONST_STATIC_STRING S_FLAG_CONNECT = "";
+
+        CONST_STATIC_STRING STATS_NONE = "none";
+        CONST_STATIC_STRING STATS_JSON = "json";
+
         CONST_STATIC_STRING FLAG_LOG_LEVEL = "--log-level";
         CONST_STATIC_STRING S_FLAG_LOG_LEVEL = "-l";
 
@@ -55,16 +134,71 @@ namespace emblob
         CONST_STATIC_STRING FLAG_HELP = "--help";
         CONST_STATIC_STRING S_FLAG_HELP = "-h";
 
-        CONST_STATIC_X(size_t) LONGEST_FLAG = 11;
+        CONST_STATIC_X(size_t) LONGEST_FLAG = 15;
         CONST_STATIC_X(size_t) LONGEST_SHORT_FLAG = 2;
 
+        /* emblob inject <executable> [name=]file... */
+        CONST_STATIC_STRING CMD_INJECT = "inject";
+
         command_line() = default;
 
+        /* the value given for a long flag, ahead of parsing (e.g. for options
+         * which affect how parsing itself is reported). */
+        static std::string peek_value(int argc, char** argv, const std::string& flag) {
+            for (int i = 1; i < argc; i++) {
+                std::string_view arg = argv[i];
+                if (arg == flag && i + 1 < argc) {
+                    return argv[i + 1];
+                } else if (arg.starts_with(flag + "=")) {
+                    return std::string(arg.substr(flag.size() + 1));
+                }
+            }
+
+            return {};
+        }
+
+        /* whether a flag which takes no value was given, ahead of parsing. */
+        static bool peek_flag(int argc, char** argv, const std::string& flag, const std::string& short_flag) {
+            for (int i = 1; i < argc; i++) {
+                if (std::string_view arg = argv[i]; arg == flag || (!short_flag.empty() && arg == short_flag)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        static bool is_inject_command(int argc, char** argv) {
+            return argc > 1 && std::string_view(argv[1]) == CMD_INJECT;
+        }
+
+        static int print_inject_usage() {
+            std::cerr << std::endl << ESC_SEQ("1", "") << APP_NAME << " " << CMD_INJECT << " usage:"
+                << ESC_RST << std::endl;
+            std::cerr << "\t" << APP_NAME << " " << CMD_INJECT << " <executable> [name=]file..."
+                << std::endl << std::endl;
+            std::cerr << "\tAdds each file to <executable> (replacing any blobs injected previously),"
+                << std::endl << "\tfor blobs generated with " << FLAG_INJECTED << ". A blob is named"
+                << " after its file's" << std::endl << "\tbasename, unless a name is given." << std::endl;
+            std::cerr << std::endl;
+
+            return EXIT_FAILURE;
+        }
+
         int parse_and_validate(int argc, char** argv, int& exit_code) {
             bool retval = true;
             for (int i = 1; i < argc; i++) {
                 std::string input = argv[i];
 
+                /* long flags may also be given in the form --flag=value. */
+                std::string inline_value;
+                bool has_inline_value = false;
+                if (auto eq = input.find('='); input.starts_with("--") && eq != std::string::npos) {
+                    inline_value = input.substr(eq + 1);
+                    input.resize(eq);
+                    has_inline_value = true;
+                }
+
                 config::arg *a = nullptr;
                 if (!_config.get_arg(input, &a)) {
                     g_logger->error("unknown option: '%s'", input.c_str());
@@ -86,21 +220,30 @@ namespace emblob
                 a->seen = true;
 
                 if (a->value_required) {
-                    if (i + 1 > argc - 1) {
+                    if (!has_inline_value && i + 1 > argc - 1) {
                         g_logger->error("missing value for '%s'", input.c_str());
                         retval = false;
                         break;
                     }
 
-                    if (std::string validate_msg; a->validator && !a->validator(argv[i + 1], validate_msg)) {
-                        g_logger->error("'%s' is not a valid value for '%s' (%s)", argv[i + 1],  input.c_str(),
+                    std::string value = has_inline_value ? inline_value : argv[i + 1];
+                    if (std::string validate_msg; a->validator && !a->validator(value, validate_msg)) {
+                        g_logger->error("'%s' is not a valid value for '%s' (%s)", value.c_str(),  input.c_str(),
                             validate_msg.c_str());
                         retval = false;
                         break;
                     }
 
-                    a->value = argv[i++ + 1];
+                    if (!has_inline_value) {
+                        i++;
+                    }
+
+                    a->value = value;
                     a->validated = true;
+                } else if (has_inline_value) {
+                    g_logger->error("'%s' does not take a value", input.c_str());
+                    retval = false;
+                    break;
                 }
             }
 
@@ -116,6 +259,12 @@ namespace emblob
                 });
             }
 
+            if (retval && get_input_is_stream() && !_config.is_set(FLAG_OUTPUT_FILE)) {
+                g_logger->error("'%s/%s' is required when the input is a stream", S_FLAG_OUTPUT_FILE,
+                    FLAG_OUTPUT_FILE);
+                retval = false;
+            }
+
             exit_code = retval ? EXIT_SUCCESS : print_usage();
             return retval;
         }
@@ -149,16 +298,20 @@ namespace emblob
             return _config.get_value(FLAG_INPUT_FILE);
         }
 
+        bool get_input_is_stream() const {
+            return system::is_stream(get_input_filename());
+        }
+
+        /* a stream has no name of its own, so it takes that of the output. */
         std::string get_input_basename() const {
-            auto base_name = system::file_base_name(get_input_filename());
+            auto base_name = system::file_base_name(get_input_is_stream() ?
+                _config.get_value(FLAG_OUTPUT_FILE) : get_input_filename());
             return system::sanitize_base_name(base_name);
         }
 
         std::string get_hdr_output_filename() const {
-            auto fname =
-            system::file_base_name(get_input_filename());
-            return fmt_str("%s_%s.h", APP_NAME,
-                system::sanitize_base_name(fname).c_str());
+            auto fname = get_input_basename();
+            return fmt_str("%s_%s.h", APP_NAME, fname.c_str());
         }
 
         std::string get_asm_output_filename() const {
@@ -169,6 +322,100 @@ namespace emblob
             return _get_output_filename(EXT_OBJ);
         }
 
+        std::string get_payload_output_filename() const {
+            return _get_output_filename(EXT_PAYLOAD);
+        }
+
+        bool get_zero_copy() const {
+            return _config.is_set(FLAG_ZERO_COPY);
+        }
+
+        bool get_paging() const {
+            return _config.is_set(FLAG_PAGING);
+        }
+
+        bool get_index_lines() const {
+            return _config.get_value(FLAG_INDEX) == INDEX_LINES;
+        }
+
+        char get_delimiter() const {
+            char delim = '\n';
+            [[maybe_unused]] bool parsed = _parse_delimiter(_config.get_value(FLAG_DELIMITER), delim);
+            return delim;
+        }
+
+        element::type get_element_type() const {
+            return element::type_from_string(_config.get_value(FLAG_ELEMENT));
+        }
+
+        std::string get_source_endian() const {
+            return _config.get_value(FLAG_SOURCE_ENDIAN);
+        }
+
+        bool is_directory_input() const {
+            return system::is_directory(get_input_filename());
+        }
+
+        bool get_compress_deflate() const {
+            return _config.get_value(FLAG_COMPRESS) == COMPRESS_DEFLATE;
+        }
+
+        bool get_http() const {
+            return _config.is_set(FLAG_HTTP);
+        }
+
+        std::vector<std::string> get_http_encodings() const {
+            return filter_chain::split_names(_config.get_value(FLAG_HTTP));
+        }
+
+        bool get_archive() const {
+            return _config.is_set(FLAG_ARCHIVE);
+        }
+
+        std::vector<std::string> get_archive_members() const {
+            return filter_chain::split_names(_config.get_value(FLAG_MEMBERS));
+        }
+
+        bool get_injected() const {
+            return _config.is_set(FLAG_INJECTED);
+        }
+
+        bool get_pack() const {
+            return _config.is_set(FLAG_PACK);
+        }
+
+        std::string get_pack_filename() const {
+            return _config.get_value(FLAG_PACK);
+        }
+
+        bool get_registry() const {
+            return _config.is_set(FLAG_REGISTRY);
+        }
+
+        bool get_profile() const {
+            return _config.is_set(FLAG_PROFILE);
+        }
+
+        bool get_sparse() const {
+            return _config.is_set(FLAG_SPARSE);
+        }
+
+        bool get_json_tape() const {
+            return _config.is_set(FLAG_JSON_TAPE);
+        }
+
+        std::vector<std::string> get_filters() const {
+            return filter_chain::split_names(_config.get_value(FLAG_FILTER));
+        }
+
+        std::string get_trace_filename() const {
+            return _config.get_value(FLAG_TRACE);
+        }
+
+        bool get_stats_json() const {
+            return _config.get_value(FLAG_STATS) == STATS_JSON;
+        }
+
         logger::level get_log_level() const {
             return logger::level_from_string(_config.get_value(FLAG_LOG_LEVEL));
         }
@@ -300,6 +547,16 @@ namespace emblob
                     return std::string();
                 }
 
+                bool is_set(const std::string_view& flag) const {
+                    for (const auto& a : args) {
+                        if (a.flag == flag || a.short_flag == flag) {
+                            return a.seen;
+                        }
+                    }
+
+                    return false;
+                }
+
                 std::vector<arg> args = {
                     {
                         FLAG_INPUT_FILE,
@@ -331,6 +588,356 @@ namespace emblob
                         false,
                         &_output_filename_validator
                     },
+                    {
+                        FLAG_ZERO_COPY,
+                        S_FLAG_ZERO_COPY,
+                        "Generate zero-copy I/O functions",
+                        "",
+                        "",
+                        "",
+                        "sendfile/copy_file_range; Linux only",
+                        {},
+                        false,
+                        false,
+                        false,
+                        false,
+                        nullptr
+                    },
+                    {
+                        FLAG_PAGING,
+                        S_FLAG_PAGING,
+                        "Generate paging functions",
+                        "",
+                        "",
+                        "",
+                        "madvise, mlock, and background warm-up",
+                        {},
+                        false,
+                        false,
+                        false,
+                        false,
+                        nullptr
+                    },
+                    {
+                        FLAG_INDEX,
+                        S_FLAG_INDEX,
+                        "Generate a record index",
+                        "",
+                        INDEX_NONE,
+                        "kind",
+                        "",
+                        {
+                            INDEX_NONE,
+                            INDEX_LINES
+                        },
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_index_validator
+                    },
+                    {
+                        FLAG_DELIMITER,
+                        S_FLAG_DELIMITER,
+                        "Record delimiter for --index",
+                        "",
+                        "\\n",
+                        "char",
+                        "a character, or \\n, \\r, \\t, \\0, or \\xHH",
+                        {},
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_delimiter_validator
+                    },
+                    {
+                        FLAG_ELEMENT,
+                        S_FLAG_ELEMENT,
+                        "Element type of a numeric blob",
+                        "",
+                        element::TYPE_NONE,
+                        "type",
+                        "",
+                        {
+                            element::TYPE_NONE,
+                            element::TYPE_U16,
+                            element::TYPE_U32,
+                            element::TYPE_U64,
+                            element::TYPE_F32,
+                            element::TYPE_F64
+                        },
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_element_validator
+                    },
+                    {
+                        FLAG_SOURCE_ENDIAN,
+                        S_FLAG_SOURCE_ENDIAN,
+                        "Byte order of the input's elements",
+                        "",
+                        element::ENDIAN_NATIVE,
+                        "order",
+                        "converted to native at generation time",
+                        {
+                            element::ENDIAN_NATIVE,
+                            element::ENDIAN_BIG,
+                            element::ENDIAN_LITTLE
+                        },
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_source_endian_validator
+                    },
+                    {
+                        FLAG_COMPRESS,
+                        S_FLAG_COMPRESS,
+                        "Compress the members of a directory",
+                        "",
+                        COMPRESS_NONE,
+                        "codec",
+                        "with a dictionary trained on them",
+                        {
+                            COMPRESS_NONE,
+                            COMPRESS_DEFLATE
+                        },
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_compress_validator
+                    },
+                    {
+                        FLAG_HTTP,
+                        S_FLAG_HTTP,
+                        "Record HTTP metadata for the members of a directory",
+                        "",
+                        "",
+                        "list",
+                        "MIME type, ETag, and precompressed variants in the listed codings",
+                        http::available_encodings(),
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_http_validator
+                    },
+                    {
+                        FLAG_ARCHIVE,
+                        S_FLAG_ARCHIVE,
+                        "Embed the members of an archive, as if it were a directory",
+                        "",
+                        "",
+                        "",
+                        "tar, gzip-compressed tar, or zip; read without extracting it",
+                        {},
+                        false,
+                        false,
+                        false,
+                        false,
+                        nullptr
+                    },
+                    {
+                        FLAG_MEMBERS,
+                        S_FLAG_MEMBERS,
+                        "Embed only the members of an archive that match",
+                        "",
+                        "",
+                        "list",
+                        "comma-separated wildcard patterns, e.g. 'img/*.png,*.json'",
+                        {},
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_members_validator
+                    },
+                    {
+                        FLAG_INJECTED,
+                        S_FLAG_INJECTED,
+                        "Resolve the blob at runtime from an executable",
+                        "",
+                        "",
+                        "",
+                        "into which it is added with 'emblob inject'",
+                        {},
+                        false,
+                        false,
+                        false,
+                        false,
+                        nullptr
+                    },
+                    {
+                        FLAG_PACK,
+                        S_FLAG_PACK,
+                        "Write the blob to a separate pack file",
+                        "",
+                        "",
+                        "file",
+                        "mapped at runtime instead of being linked in",
+                        {},
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_pack_validator
+                    },
+                    {
+                        FLAG_REGISTRY,
+                        S_FLAG_REGISTRY,
+                        "Add the blob to the link-time registry",
+                        "",
+                        "",
+                        "",
+                        "enumerable and searchable by name",
+                        {},
+                        false,
+                        false,
+                        false,
+                        false,
+                        nullptr
+                    },
+                    {
+                        FLAG_PROFILE,
+                        S_FLAG_PROFILE,
+                        "Count calls of the accessor and lookup functions",
+                        "",
+                        "",
+                        "",
+                        "per blob and per member, with the time of the first",
+                        {},
+                        false,
+                        false,
+                        false,
+                        false,
+                        nullptr
+                    },
+                    {
+                        FLAG_SPARSE,
+                        S_FLAG_SPARSE,
+                        "Elide long runs of zero bytes",
+                        "",
+                        "",
+                        "",
+                        "reconstructed at runtime",
+                        {},
+                        false,
+                        false,
+                        false,
+                        false,
+                        nullptr
+                    },
+                    {
+                        FLAG_JSON_TAPE,
+                        S_FLAG_JSON_TAPE,
+                        "Embed a pre-parsed JSON document",
+                        "",
+                        "",
+                        "",
+                        "validated at generation time",
+                        {},
+                        false,
+                        false,
+                        false,
+                        false,
+                        nullptr
+                    },
+                    {
+                        FLAG_FILTER,
+                        S_FLAG_FILTER,
+                        "Transform the input before embedding",
+                        "",
+                        "",
+                        "list",
+                        "comma-separated; applied in order",
+                        filter_chain::available(),
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_filter_validator
+                    },
+                    {
+                        FLAG_TRACE,
+                        S_FLAG_TRACE,
+                        "Write a trace of each phase to a file",
+                        "",
+                        "",
+                        "file",
+                        "in the Chrome/Perfetto trace event format",
+                        {},
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_trace_validator
+                    },
+                    {
+                        FLAG_STATS,
+                        S_FLAG_STATS,
+                        "Print a summary of the run to stdout",
+                        "",
+                        STATS_NONE,
+                        "format",
+                        "",
+                        {
+                            STATS_NONE,
+                            STATS_JSON
+                        },
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_stats_validator
+                    },
+                    {
+                        FLAG_WATCH,
+                        S_FLAG_WATCH,
+                        "Regenerate whenever the input changes",
+                        "",
+                        "",
+                        "",
+                        "Linux only; until SIGINT or SIGTERM",
+                        {},
+                        false,
+                        false,
+                        false,
+                        false,
+                        nullptr
+                    },
+                    {
+                        FLAG_SERVE,
+                        S_FLAG_SERVE,
+                        "Run as a server, listening on a Unix domain socket",
+                        "",
+                        "",
+                        "socket",
+                        "until SIGINT or SIGTERM; takes no other options except -l",
+                        {},
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_socket_validator
+                    },
+                    {
+                        FLAG_CONNECT,
+                        S_FLAG_CONNECT,
+                        "Have the server listening on a socket do the work",
+                        "",
+                        "",
+                        "socket",
+                        "runs locally if no server is listening",
+                        {},
+                        false,
+                        true,
+                        false,
+                        false,
+                        &_socket_validator
+                    },
                     {
                         FLAG_LOG_LEVEL,
                         S_FLAG_LOG_LEVEL,
@@ -412,6 +1019,215 @@ namespace emblob
                 return true;
             }
 
+            static bool _index_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (val != INDEX_NONE && val != INDEX_LINES) {
+                    msg = fmt_str("must be one of: %s, %s", INDEX_NONE, INDEX_LINES);
+                    return false;
+                }
+
+                return true;
+            }
+
+            static bool _trace_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (val.empty()) {
+                    msg = "no file specified";
+                    return false;
+                }
+
+                if (system::is_directory(val)) {
+                    msg = fmt_str("%s is a directory", val.c_str());
+                    return false;
+                }
+
+                return true;
+            }
+
+            static bool _stats_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (val != STATS_NONE && val != STATS_JSON) {
+                    msg = fmt_str("must be one of: %s, %s", STATS_NONE, STATS_JSON);
+                    return false;
+                }
+
+                return true;
+            }
+
+            static bool _members_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (filter_chain::split_names(val).empty()) {
+                    msg = "no patterns specified";
+                    return false;
+                }
+
+                return true;
+            }
+
+            static bool _socket_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (val.empty()) {
+                    msg = "no socket specified";
+                    return false;
+                }
+
+                return true;
+            }
+
+            static bool _element_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (val != element::TYPE_NONE && element::type::none == element::type_from_string(val)) {
+                    msg = fmt_str("%s is not a valid element type", val.c_str());
+                    return false;
+                }
+
+                return true;
+            }
+
+            static bool _source_endian_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (val != element::ENDIAN_NATIVE && val != element::ENDIAN_BIG &&
+                    val != element::ENDIAN_LITTLE) {
+                    msg = fmt_str("must be one of: %s, %s, %s", element::ENDIAN_NATIVE,
+                        element::ENDIAN_BIG, element::ENDIAN_LITTLE);
+                    return false;
+                }
+
+                return true;
+            }
+
+            static bool _compress_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (val != COMPRESS_NONE && val != COMPRESS_DEFLATE) {
+                    msg = fmt_str("must be one of: %s, %s", COMPRESS_NONE, COMPRESS_DEFLATE);
+                    return false;
+                }
+
+# if !defined(EMBLOB_HAVE_ZLIB)
+                if (val == COMPRESS_DEFLATE) {
+                    msg = "emblob was built without zlib";
+                    return false;
+                }
+# endif
+
+                return true;
+            }
+
+            static bool _filter_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                auto names = filter_chain::split_names(val);
+                if (names.empty()) {
+                    msg = "at least one filter is required";
+                    return false;
+                }
+
+                for (const auto& name : names) {
+                    if (!filter_chain::create(name)) {
+                        msg = fmt_str("%s is not a known filter", name.c_str());
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            static bool _pack_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (val.empty()) {
+                    msg = "no file specified";
+                    return false;
+                }
+
+                if (system::is_directory(val)) {
+                    msg = fmt_str("%s is a directory", val.c_str());
+                    return false;
+                }
+
+                return true;
+            }
+
+            static bool _http_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                auto encodings = filter_chain::split_names(val);
+                if (encodings.empty()) {
+                    msg = fmt_str("at least one coding is required (use %s for none)", http::ENCODING_IDENTITY);
+                    return false;
+                }
+
+                auto available = http::available_encodings();
+                for (const auto& encoding : encodings) {
+                    if (std::ranges::find(available, encoding) == available.end()) {
+                        msg = encoding == http::ENCODING_GZIP || encoding == http::ENCODING_BR
+                            ? fmt_str("emblob was built without support for %s", encoding.c_str())
+                            : fmt_str("%s is not a known content coding", encoding.c_str());
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            static bool _parse_delimiter(const std::string& val, /*out*/ char& delim) {
+                if (val.size() == 1) {
+                    delim = val[0];
+                    return true;
+                }
+
+                if (val.size() == 2 && val[0] == '\\') {
+                    switch (val[1]) {
+                        case 'n':  delim = '\n'; return true;
+                        case 'r':  delim = '\r'; return true;
+                        case 't':  delim = '\t'; return true;
+                        case '0':  delim = '\0'; return true;
+                        case '\\': delim = '\\'; return true;
+                        default: return false;
+                    }
+                }
+
+                if (val.size() == 4 && val[0] == '\\' && val[1] == 'x' &&
+                    std::isxdigit(static_cast<unsigned char>(val[2])) &&
+                    std::isxdigit(static_cast<unsigned char>(val[3]))) {
+                    delim = static_cast<char>(std::strtoul(val.substr(2).c_str(), nullptr, 16));
+                    return true;
+                }
+
+                return false;
+            }
+
+            static bool _delimiter_validator(const std::string& val, /*out*/ std::string& msg) {
+
+                msg.clear();
+
+                if (char delim = 0; !_parse_delimiter(val, delim)) {
+                    msg = "must be a single character, or one of \\n, \\r, \\t, \\0, \\\\, or \\xHH";
+                    return false;
+                }
+
+                return true;
+            }
+
             static bool _input_filename_validator(const std::string& val, /*out*/ std::string& msg) {
 
                 msg.clear();
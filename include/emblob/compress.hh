@@ -0,0 +1,291 @@
+/*
+ * compress.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_COMPRESS_HH_INCLUDED
+# define _EMBLOB_COMPRESS_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+
+# include <unordered_map>
+# include <unordered_set>
+
+# if defined(EMBLOB_HAVE_ZLIB)
+#  include <zlib.h>
+# endif
+
+# if defined(EMBLOB_HAVE_BROTLI)
+#  include <brotli/encode.h>
+# endif
+
+namespace emblob
+{
+    /* builds a dictionary from a set of samples (the members of a directory),
+     * out of the segments which contain the most d-mers shared between
+     * samples. this is the "COVER" algorithm: the samples are divided into
+     * epochs, and the best-scoring segment from each epoch is chosen, after
+     * which the d-mers that it contains no longer count towards the score of
+     * any other segment.
+     *
+     * the dictionary is assembled so that the best segments come last, since
+     * (in DEFLATE, at least) references to nearby data are cheaper. */
+    class dictionary_trainer
+    {
+    public:
+        CONST_STATIC_X(size_t) DMER_SIZE    = 8;
+        CONST_STATIC_X(size_t) SEGMENT_SIZE = 64;
+
+        dictionary_trainer() = delete;
+        ~dictionary_trainer() = delete;
+
+        static std::string train(const std::vector<const std::string*>& samples, size_t dict_size) {
+            std::string all;
+            for (const auto* s : samples) {
+                all.append(*s);
+            }
+
+            if (all.size() < SEGMENT_SIZE || dict_size < SEGMENT_SIZE) {
+                return {};
+            }
+
+            /* the number of samples in which each d-mer appears. d-mers which
+             * appear in only one sample are of no use. */
+            std::unordered_map<uint64_t, uint32_t> freq;
+            for (const auto* s : samples) {
+                std::unordered_set<uint64_t> seen;
+                for (size_t n = 0; n + DMER_SIZE <= s->size(); n++) {
+                    if (seen.insert(_dmer(s->data() + n)).second) {
+                        freq[_dmer(s->data() + n)]++;
+                    }
+                }
+            }
+
+            struct chosen {
+                size_t offset;
+                uint64_t score;
+            };
+
+            std::vector<chosen> segments;
+            size_t epochs     = std::max<size_t>(1, dict_size / SEGMENT_SIZE);
+            size_t epoch_size = std::max<size_t>(SEGMENT_SIZE, all.size() / epochs);
+
+            for (size_t begin = 0; begin + SEGMENT_SIZE <= all.size() &&
+                segments.size() * SEGMENT_SIZE < dict_size; begin += epoch_size) {
+                size_t end = std::min(begin + epoch_size, all.size());
+                auto best = _best_segment(all, begin, end, freq);
+                if (best.second == 0) {
+                    continue;
+                }
+
+                segments.push_back({ best.first, best.second });
+                for (size_t n = best.first; n + DMER_SIZE <= best.first + SEGMENT_SIZE; n++) {
+                    if (auto it = freq.find(_dmer(all.data() + n)); it != freq.end()) {
+                        it->second = 0;
+                    }
+                }
+            }
+
+            std::stable_sort(segments.begin(), segments.end(), [](const chosen& a, const chosen& b) {
+                return a.score < b.score;
+            });
+
+            std::string dict;
+            for (const auto& s : segments) {
+                dict.append(all, s.offset, SEGMENT_SIZE);
+            }
+
+            return dict;
+        }
+
+    private:
+        static uint64_t _dmer(const char* p) {
+            uint64_t v = 0;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static uint64_t _score(uint32_t freq) {
+            return freq >= 2 ? freq : 0;
+        }
+
+        /* slides a SEGMENT_SIZE window across [begin, end), scoring each window
+         * as the sum of the frequencies of the distinct d-mers within it. */
+        static std::pair<size_t, uint64_t> _best_segment(const std::string& all, size_t begin,
+            size_t end, const std::unordered_map<uint64_t, uint32_t>& freq) {
+            constexpr size_t dmers_per_segment = SEGMENT_SIZE - DMER_SIZE + 1;
+
+            std::unordered_map<uint64_t, uint32_t> active;
+            uint64_t score = 0;
+            size_t best_offset = begin;
+            uint64_t best_score = 0;
+
+            auto freq_of = [&freq](uint64_t dmer) -> uint64_t {
+                auto it = freq.find(dmer);
+                return it != freq.end() ? _score(it->second) : 0;
+            };
+
+            for (size_t n = begin; n + DMER_SIZE <= end; n++) {
+                auto dmer = _dmer(all.data() + n);
+                if (active[dmer]++ == 0) {
+                    score += freq_of(dmer);
+                }
+
+                if (n >= begin + dmers_per_segment) {
+                    auto old = _dmer(all.data() + n - dmers_per_segment);
+                    if (--active[old] == 0) {
+                        score -= freq_of(old);
+                        active.erase(old);
+                    }
+                }
+
+                size_t seg_start = n + 1 >= begin + dmers_per_segment ? n + 1 - dmers_per_segment : begin;
+                if (n + 1 >= begin + dmers_per_segment && score > best_score) {
+                    best_score  = score;
+                    best_offset = seg_start;
+                }
+            }
+
+            return { best_offset, best_score };
+        }
+    };
+
+# if defined(EMBLOB_HAVE_ZLIB)
+    /* raw DEFLATE (no zlib header or trailer) against an optional preset
+     * dictionary; the generated code inflates with the same parameters. */
+    class deflate_codec
+    {
+    public:
+        CONST_STATIC_X(int) LEVEL       = Z_BEST_COMPRESSION;
+        CONST_STATIC_X(int) WINDOW_BITS = -15;
+        CONST_STATIC_X(int) MEM_LEVEL   = 9;
+
+        /* zlib only uses the last 32 KiB of a dictionary. */
+        CONST_STATIC_X(size_t) MAX_DICTIONARY_SIZE = 32768;
+
+        deflate_codec() = delete;
+        ~deflate_codec() = delete;
+
+        static bool compress(const std::string& in, const std::string& dict, std::string& out) {
+            z_stream strm {};
+            if (Z_OK != deflateInit2(&strm, LEVEL, Z_DEFLATED, WINDOW_BITS, MEM_LEVEL,
+                Z_DEFAULT_STRATEGY)) {
+                g_logger->error("deflateInit2 failed: %s", strm.msg ? strm.msg : "unknown error");
+                return false;
+            }
+
+            bool ok = true;
+            if (!dict.empty()) {
+                ok = Z_OK == deflateSetDictionary(&strm, reinterpret_cast<const Bytef*>(dict.data()),
+                    static_cast<uInt>(dict.size()));
+            }
+
+            if (ok) {
+                out.resize(deflateBound(&strm, static_cast<uLong>(in.size())));
+                strm.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+                strm.avail_in  = static_cast<uInt>(in.size());
+                strm.next_out  = reinterpret_cast<Bytef*>(out.data());
+                strm.avail_out = static_cast<uInt>(out.size());
+
+                ok = Z_STREAM_END == ::deflate(&strm, Z_FINISH);
+                out.resize(strm.total_out);
+            }
+
+            if (!ok) {
+                g_logger->error("deflate failed: %s", strm.msg ? strm.msg : "unknown error");
+            }
+
+            deflateEnd(&strm);
+            return ok;
+        }
+    };
+
+    /* gzip (RFC 1952), as served with Content-Encoding: gzip. */
+    class gzip_codec
+    {
+    public:
+        CONST_STATIC_X(int) LEVEL       = Z_BEST_COMPRESSION;
+        CONST_STATIC_X(int) WINDOW_BITS = 15 + 16;
+        CONST_STATIC_X(int) MEM_LEVEL   = 9;
+
+        gzip_codec() = delete;
+        ~gzip_codec() = delete;
+
+        static bool compress(const std::string& in, std::string& out) {
+            z_stream strm {};
+            if (Z_OK != deflateInit2(&strm, LEVEL, Z_DEFLATED, WINDOW_BITS, MEM_LEVEL,
+                Z_DEFAULT_STRATEGY)) {
+                g_logger->error("deflateInit2 failed: %s", strm.msg ? strm.msg : "unknown error");
+                return false;
+            }
+
+            out.resize(deflateBound(&strm, static_cast<uLong>(in.size())));
+            strm.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+            strm.avail_in  = static_cast<uInt>(in.size());
+            strm.next_out  = reinterpret_cast<Bytef*>(out.data());
+            strm.avail_out = static_cast<uInt>(out.size());
+
+            bool ok = Z_STREAM_END == ::deflate(&strm, Z_FINISH);
+            out.resize(strm.total_out);
+
+            if (!ok) {
+                g_logger->error("deflate failed: %s", strm.msg ? strm.msg : "unknown error");
+            }
+
+            deflateEnd(&strm);
+            return ok;
+        }
+    };
+# endif // !EMBLOB_HAVE_ZLIB
+
+# if defined(EMBLOB_HAVE_BROTLI)
+    /* brotli (RFC 7932), as served with Content-Encoding: br. */
+    class brotli_codec
+    {
+    public:
+        CONST_STATIC_X(int) QUALITY = BROTLI_MAX_QUALITY;
+        CONST_STATIC_X(int) LGWIN   = BROTLI_DEFAULT_WINDOW;
+
+        brotli_codec() = delete;
+        ~brotli_codec() = delete;
+
+        static bool compress(const std::string& in, std::string& out) {
+            size_t out_size = BrotliEncoderMaxCompressedSize(in.size());
+            out.resize(out_size != 0 ? out_size : in.size() + 1024);
+
+            if (!BrotliEncoderCompress(QUALITY, LGWIN, BROTLI_MODE_GENERIC, in.size(),
+                reinterpret_cast<const uint8_t*>(in.data()), &out_size,
+                reinterpret_cast<uint8_t*>(out.data()))) {
+                g_logger->error("brotli compression failed");
+                return false;
+            }
+
+            out.resize(out_size);
+            return true;
+        }
+    };
+# endif // !EMBLOB_HAVE_BROTLI
+} // !namespace emblob
+
+#endif // !_EMBLOB_COMPRESS_HH_INCLUDED
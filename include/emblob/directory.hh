@@ -0,0 +1,503 @@
+/*
+ * directory.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_DIRECTORY_HH_INCLUDED
+# define _EMBLOB_DIRECTORY_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+# include "emblob/filter.hh"
+# include "emblob/compress.hh"
+# include "emblob/http.hh"
+# include "emblob/archive.hh"
+
+# include <filesystem>
+# include <map>
+
+namespace emblob
+{
+    /* the files in a directory (recursively), packed back to back into a
+     * single blob, along with a table which describes each of them (a member)
+     * and an open-addressed hash table of their names.
+     *
+     * the tables are pointer-free, so that they may live in read-only memory
+     * without requiring any relocations: names are stored in a pool of
+     * NUL-terminated strings, and everything is referred to by offset. */
+    class directory_pack
+    {
+    public:
+        CONST_STATIC_X(size_t) MEMBER_ALIGNMENT = 16;
+
+        /* must match EMBLOB_MEMBER_* in the generated header. */
+        CONST_STATIC_X(uint64_t) FLAG_DEFLATE = 1;
+
+        /* the number of words per member in the member and http tables. */
+        CONST_STATIC_X(size_t) MEMBER_WORDS = 7;
+        CONST_STATIC_X(size_t) HTTP_WORDS   = 2 + 2 * http::variant_count;
+
+        /* the zero-filled storage reserved for the cache of decompressed
+         * members: an emblob_cache, and an emblob_cache_slot per member. */
+        CONST_STATIC_X(size_t) CACHE_SIZE      = 64;
+        CONST_STATIC_X(size_t) CACHE_SLOT_SIZE = 32;
+
+        struct member {
+            std::string name;
+            std::string path;
+            std::string data;
+            uint64_t offset = 0;
+            uint64_t size   = 0;
+            uint64_t flags  = 0;
+            uint64_t hash   = 0;
+
+            /* with http metadata. */
+            std::string mime;
+            std::string etag;
+            std::array<std::string, http::variant_count> variants;
+            std::array<uint64_t, http::variant_count> variant_offsets {};
+        };
+
+        directory_pack() = default;
+        ~directory_pack() = default;
+
+        /* FNV-1a; the generated lookup functions use the same hash. */
+        static uint64_t hash_name(const std::string& name) {
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            for (char c : name) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 0x100000001b3ULL;
+            }
+
+            return hash;
+        }
+
+        /* reads every regular file beneath dir (in a stable order), passing
+         * each one through a new chain of the named filters. */
+        bool load(const std::string& dir, const std::vector<std::string>& filter_names) {
+            _members.clear();
+
+            std::error_code ec;
+            std::filesystem::recursive_directory_iterator it(dir, ec), end;
+            for (; !ec && it != end; it.increment(ec)) {
+                if (!it->is_regular_file(ec)) {
+                    continue;
+                }
+
+                member m;
+                m.path = it->path().string();
+                m.name = it->path().lexically_relative(dir).generic_string();
+                m.hash = hash_name(m.name);
+                _members.push_back(std::move(m));
+            }
+
+            if (ec) {
+                g_logger->error("failed to read directory %s: %s", dir.c_str(), ec.message().c_str());
+                return false;
+            }
+
+            if (_members.empty()) {
+                g_logger->error("directory %s contains no files", dir.c_str());
+                return false;
+            }
+
+            std::sort(_members.begin(), _members.end(), [](const member& a, const member& b) {
+                return a.name < b.name;
+            });
+
+            return _filter_members(filter_names);
+        }
+
+        /* reads the regular files in a tar, gzip-compressed tar, or zip
+         * archive whose names match any of patterns (or all of them, if there
+         * are none). a name which appears more than once refers to the last
+         * member by that name, as it would if the archive were extracted. */
+        bool load_archive(const std::string& fname, const std::vector<std::string>& patterns,
+            const std::vector<std::string>& filter_names) {
+            _members.clear();
+
+            std::map<std::string, std::string> contents;
+            bool read = archive_reader::read(fname, [&patterns](const std::string& name) {
+                return archive_reader::matches(name, patterns);
+            }, [&contents](const std::string& name, std::string&& data) {
+                contents[name] = std::move(data);
+                return true;
+            });
+
+            if (!read) {
+                return false;
+            }
+
+            if (contents.empty()) {
+                g_logger->error("archive %s contains no %sfiles", fname.c_str(),
+                    patterns.empty() ? "" : "matching ");
+                return false;
+            }
+
+            for (auto& [name, data] : contents) {
+                member m;
+                m.name = name;
+                m.data = std::move(data);
+                m.hash = hash_name(m.name);
+                _members.push_back(std::move(m));
+            }
+
+            return _filter_members(filter_names);
+        }
+
+        /* records the MIME type and ETag of each member, and precompresses it
+         * in each of the given content codings (other than identity). must be
+         * called before the members are compressed, since it needs their
+         * contents. variants which are no smaller than the contents are not
+         * kept. */
+        bool add_http(const std::vector<std::string>& encodings) {
+            _http = true;
+
+            std::array<bool, http::variant_count> wanted {};
+            wanted[http::gzip] = std::ranges::find(encodings, http::ENCODING_GZIP) != encodings.end();
+            wanted[http::br]   = std::ranges::find(encodings, http::ENCODING_BR) != encodings.end();
+
+            std::array<uint64_t, http::variant_count> totals {};
+            for (auto& m : _members) {
+                m.mime = http::mime_type(m.name);
+                m.etag = http::etag(m.data);
+
+                for (size_t v = 0; v < http::variant_count; v++) {
+                    if (!wanted[v]) {
+                        continue;
+                    }
+
+                    std::string out;
+                    if (!http::compress(static_cast<http::variant>(v), m.data, out)) {
+                        return false;
+                    }
+
+                    if (out.size() < m.data.size()) {
+                        totals[v] += out.size();
+                        m.variants[v] = std::move(out);
+                    }
+                }
+            }
+
+            for (size_t v = 0; v < http::variant_count; v++) {
+                if (wanted[v]) {
+                    g_logger->info("%s variants: %" PRIu64 " bytes", v == http::gzip ? http::ENCODING_GZIP
+                        : http::ENCODING_BR, totals[v]);
+                }
+            }
+
+            return true;
+        }
+
+# if defined(EMBLOB_HAVE_ZLIB)
+        /* trains a dictionary on the members' contents, then compresses each
+         * member against it independently, so that any one of them may be
+         * decompressed without the others. members which do not get smaller
+         * are stored as-is. */
+        bool compress_deflate() {
+            std::vector<const std::string*> samples;
+            for (const auto& m : _members) {
+                samples.push_back(&m.data);
+            }
+
+            /* a dictionary much larger than ~1/16 of the data isn't worth it. */
+            size_t dict_size = std::min(deflate_codec::MAX_DICTIONARY_SIZE,
+                std::max<size_t>(_original_size / 16, 1024));
+            _dictionary = dictionary_trainer::train(samples, dict_size);
+
+            uint64_t with_dict = _dictionary.size();
+            uint64_t without_dict = 0;
+            std::vector<std::string> compressed(_members.size());
+            std::string plain;
+
+            for (size_t n = 0; n < _members.size(); n++) {
+                if (!deflate_codec::compress(_members[n].data, _dictionary, compressed[n]) ||
+                    !deflate_codec::compress(_members[n].data, {}, plain)) {
+                    return false;
+                }
+
+                with_dict    += std::min(compressed[n].size(), _members[n].data.size());
+                without_dict += std::min(plain.size(), _members[n].data.size());
+            }
+
+            g_logger->info("compressed %zu members: %" PRIu64 " -> %" PRIu64 " bytes, including a "
+                "%zu-byte dictionary (%" PRIu64 " bytes without one)", _members.size(), _original_size,
+                with_dict, _dictionary.size(), without_dict);
+
+            if (without_dict <= with_dict) {
+                g_logger->info("the dictionary does not pay for itself; discarding it");
+                _dictionary.clear();
+                for (size_t n = 0; n < _members.size(); n++) {
+                    if (!deflate_codec::compress(_members[n].data, {}, compressed[n])) {
+                        return false;
+                    }
+                }
+            }
+
+            for (size_t n = 0; n < _members.size(); n++) {
+                if (compressed[n].size() < _members[n].data.size()) {
+                    _members[n].data  = std::move(compressed[n]);
+                    _members[n].flags |= FLAG_DEFLATE;
+                }
+            }
+
+            return true;
+        }
+# endif
+
+        /* writes the (possibly compressed) members to fname, back to back,
+         * each followed by its precompressed variants (if any). members which
+         * are stored as-is are aligned to MEMBER_ALIGNMENT. */
+        bool write_pack(const std::string& fname) {
+            uint64_t pos = 0;
+            auto wrote = system::write_file_contents(fname, std::ios::out | std::ios::trunc |
+                std::ios::binary, [&](std::ostream& strm) {
+                for (auto& m : _members) {
+                    if (0 == (m.flags & FLAG_DEFLATE)) {
+                        auto pad = (MEMBER_ALIGNMENT - (pos % MEMBER_ALIGNMENT)) % MEMBER_ALIGNMENT;
+                        strm.write("\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", static_cast<std::streamsize>(pad));
+                        pos += pad;
+                    }
+
+                    m.offset = pos;
+                    strm.write(m.data.data(), static_cast<std::streamsize>(m.data.size()));
+                    pos += m.data.size();
+
+                    for (size_t v = 0; v < http::variant_count; v++) {
+                        m.variant_offsets[v] = pos;
+                        strm.write(m.variants[v].data(), static_cast<std::streamsize>(m.variants[v].size()));
+                        pos += m.variants[v].size();
+                    }
+                }
+
+                /* the blob may not be empty. */
+                if (pos == 0) {
+                    strm.put('\0');
+                }
+            });
+
+            return wrote != std::ofstream::pos_type(-1);
+        }
+
+        bool compressed() const {
+            return std::any_of(_members.begin(), _members.end(), [](const member& m) {
+                return 0 != (m.flags & FLAG_DEFLATE);
+            });
+        }
+
+        bool has_http() const {
+            return _http;
+        }
+
+        const std::vector<member>& members() const {
+            return _members;
+        }
+
+        const std::string& dictionary() const {
+            return _dictionary;
+        }
+
+        uint64_t original_size() const {
+            return _original_size;
+        }
+
+        size_t slot_count() const {
+            return std::bit_ceil(std::max<size_t>(2, _members.size() * 2));
+        }
+
+        /* the member table: seven words per member (see emblob_member). */
+        std::vector<uint64_t> member_words() const {
+            std::vector<uint64_t> words;
+            uint64_t name_offset = 0;
+            for (const auto& m : _members) {
+                words.insert(words.end(), { name_offset, m.name.size(), m.offset, m.data.size(), m.size,
+                    m.hash, m.flags });
+                name_offset += m.name.size() + 1;
+            }
+
+            return words;
+        }
+
+        /* the hash table: each slot holds a member index + 1, or zero if it is
+         * empty. */
+        std::vector<uint32_t> slots() const {
+            std::vector<uint32_t> slots(slot_count(), 0);
+            auto mask = slots.size() - 1;
+            for (size_t n = 0; n < _members.size(); n++) {
+                auto slot = _members[n].hash & mask;
+                while (slots[slot] != 0) {
+                    slot = (slot + 1) & mask;
+                }
+
+                slots[slot] = static_cast<uint32_t>(n + 1);
+            }
+
+            return slots;
+        }
+
+        /* the NUL-terminated names of the members, back to back. */
+        std::string names_pool() const {
+            std::string pool;
+            for (const auto& m : _members) {
+                pool += m.name;
+                pool.push_back('\0');
+            }
+
+            return pool;
+        }
+
+        /* the http table: per member, the offsets of its MIME type and ETag in
+         * the string pool, then the offset and size of each variant (zero if
+         * there is none). */
+        void http_tables(std::vector<uint64_t>& words, std::string& pool) const {
+            words.clear();
+            pool.clear();
+
+            /* MIME types are shared between members. */
+            std::map<std::string, uint64_t> mime_offsets;
+            for (const auto& m : _members) {
+                if (!mime_offsets.contains(m.mime)) {
+                    mime_offsets[m.mime] = pool.size();
+                    pool += m.mime;
+                    pool.push_back('\0');
+                }
+            }
+
+            for (const auto& m : _members) {
+                words.push_back(mime_offsets[m.mime]);
+                words.push_back(pool.size());
+                pool += m.etag;
+                pool.push_back('\0');
+
+                for (size_t v = 0; v < http::variant_count; v++) {
+                    words.push_back(m.variants[v].empty() ? 0 : m.variant_offsets[v]);
+                    words.push_back(m.variants[v].size());
+                }
+            }
+        }
+
+        void write_asm(std::ostream& strm, const std::string& lname) const {
+            strm << ".balign 8" << std::endl;
+            strm << ".global _" << lname << "_members" << std::endl;
+            strm << "_" << lname << "_members:" << std::endl;
+            _write_words(strm, ".quad", member_words(), MEMBER_WORDS);
+
+            strm << ".global _" << lname << "_member_slots" << std::endl;
+            strm << "_" << lname << "_member_slots:" << std::endl;
+            _write_words(strm, ".long", slots(), 16);
+
+            strm << ".global _" << lname << "_member_names" << std::endl;
+            strm << "_" << lname << "_member_names:" << std::endl;
+            for (const auto& m : _members) {
+                strm << ".asciz \"" << c_escape(m.name) << "\"" << std::endl;
+            }
+
+            strm << ".global _" << lname << "_dictionary" << std::endl;
+            strm << "_" << lname << "_dictionary:" << std::endl;
+            _write_string(strm, _dictionary);
+
+            strm << ".byte 0" << std::endl;
+
+            if (_http) {
+                std::vector<uint64_t> words;
+                std::string pool;
+                http_tables(words, pool);
+
+                strm << ".balign 8" << std::endl;
+                strm << ".global _" << lname << "_http" << std::endl;
+                strm << "_" << lname << "_http:" << std::endl;
+                _write_words(strm, ".quad", words, HTTP_WORDS);
+
+                strm << ".global _" << lname << "_http_strings" << std::endl;
+                strm << "_" << lname << "_http_strings:" << std::endl;
+                _write_string(strm, pool);
+            }
+        }
+
+        /* the initializers of the members table in the C++ API. */
+        std::string cxx_members() const {
+            std::string table;
+            for (const auto& m : _members) {
+                table += fmt_str("        { \"%s\", %" PRIu64 ", %" PRIu64 ", %s },\n",
+                    c_escape(m.name).c_str(), m.offset, m.size, (m.flags & FLAG_DEFLATE) ? "true" : "false");
+            }
+
+            return table;
+        }
+
+    private:
+        /* passes each member (from its file, or its contents if it has no
+         * file) through a new chain of the named filters. */
+        bool _filter_members(const std::vector<std::string>& filter_names) {
+            _original_size = 0;
+            for (auto& m : _members) {
+                filter_chain chain;
+                for (const auto& name : filter_names) {
+                    chain.add(filter_chain::create(name));
+                }
+
+                std::ostringstream strm(std::ios::out | std::ios::binary);
+                if (m.path.empty()) {
+                    std::istringstream in(m.data, std::ios::in | std::ios::binary);
+                    if (!chain.run(in, m.name, strm)) {
+                        return false;
+                    }
+                } else if (!chain.run(m.path, strm)) {
+                    return false;
+                }
+
+                m.data = std::move(strm).str();
+                m.size = m.data.size();
+                _original_size += m.size;
+            }
+
+            return true;
+        }
+
+        template<typename T>
+        static void _write_words(std::ostream& strm, const char* directive, const std::vector<T>& words,
+            size_t per_line) {
+            for (size_t n = 0; n < words.size(); n += per_line) {
+                strm << directive << " ";
+                for (size_t w = n; w < std::min(n + per_line, words.size()); w++) {
+                    strm << (w == n ? "" : ", ") << words[w];
+                }
+                strm << std::endl;
+            }
+        }
+
+        static void _write_string(std::ostream& strm, const std::string& str) {
+            for (size_t n = 0; n < str.size(); n += 64) {
+                strm << ".ascii \"" << c_escape(str.substr(n, 64)) << "\"" << std::endl;
+            }
+        }
+
+        std::vector<member> _members;
+        std::string _dictionary;
+        uint64_t _original_size = 0;
+        bool _http = false;
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_DIRECTORY_HH_INCLUDED
@@ -0,0 +1,151 @@
+/*
+ * element.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_ELEMENT_HH_INCLUDED
+# define _EMBLOB_ELEMENT_HH_INCLUDED
+
+# include "emblob/util.hh"
+
+# include <bit>
+
+namespace emblob
+{
+    /* the type of the elements that make up a blob, if it is to be treated as
+     * an array of numbers. */
+    class element
+    {
+    public:
+        enum class type {
+            none = 0,
+            u16,
+            u32,
+            u64,
+            f32,
+            f64
+        };
+
+        CONST_STATIC_STRING TYPE_NONE = "none";
+        CONST_STATIC_STRING TYPE_U16  = "u16";
+        CONST_STATIC_STRING TYPE_U32  = "u32";
+        CONST_STATIC_STRING TYPE_U64  = "u64";
+        CONST_STATIC_STRING TYPE_F32  = "f32";
+        CONST_STATIC_STRING TYPE_F64  = "f64";
+
+        CONST_STATIC_STRING ENDIAN_BIG    = "big";
+        CONST_STATIC_STRING ENDIAN_LITTLE = "little";
+        CONST_STATIC_STRING ENDIAN_NATIVE = "native";
+
+        element() = delete;
+        ~element() = delete;
+
+        static type type_from_string(const std::string& str) {
+            auto lstr = string_to_lower(str);
+            if (lstr == TYPE_U16)
+                return type::u16;
+            else if (lstr == TYPE_U32)
+                return type::u32;
+            else if (lstr == TYPE_U64)
+                return type::u64;
+            else if (lstr == TYPE_F32)
+                return type::f32;
+            else if (lstr == TYPE_F64)
+                return type::f64;
+            else
+                return type::none;
+        }
+
+        static size_t width(type t) {
+            using enum type;
+            switch (t) {
+                case u16: return 2;
+                case u32:
+                case f32: return 4;
+                case u64:
+                case f64: return 8;
+                default:  return 1;
+            }
+        }
+
+        static const char* c_type(type t) {
+            using enum type;
+            switch (t) {
+                case u16: return "uint16_t";
+                case u32: return "uint32_t";
+                case u64: return "uint64_t";
+                case f32: return "float";
+                case f64: return "double";
+                default:  return "uint8_t";
+            }
+        }
+
+        static const char* macro_suffix(type t) {
+            using enum type;
+            switch (t) {
+                case u16: return "U16";
+                case u32: return "U32";
+                case u64: return "U64";
+                case f32: return "F32";
+                case f64: return "F64";
+                default:  return "NONE";
+            }
+        }
+
+        /* whether data in the specified byte order must be swapped in order to
+         * be in the native byte order of this machine. */
+        static bool needs_swap(const std::string& source_endian) {
+            if (source_endian == ENDIAN_BIG) {
+                return std::endian::native != std::endian::big;
+            } else if (source_endian == ENDIAN_LITTLE) {
+                return std::endian::native != std::endian::little;
+            }
+
+            return false;
+        }
+
+        /* reverses the byte order of each width-byte element in data, in place.
+         * the loops are written byte-wise, since that is the form which the
+         * compiler is able to vectorize into byte shuffles at -O3. */
+        static void byteswap(uint8_t* data, size_t len, size_t width) {
+            switch (width) {
+                case 2: _byteswap<2>(data, len); break;
+                case 4: _byteswap<4>(data, len); break;
+                case 8: _byteswap<8>(data, len); break;
+                default: break;
+            }
+        }
+
+    private:
+        template<size_t W>
+        static void _byteswap(uint8_t* data, size_t len) {
+            for (size_t n = 0; n + W <= len; n += W) {
+                for (size_t b = 0; b < W / 2; b++) {
+                    std::swap(data[n + b], data[n + W - 1 - b]);
+                }
+            }
+        }
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_ELEMENT_HH_INCLUDED
@@ -0,0 +1,187 @@
+/*
+ * elfobject.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_ELFOBJECT_HH_INCLUDED
+# define _EMBLOB_ELFOBJECT_HH_INCLUDED
+
+# include "emblob/util.hh"
+
+# if !defined(__MACOS__)
+#  include <elf.h>
+# endif
+
+namespace emblob
+{
+# if !defined(__MACOS__)
+    /* writes the relocatable object that assembling the default (.incbin)
+     * assembly file would produce, directly: the blob in a read-only section of
+     * its own, _{lname}_data, and the absolute symbol _sizeof__{lname}_data.
+     * this is only possible for the hosts whose ELF flavor is known, and for
+     * blobs which need nothing else in the object file. */
+    class elf_object
+    {
+    public:
+        CONST_STATIC_X(uint64_t) BLOB_ALIGNMENT = 16;
+
+        elf_object() = delete;
+        ~elf_object() = delete;
+
+        static bool supported() {
+            return _machine() != EM_NONE;
+        }
+
+        static std::string build(const std::string& lname, const void* data, size_t len) {
+            auto out = header(lname, len);
+            out.append(static_cast<const char*>(data), len);
+            out += trailer(lname, len);
+            return out;
+        }
+
+        /* the object file is its header, the blob, and the trailer; the blob
+         * may be written in between them piecemeal (e.g., as it is read from
+         * a pipe), and the header rewritten once its length is known. */
+        static std::string header(const std::string& lname, uint64_t len) {
+            auto l = _lay_out(lname, len);
+            return std::string(reinterpret_cast<const char*>(&l.ehdr), sizeof(l.ehdr));
+        }
+
+        static std::string trailer(const std::string& lname, uint64_t len) {
+            auto l = _lay_out(lname, len);
+            std::string out = l.shstrtab + l.strtab;
+
+            /* offsets within the trailer are relative to the end of the blob. */
+            uint64_t base = sizeof(Elf64_Ehdr) + len;
+            out.resize(l.sym_off - base, '\0');
+            out.append(reinterpret_cast<const char*>(l.syms), sizeof(l.syms));
+            out.resize(l.shdr_off - base, '\0');
+            out.append(reinterpret_cast<const char*>(l.shdrs), sizeof(l.shdrs));
+            return out;
+        }
+
+    private:
+        enum : Elf64_Half {
+            SECTION_RODATA = 1,
+            SECTION_STACK,
+            SECTION_SYMTAB,
+            SECTION_STRTAB,
+            SECTION_SHSTRTAB,
+            SECTION_COUNT
+        };
+
+        struct layout {
+            std::string shstrtab;
+            std::string strtab;
+            Elf64_Sym syms[4] {};
+            Elf64_Shdr shdrs[SECTION_COUNT] {};
+            Elf64_Ehdr ehdr {};
+            uint64_t sym_off  = 0;
+            uint64_t shdr_off = 0;
+        };
+
+        static layout _lay_out(const std::string& lname, uint64_t len) {
+            layout l;
+            l.shstrtab.assign(1, '\0');
+            auto add_str = [](std::string& table, const std::string& str) {
+                auto offset = static_cast<Elf64_Word>(table.size());
+                table += str;
+                table.push_back('\0');
+                return offset;
+            };
+
+            auto rodata_name = add_str(l.shstrtab, ".rodata.emblob." + lname);
+            auto stack_name  = add_str(l.shstrtab, ".note.GNU-stack");
+            auto symtab_name = add_str(l.shstrtab, ".symtab");
+            auto strtab_name = add_str(l.shstrtab, ".strtab");
+            auto shstr_name  = add_str(l.shstrtab, ".shstrtab");
+
+            l.strtab.assign(1, '\0');
+            auto data_sym = add_str(l.strtab, "_" + lname + "_data");
+            auto size_sym = add_str(l.strtab, "_sizeof__" + lname + "_data");
+
+            /* the null symbol and the section's are local; LOCAL_SYMBOLS is the
+             * index of the first global one. */
+            constexpr Elf64_Word LOCAL_SYMBOLS = 2;
+            auto& syms = l.syms;
+            syms[1].st_info  = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+            syms[1].st_shndx = SECTION_RODATA;
+            syms[2].st_name  = data_sym;
+            syms[2].st_info  = ELF64_ST_INFO(STB_GLOBAL, STT_OBJECT);
+            syms[2].st_shndx = SECTION_RODATA;
+            syms[2].st_size  = len;
+            syms[3].st_name  = size_sym;
+            syms[3].st_info  = ELF64_ST_INFO(STB_GLOBAL, STT_NOTYPE);
+            syms[3].st_shndx = SHN_ABS;
+            syms[3].st_value = len;
+
+            uint64_t data_off  = sizeof(Elf64_Ehdr);
+            uint64_t shstr_off = data_off + len;
+            uint64_t str_off   = shstr_off + l.shstrtab.size();
+            l.sym_off          = _align(str_off + l.strtab.size(), 8);
+            l.shdr_off         = _align(l.sym_off + sizeof(syms), 8);
+
+            auto& shdrs = l.shdrs;
+            shdrs[SECTION_RODATA] = { rodata_name, SHT_PROGBITS, SHF_ALLOC, 0, data_off, len, 0, 0,
+                BLOB_ALIGNMENT, 0 };
+            shdrs[SECTION_STACK]  = { stack_name, SHT_PROGBITS, 0, 0, shstr_off, 0, 0, 0, 1, 0 };
+            shdrs[SECTION_SYMTAB] = { symtab_name, SHT_SYMTAB, 0, 0, l.sym_off, sizeof(syms),
+                SECTION_STRTAB, LOCAL_SYMBOLS, 8, sizeof(Elf64_Sym) };
+            shdrs[SECTION_STRTAB] = { strtab_name, SHT_STRTAB, 0, 0, str_off, l.strtab.size(), 0, 0, 1, 0 };
+            shdrs[SECTION_SHSTRTAB] = { shstr_name, SHT_STRTAB, 0, 0, shstr_off, l.shstrtab.size(), 0, 0,
+                1, 0 };
+
+            auto& ehdr = l.ehdr;
+            memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+            ehdr.e_ident[EI_CLASS]   = ELFCLASS64;
+            ehdr.e_ident[EI_DATA]    = ELFDATA2LSB;
+            ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+            ehdr.e_type      = ET_REL;
+            ehdr.e_machine   = _machine();
+            ehdr.e_version   = EV_CURRENT;
+            ehdr.e_shoff     = l.shdr_off;
+            ehdr.e_ehsize    = sizeof(Elf64_Ehdr);
+            ehdr.e_shentsize = sizeof(Elf64_Shdr);
+            ehdr.e_shnum     = SECTION_COUNT;
+            ehdr.e_shstrndx  = SECTION_SHSTRTAB;
+            return l;
+        }
+
+        static Elf64_Half _machine() {
+#  if defined(__x86_64__) && !defined(__ILP32__)
+            return EM_X86_64;
+#  elif defined(__aarch64__) && defined(__AARCH64EL__) && !defined(__ILP32__)
+            return EM_AARCH64;
+#  else
+            return EM_NONE;
+#  endif
+        }
+
+        static uint64_t _align(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    };
+# endif // !__MACOS__
+} // !namespace emblob
+
+#endif // !_EMBLOB_ELFOBJECT_HH_INCLUDED
@@ -0,0 +1,561 @@
+/*
+ * filter.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_FILTER_HH_INCLUDED
+# define _EMBLOB_FILTER_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+# include "emblob/element.hh"
+
+namespace emblob
+{
+    /* a destination for a stream of bytes. */
+    class sink
+    {
+    public:
+        sink() = default;
+        virtual ~sink() = default;
+
+        virtual void write(const char* data, size_t len) = 0;
+        virtual void finish() { }
+    };
+
+    class ostream_sink : public sink
+    {
+    public:
+        explicit ostream_sink(std::ostream& strm) : _strm(strm) { }
+        ~ostream_sink() override = default;
+
+        void write(const char* data, size_t len) override {
+            _strm.write(data, static_cast<std::streamsize>(len));
+        }
+
+    private:
+        std::ostream& _strm;
+    };
+
+    /* a streaming transformation which is applied to the contents of the input
+     * file before they are embedded. filters receive their input in arbitrarily
+     * sized chunks, so any state (e.g. 'inside a string literal') must be carried
+     * over between calls to process(). each filter passes its output on to the
+     * next sink in the chain. */
+    class filter : public sink
+    {
+    public:
+        filter() = default;
+        ~filter() override = default;
+
+        virtual const char* name() const = 0;
+
+        void set_next(sink* next) {
+            _next = next;
+        }
+
+        void write(const char* data, size_t len) final {
+            _bytes_in += len;
+            process(data, len);
+            _flush();
+        }
+
+        void finish() final {
+            finish_processing();
+            _flush();
+
+            if (_next) {
+                _next->finish();
+            }
+        }
+
+        uint64_t bytes_in() const {
+            return _bytes_in;
+        }
+
+        uint64_t bytes_out() const {
+            return _bytes_out;
+        }
+
+    protected:
+        virtual void process(const char* data, size_t len) = 0;
+        virtual void finish_processing() { }
+
+        void emit(char c) {
+            _out.push_back(c);
+        }
+
+        void emit(const char* data, size_t len) {
+            _out.append(data, len);
+        }
+
+    private:
+        void _flush() {
+            if (!_out.empty() && _next) {
+                _bytes_out += _out.size();
+                _next->write(_out.data(), _out.size());
+            }
+
+            _out.clear();
+        }
+
+        sink* _next = nullptr;
+        std::string _out;
+        uint64_t _bytes_in = 0;
+        uint64_t _bytes_out = 0;
+    };
+
+    /* removes whitespace outside of string literals. does not validate. */
+    class minify_json_filter : public filter
+    {
+    public:
+        const char* name() const override {
+            return "minify-json";
+        }
+
+    protected:
+        void process(const char* data, size_t len) override {
+            for (size_t n = 0; n < len; n++) {
+                char c = data[n];
+                if (_in_string) {
+                    emit(c);
+                    if (_escape) {
+                        _escape = false;
+                    } else if (c == '\\') {
+                        _escape = true;
+                    } else if (c == '"') {
+                        _in_string = false;
+                    }
+                } else if (c == '"') {
+                    _in_string = true;
+                    emit(c);
+                } else if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+                    emit(c);
+                }
+            }
+        }
+
+    private:
+        bool _in_string = false;
+        bool _escape = false;
+    };
+
+    /* removes C/C++-style comments (block and line) outside of string literals
+     * delimited by single or double quotes. block comments are replaced with a
+     * single space, so that the tokens on either side of them remain separate;
+     * line comments are removed up to (but not including) the newline. */
+    class strip_comments_filter : public filter
+    {
+    public:
+        const char* name() const override {
+            return "strip-comments";
+        }
+
+    protected:
+        enum class state {
+            normal,
+            slash,
+            line_comment,
+            block_comment,
+            block_comment_star,
+            string,
+            string_escape
+        };
+
+        void process(const char* data, size_t len) override {
+            for (size_t n = 0; n < len; n++) {
+                _process(data[n]);
+            }
+        }
+
+        void finish_processing() override {
+            if (_state == state::slash) {
+                emit('/');
+            }
+
+            _state = state::normal;
+        }
+
+    private:
+        void _process(char c) {
+            using enum state;
+            switch (_state) {
+                case normal:
+                    if (c == '/') {
+                        _state = slash;
+                    } else {
+                        _normal(c);
+                    }
+                break;
+                case slash:
+                    if (c == '/') {
+                        _state = line_comment;
+                    } else if (c == '*') {
+                        _state = block_comment;
+                    } else {
+                        emit('/');
+                        _state = normal;
+                        _process(c);
+                    }
+                break;
+                case line_comment:
+                    if (c == '\n') {
+                        emit(c);
+                        _state = normal;
+                    }
+                break;
+                case block_comment:
+                    if (c == '*') {
+                        _state = block_comment_star;
+                    }
+                break;
+                case block_comment_star:
+                    if (c == '/') {
+                        emit(' ');
+                        _state = normal;
+                    } else if (c != '*') {
+                        _state = block_comment;
+                    }
+                break;
+                case string:
+                    emit(c);
+                    if (c == '\\') {
+                        _state = string_escape;
+                    } else if (c == _quote) {
+                        _state = normal;
+                    }
+                break;
+                case string_escape:
+                    emit(c);
+                    _state = string;
+                break;
+                default:
+                break;
+            }
+        }
+
+        void _normal(char c) {
+            emit(c);
+            if (c == '"' || c == '\'') {
+                _quote = c;
+                _state = state::string;
+            }
+        }
+
+        state _state = state::normal;
+        char _quote = '"';
+    };
+
+    /* a conservative CSS minifier: removes comments, collapses runs of
+     * whitespace into a single space, removes whitespace adjacent to characters
+     * which never require it ({ } ; , > and following :), and removes the
+     * semicolon preceding a closing brace. string literals are untouched. */
+    class minify_css_filter : public filter
+    {
+    public:
+        const char* name() const override {
+            return "minify-css";
+        }
+
+    protected:
+        enum class state {
+            normal,
+            slash,
+            comment,
+            comment_star,
+            string,
+            string_escape
+        };
+
+        void process(const char* data, size_t len) override {
+            for (size_t n = 0; n < len; n++) {
+                _process(data[n]);
+            }
+        }
+
+        void finish_processing() override {
+            if (_state == state::slash) {
+                _token('/');
+            }
+
+            if (_pending_semicolon) {
+                emit(';');
+                _pending_semicolon = false;
+            }
+
+            _state = state::normal;
+        }
+
+    private:
+        static bool _is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+        }
+
+        static bool _no_space_before(char c) {
+            return c == '{' || c == '}' || c == ';' || c == ',' || c == '>';
+        }
+
+        static bool _no_space_after(char c) {
+            return c == '{' || c == '}' || c == ';' || c == ',' || c == '>' || c == ':';
+        }
+
+        /* emits a character which is not whitespace, deciding first whether the
+         * whitespace (if any) preceding it is significant. */
+        void _token(char c) {
+            if (_pending_semicolon) {
+                _pending_semicolon = false;
+                if (c != '}') {
+                    emit(';');
+                }
+            }
+
+            if (_pending_space && _last != 0 && !_no_space_after(_last) && !_no_space_before(c)) {
+                emit(' ');
+            }
+
+            _pending_space = false;
+            _last = c;
+
+            if (c == ';') {
+                _pending_semicolon = true;
+            } else {
+                emit(c);
+            }
+        }
+
+        void _process(char c) {
+            using enum state;
+            switch (_state) {
+                case normal:
+                    if (c == '/') {
+                        _state = slash;
+                    } else if (_is_space(c)) {
+                        _pending_space = true;
+                    } else {
+                        _token(c);
+                        if (c == '"' || c == '\'') {
+                            _quote = c;
+                            _state = string;
+                        }
+                    }
+                break;
+                case slash:
+                    if (c == '*') {
+                        _state = comment;
+                    } else {
+                        _state = normal;
+                        _token('/');
+                        _process(c);
+                    }
+                break;
+                case comment:
+                    if (c == '*') {
+                        _state = comment_star;
+                    }
+                break;
+                case comment_star:
+                    if (c == '/') {
+                        _pending_space = true;
+                        _state = normal;
+                    } else if (c != '*') {
+                        _state = comment;
+                    }
+                break;
+                case string:
+                    emit(c);
+                    _last = c;
+                    if (c == '\\') {
+                        _state = string_escape;
+                    } else if (c == _quote) {
+                        _state = normal;
+                    }
+                break;
+                case string_escape:
+                    emit(c);
+                    _last = c;
+                    _state = string;
+                break;
+                default:
+                break;
+            }
+        }
+
+        state _state = state::normal;
+        char _quote = '"';
+        char _last = 0;
+        bool _pending_space = false;
+        bool _pending_semicolon = false;
+    };
+
+    /* reverses the byte order of each element, carrying partial elements over
+     * between chunks. */
+    class byteswap_filter : public filter
+    {
+    public:
+        explicit byteswap_filter(size_t width) : _width(width) { }
+        ~byteswap_filter() override = default;
+
+        const char* name() const override {
+            return "byteswap";
+        }
+
+    protected:
+        void process(const char* data, size_t len) override {
+            _buf.insert(_buf.end(), reinterpret_cast<const uint8_t*>(data),
+                reinterpret_cast<const uint8_t*>(data) + len);
+
+            size_t whole = _buf.size() - (_buf.size() % _width);
+            element::byteswap(_buf.data(), whole, _width);
+            emit(reinterpret_cast<const char*>(_buf.data()), whole);
+            _buf.erase(_buf.begin(), _buf.begin() + static_cast<std::ptrdiff_t>(whole));
+        }
+
+        void finish_processing() override {
+            /* a partial element left over is passed through unswapped. the
+             * size can only be checked against the element width once the
+             * whole chain has run (earlier filters may change it), so the
+             * generator does that afterwards, and rejects the blob. */
+            emit(reinterpret_cast<const char*>(_buf.data()), _buf.size());
+            _buf.clear();
+        }
+
+    private:
+        size_t _width = 1;
+        std::vector<uint8_t> _buf;
+    };
+
+    /* an ordered chain of filters, through which the input file is streamed. */
+    class filter_chain
+    {
+    public:
+        CONST_STATIC_STRING MINIFY_JSON    = "minify-json";
+        CONST_STATIC_STRING MINIFY_CSS     = "minify-css";
+        CONST_STATIC_STRING STRIP_COMMENTS = "strip-comments";
+
+        CONST_STATIC_X(size_t) CHUNK_SIZE = 4 * 1024 * 1024;
+
+        filter_chain() = default;
+        ~filter_chain() = default;
+
+        static std::vector<std::string> available() {
+            return { MINIFY_JSON, MINIFY_CSS, STRIP_COMMENTS };
+        }
+
+        static std::unique_ptr<filter> create(const std::string& name) {
+            if (name == MINIFY_JSON) {
+                return std::make_unique<minify_json_filter>();
+            } else if (name == MINIFY_CSS) {
+                return std::make_unique<minify_css_filter>();
+            } else if (name == STRIP_COMMENTS) {
+                return std::make_unique<strip_comments_filter>();
+            }
+
+            return nullptr;
+        }
+
+        /* splits a comma-separated list of filter names. */
+        static std::vector<std::string> split_names(const std::string& list) {
+            std::vector<std::string> names;
+            std::stringstream strm(list);
+            std::string name;
+
+            while (std::getline(strm, name, ',')) {
+                if (!name.empty()) {
+                    names.push_back(name);
+                }
+            }
+
+            return names;
+        }
+
+        void add(std::unique_ptr<filter> f) {
+            if (f) {
+                _filters.push_back(std::move(f));
+            }
+        }
+
+        bool empty() const {
+            return _filters.empty();
+        }
+
+        template<typename TFunc>
+        void for_each(const TFunc& func) const {
+            for (const auto& f : _filters) {
+                func(*f);
+            }
+        }
+
+        /* streams the contents of in_fname through the chain, into strm. */
+        bool run(const std::string& in_fname, std::ostream& strm) {
+            std::ifstream in(in_fname, std::ios::in | std::ios::binary);
+            if (!in.is_open()) {
+                g_logger->error("failed to open %s: %s", in_fname.c_str(),
+                    system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            return run(in, in_fname, strm);
+        }
+
+        /* streams the contents of in (named name, in messages) through the
+         * chain, into strm. */
+        bool run(std::istream& in, const std::string& name, std::ostream& strm) {
+            ostream_sink out(strm);
+            sink* first = &out;
+
+            if (!_filters.empty()) {
+                for (size_t n = 0; n < _filters.size() - 1; n++) {
+                    _filters[n]->set_next(_filters[n + 1].get());
+                }
+
+                _filters.back()->set_next(&out);
+                first = _filters.front().get();
+            }
+
+            std::vector<char> buf(CHUNK_SIZE);
+            while (in) {
+                in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+                auto got = static_cast<size_t>(in.gcount());
+                if (got == 0) {
+                    break;
+                }
+
+                first->write(buf.data(), got);
+            }
+
+            if (in.bad()) {
+                g_logger->error("failed to read %s", name.c_str());
+                return false;
+            }
+
+            first->finish();
+            return true;
+        }
+
+    private:
+        std::vector<std::unique_ptr<filter>> _filters;
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_FILTER_HH_INCLUDED
@@ -0,0 +1,175 @@
+/*
+ * generator.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_GENERATOR_HH_INCLUDED
+# define _EMBLOB_GENERATOR_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/element.hh"
+
+# include <functional>
+# include <memory>
+
+namespace emblob
+{
+    /* libemblob: everything that the emblob executable does with its input,
+     * for use in-process. a generator renders the header and produces the
+     * object file for one blob at a time, from a file or directory, a buffer,
+     * or a file descriptor, and hands them to the caller's sinks.
+     *
+     * errors are reported through g_logger, as they are by the executable, and
+     * by returning false. any files created along the way are removed unless
+     * options::keep_intermediates is set, and then only upon success. */
+    class generator
+    {
+    public:
+        CONST_STATIC_STRING EXT_ASM     = ".S";
+        CONST_STATIC_STRING EXT_OBJ     = ".o";
+        CONST_STATIC_STRING EXT_PAYLOAD = ".payload";
+
+        /* how much of a file descriptor is read at a time. */
+        CONST_STATIC_X(size_t) READ_CHUNK = 1024 * 1024;
+
+        /* the size of each (calls, first access) profile counter. */
+        CONST_STATIC_X(size_t) PROFILE_COUNTER_SIZE = 16;
+
+        /* receives generated output; returning false fails the generation. */
+        using sink = std::function<bool(const char* data, size_t len)>;
+
+        struct options {
+            /* the name of the blob, from which the names in the header are
+             * derived. required for buffers and file descriptors; defaults to
+             * the base name of a file or directory. */
+            std::string name;
+
+            /* the path, without extension, of the intermediate files ({base}.S,
+             * {base}.o, {base}.payload). if empty, unique names in the
+             * temporary directory are used. */
+            std::string output_base;
+            bool keep_intermediates = false;
+
+            /* the compiler used to assemble {base}.S; detected if empty. */
+            std::string compiler;
+
+            /* write the object file directly, rather than assembling it, when
+             * the blob needs nothing but its data (and the host is ELF). */
+            bool native_object = true;
+
+            bool zero_copy = false;
+            bool paging = false;
+            bool sparse = false;
+            bool registry = false;
+            bool injected = false;
+            bool json_tape = false;
+            bool index_lines = false;
+            char delimiter = '\n';
+            element::type element_type = element::type::none;
+            std::string source_endian = element::ENDIAN_NATIVE;
+            std::vector<std::string> filters;
+
+            /* the accessor and lookup functions count their calls (per blob,
+             * and per member of a directory), for emblob_{name}_profile_dump. */
+            bool profile = false;
+
+            /* the input file is an archive (tar, gzip-compressed tar, or zip),
+             * whose members (or those which match any of archive_members) are
+             * embedded as a directory's files would be. */
+            bool archive = false;
+            std::vector<std::string> archive_members;
+
+            /* directories (and archives) only. */
+            bool compress_deflate = false;
+            bool http = false;
+            std::vector<std::string> http_encodings;
+
+            /* if not empty, the blob is written to this pack file. */
+            std::string pack_file;
+        };
+
+        struct outputs {
+            sink header;   /* the text of emblob_{name}.h */
+            sink assembly; /* the text of {base}.S, if the object is assembled */
+            sink object;   /* the contents of {base}.o */
+        };
+
+        explicit generator(options opts);
+        ~generator();
+
+        generator(const generator&) = delete;
+        generator& operator=(const generator&) = delete;
+
+        bool generate_file(const std::string& path, const outputs& out);
+        bool generate_buffer(const void* data, size_t len, const outputs& out);
+        /* reads fd to its end in READ_CHUNK pieces, writing each straight to
+         * the object file (or, if the object has to be assembled, to the
+         * payload file), so that the input is never held in memory whole. */
+        bool generate_fd(int fd, const outputs& out);
+
+        /* the files which the last generation left behind (intermediate files
+         * which were kept, and the pack file). */
+        const std::vector<std::string>& created_files() const {
+            return _created;
+        }
+
+        /* the name of the header file for a blob of the given name. */
+        static std::string header_filename(const std::string& name);
+
+        static sink to_string(std::string& str);
+        static sink to_file(const std::string& fname);
+
+    private:
+        struct context;
+
+        /* temporary files are always removed, intermediate files unless they
+         * are to be kept, and products (the pack file) only upon failure. */
+        enum class file_kind {
+            temporary,
+            intermediate,
+            product
+        };
+
+        bool _generate(context& ctx, const outputs& out);
+        bool _validate(const context& ctx) const;
+        bool _prepare_blob(context& ctx);
+        bool _write_pack_file(context& ctx);
+        std::string _render_header(context& ctx) const;
+        std::string _render_asm(context& ctx) const;
+        bool _native_object(const context& ctx) const;
+        uint64_t _profile_entries(const context& ctx) const;
+        bool _assemble(context& ctx, const outputs& out);
+        bool _stream_object(context& ctx, const outputs& out);
+        bool _deliver_file(const std::string& fname, const sink& to) const;
+        static bool _read_fd(int fd, const sink& to, size_t& total);
+        void _track(const std::string& fname, file_kind kind);
+        void _cleanup(bool success);
+
+        options _opts;
+        std::vector<std::string> _created;
+        std::vector<std::pair<std::string, file_kind>> _files;
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_GENERATOR_HH_INCLUDED
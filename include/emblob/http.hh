@@ -0,0 +1,225 @@
+/*
+ * http.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_HTTP_HH_INCLUDED
+# define _EMBLOB_HTTP_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/compress.hh"
+
+# include <array>
+# include <bit>
+
+namespace emblob
+{
+    /* the response metadata which is recorded for each member of a directory
+     * when --http is given: its MIME type, a strong ETag, and precompressed
+     * variants in the requested content codings. */
+    class http
+    {
+    public:
+        CONST_STATIC_STRING ENCODING_IDENTITY = "identity";
+        CONST_STATIC_STRING ENCODING_GZIP     = "gzip";
+        CONST_STATIC_STRING ENCODING_BR       = "br";
+
+        CONST_STATIC_STRING DEFAULT_MIME_TYPE = "application/octet-stream";
+
+        /* variant v is EMBLOB_ENCODING_* v + 1 in the generated header. */
+        enum variant : size_t {
+            gzip = 0,
+            br,
+            variant_count
+        };
+
+        http() = delete;
+        ~http() = delete;
+
+        static std::vector<std::string> available_encodings() {
+            std::vector<std::string> encodings { ENCODING_IDENTITY };
+# if defined(EMBLOB_HAVE_ZLIB)
+            encodings.push_back(ENCODING_GZIP);
+# endif
+# if defined(EMBLOB_HAVE_BROTLI)
+            encodings.push_back(ENCODING_BR);
+# endif
+            return encodings;
+        }
+
+        /* compresses data in the given coding; returns false upon failure. */
+        static bool compress(variant v, [[maybe_unused]] const std::string& data,
+            [[maybe_unused]] std::string& out) {
+            switch (v) {
+# if defined(EMBLOB_HAVE_ZLIB)
+                case gzip: return gzip_codec::compress(data, out);
+# endif
+# if defined(EMBLOB_HAVE_BROTLI)
+                case br: return brotli_codec::compress(data, out);
+# endif
+                default: return false;
+            }
+        }
+
+        /* the MIME type of a file, by its extension. text types are given a
+         * charset, since the contents are served verbatim. */
+        static std::string mime_type(const std::string& name) {
+            static const std::pair<const char*, const char*> types[] = {
+                { "html",  "text/html; charset=utf-8" },
+                { "htm",   "text/html; charset=utf-8" },
+                { "css",   "text/css; charset=utf-8" },
+                { "js",    "text/javascript; charset=utf-8" },
+                { "mjs",   "text/javascript; charset=utf-8" },
+                { "json",  "application/json" },
+                { "map",   "application/json" },
+                { "xml",   "application/xml" },
+                { "txt",   "text/plain; charset=utf-8" },
+                { "md",    "text/markdown; charset=utf-8" },
+                { "csv",   "text/csv; charset=utf-8" },
+                { "svg",   "image/svg+xml" },
+                { "png",   "image/png" },
+                { "jpg",   "image/jpeg" },
+                { "jpeg",  "image/jpeg" },
+                { "gif",   "image/gif" },
+                { "webp",  "image/webp" },
+                { "avif",  "image/avif" },
+                { "ico",   "image/vnd.microsoft.icon" },
+                { "woff",  "font/woff" },
+                { "woff2", "font/woff2" },
+                { "ttf",   "font/ttf" },
+                { "otf",   "font/otf" },
+                { "wasm",  "application/wasm" },
+                { "pdf",   "application/pdf" },
+                { "zip",   "application/zip" },
+                { "gz",    "application/gzip" },
+                { "mp3",   "audio/mpeg" },
+                { "mp4",   "video/mp4" },
+                { "webm",  "video/webm" },
+            };
+
+            auto slash = name.find_last_of('/');
+            auto dot   = name.find_last_of('.');
+            if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+                return DEFAULT_MIME_TYPE;
+            }
+
+            auto ext = string_to_lower(name.substr(dot + 1));
+            for (const auto& t : types) {
+                if (ext == t.first) {
+                    return t.second;
+                }
+            }
+
+            return DEFAULT_MIME_TYPE;
+        }
+
+        /* a strong ETag (quoted, as it appears in a header): the first 128 bits
+         * of the SHA-256 digest of the contents, in hexadecimal. */
+        static std::string etag(const std::string& data) {
+            auto digest = _sha256(data);
+            std::string tag = "\"";
+            for (size_t n = 0; n < 16; n++) {
+                tag += fmt_str("%02x", digest[n]);
+            }
+
+            return tag + "\"";
+        }
+
+    private:
+        static std::array<uint8_t, 32> _sha256(const std::string& data) {
+            static constexpr uint32_t k[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+            };
+
+            uint32_t h[8] = {
+                0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+            };
+
+            /* the message, padded to a multiple of 64 bytes: a 1 bit, zeros, and
+             * its length in bits (big-endian). */
+            std::string msg = data;
+            uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+            msg.push_back(static_cast<char>(0x80));
+            while (msg.size() % 64 != 56) {
+                msg.push_back('\0');
+            }
+            for (int n = 7; n >= 0; n--) {
+                msg.push_back(static_cast<char>((bits >> (n * 8)) & 0xff));
+            }
+
+            for (size_t block = 0; block < msg.size(); block += 64) {
+                uint32_t w[64];
+                for (size_t n = 0; n < 16; n++) {
+                    auto p = reinterpret_cast<const uint8_t*>(msg.data() + block + n * 4);
+                    w[n] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+                }
+                for (size_t n = 16; n < 64; n++) {
+                    uint32_t s0 = std::rotr(w[n - 15], 7) ^ std::rotr(w[n - 15], 18) ^ (w[n - 15] >> 3);
+                    uint32_t s1 = std::rotr(w[n - 2], 17) ^ std::rotr(w[n - 2], 19) ^ (w[n - 2] >> 10);
+                    w[n] = w[n - 16] + s0 + w[n - 7] + s1;
+                }
+
+                uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+                for (size_t n = 0; n < 64; n++) {
+                    uint32_t s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+                    uint32_t ch = (e & f) ^ (~e & g);
+                    uint32_t t1 = hh + s1 + ch + k[n] + w[n];
+                    uint32_t s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+                    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+                    uint32_t t2 = s0 + maj;
+
+                    hh = g;
+                    g  = f;
+                    f  = e;
+                    e  = d + t1;
+                    d  = c;
+                    c  = b;
+                    b  = a;
+                    a  = t1 + t2;
+                }
+
+                h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+                h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+            }
+
+            std::array<uint8_t, 32> digest {};
+            for (size_t n = 0; n < 8; n++) {
+                digest[n * 4]     = static_cast<uint8_t>(h[n] >> 24);
+                digest[n * 4 + 1] = static_cast<uint8_t>(h[n] >> 16);
+                digest[n * 4 + 2] = static_cast<uint8_t>(h[n] >> 8);
+                digest[n * 4 + 3] = static_cast<uint8_t>(h[n]);
+            }
+
+            return digest;
+        }
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_HTTP_HH_INCLUDED
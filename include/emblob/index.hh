@@ -0,0 +1,191 @@
+/*
+ * index.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_INDEX_HH_INCLUDED
+# define _EMBLOB_INDEX_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+
+namespace emblob
+{
+    /* the offsets of delimited records (e.g. lines) within the input file.
+     *
+     * the offsets are stored in blocks of BLOCK_SIZE records: each block has an
+     * absolute 64-bit base offset, and each record has an offset relative to its
+     * block's base, stored in the narrowest integer type (1, 2, 4, or 8 bytes)
+     * that is able to represent every relative offset. looking up a record is
+     * therefore O(1): base[i / BLOCK_SIZE] + rel[i].
+     *
+     * one extra (sentinel) offset is stored following the last record, so that
+     * the length of record i is always offset(i + 1) - offset(i) - 1. */
+    class record_index
+    {
+    public:
+        CONST_STATIC_X(size_t) BLOCK_SHIFT = 6;
+        CONST_STATIC_X(size_t) BLOCK_SIZE  = size_t(1) << BLOCK_SHIFT;
+        CONST_STATIC_X(size_t) READ_CHUNK  = 1024 * 1024;
+
+        record_index() = default;
+        ~record_index() = default;
+
+        bool build(const std::string& fname, char delim) {
+            _offsets.clear();
+            _offsets.push_back(0);
+
+            std::ifstream strm(fname, std::ios::in | std::ios::binary);
+            if (!strm.is_open()) {
+                g_logger->error("failed to open %s: %s", fname.c_str(),
+                    system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            /* the scan for delimiters is done by memchr, which is vectorized by
+             * every libc worth using. */
+            std::vector<char> buf(READ_CHUNK);
+            uint64_t pos = 0;
+            bool ends_with_delim = false;
+
+            while (strm) {
+                strm.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+                auto got = static_cast<size_t>(strm.gcount());
+                if (got == 0) {
+                    break;
+                }
+
+                const char* cur = buf.data();
+                const char* end = buf.data() + got;
+                while (cur < end) {
+                    auto found = static_cast<const char*>(memchr(cur, delim, static_cast<size_t>(end - cur)));
+                    if (!found) {
+                        break;
+                    }
+
+                    _offsets.push_back(pos + static_cast<uint64_t>(found - buf.data()) + 1);
+                    cur = found + 1;
+                }
+
+                ends_with_delim = buf[got - 1] == delim;
+                pos += got;
+            }
+
+            if (strm.bad()) {
+                g_logger->error("failed to read %s", fname.c_str());
+                return false;
+            }
+
+            /* if the last record isn't terminated, it is terminated by a virtual
+             * delimiter following the end of the file. */
+            if (!ends_with_delim) {
+                _offsets.push_back(pos + 1);
+            }
+
+            _compute_rel_width();
+            return true;
+        }
+
+        uint64_t count() const {
+            return _offsets.empty() ? 0 : _offsets.size() - 1;
+        }
+
+        size_t rel_width() const {
+            return _rel_width;
+        }
+
+        size_t size_in_bytes() const {
+            return _num_blocks() * sizeof(uint64_t) + _offsets.size() * _rel_width;
+        }
+
+        const char* rel_type() const {
+            switch (_rel_width) {
+                case 1: return "uint8_t";
+                case 2: return "uint16_t";
+                case 4: return "uint32_t";
+                default: return "uint64_t";
+            }
+        }
+
+        void write_asm(std::ostream& strm, const std::string& lname) const {
+            static constexpr size_t per_line = 16;
+
+            strm << ".balign 8" << std::endl;
+            strm << ".global _" << lname << "_index_base" << std::endl;
+            strm << "_" << lname << "_index_base:" << std::endl;
+            for (size_t b = 0; b < _num_blocks(); b++) {
+                strm << ((b % per_line) == 0 ? ".quad " : ", ") << _offsets[b * BLOCK_SIZE];
+                if ((b % per_line) == per_line - 1 || b == _num_blocks() - 1) {
+                    strm << std::endl;
+                }
+            }
+
+            const char* directive = nullptr;
+            switch (_rel_width) {
+                case 1:  directive = ".byte ";  break;
+                case 2:  directive = ".short "; break;
+                case 4:  directive = ".long ";  break;
+                default: directive = ".quad ";  break;
+            }
+
+            strm << ".balign 8" << std::endl;
+            strm << ".global _" << lname << "_index_rel" << std::endl;
+            strm << "_" << lname << "_index_rel:" << std::endl;
+            for (size_t n = 0; n < _offsets.size(); n++) {
+                strm << ((n % per_line) == 0 ? directive : ", ")
+                     << _offsets[n] - _offsets[(n >> BLOCK_SHIFT) << BLOCK_SHIFT];
+                if ((n % per_line) == per_line - 1 || n == _offsets.size() - 1) {
+                    strm << std::endl;
+                }
+            }
+        }
+
+    private:
+        size_t _num_blocks() const {
+            return (_offsets.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        }
+
+        void _compute_rel_width() {
+            uint64_t max_rel = 0;
+            for (size_t n = 0; n < _offsets.size(); n++) {
+                max_rel = std::max(max_rel, _offsets[n] - _offsets[(n >> BLOCK_SHIFT) << BLOCK_SHIFT]);
+            }
+
+            if (max_rel <= std::numeric_limits<uint8_t>::max()) {
+                _rel_width = 1;
+            } else if (max_rel <= std::numeric_limits<uint16_t>::max()) {
+                _rel_width = 2;
+            } else if (max_rel <= std::numeric_limits<uint32_t>::max()) {
+                _rel_width = 4;
+            } else {
+                _rel_width = 8;
+            }
+        }
+
+        std::vector<uint64_t> _offsets;
+        size_t _rel_width = 1;
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_INDEX_HH_INCLUDED
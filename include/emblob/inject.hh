@@ -0,0 +1,436 @@
+/*
+ * inject.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_INJECT_HH_INCLUDED
+# define _EMBLOB_INJECT_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+
+# if !defined(__MACOS__)
+#  include <elf.h>
+# endif
+
+namespace emblob
+{
+# if !defined(__MACOS__)
+    /* adds blobs to an ELF executable which has already been linked, as a
+     * read-only PT_LOAD segment (and an .emblob section, for the benefit of
+     * tools) appended to the end of the file. the executable's code finds the
+     * segment at runtime by walking its own program headers.
+     *
+     * since there is rarely room for another program header, an unused one
+     * (PT_NULL) or a redundant one (a PT_NOTE which a PT_GNU_PROPERTY entry
+     * duplicates) is repurposed, or failing that, any PT_NOTE. injecting into
+     * an executable which was injected into previously replaces its blobs. */
+    class elf_injector
+    {
+    public:
+        CONST_STATIC_X(uint64_t) MAGIC          = 0x4753424f4c424d45ULL; /* "EMBLOBSG" */
+        CONST_STATIC_X(uint32_t) VERSION        = 1;
+        CONST_STATIC_X(uint64_t) HEADER_SIZE    = 64;
+        CONST_STATIC_X(uint64_t) ENTRY_SIZE     = 32;
+        CONST_STATIC_X(uint64_t) BLOB_ALIGNMENT = 64;
+        CONST_STATIC_X(uint64_t) PAGE_SIZE      = 4096;
+        CONST_STATIC_STRING SECTION_NAME = ".emblob";
+
+        /* the size of emblob_inject_state, which the assembly file reserves. */
+        CONST_STATIC_X(size_t) STATE_SIZE = 32;
+
+        /* must match emblob_inject_header in the generated header. the fields
+         * which begin with orig_ describe the executable before it was first
+         * injected into, so that injecting again can restore it first. */
+        struct header {
+            uint64_t magic = MAGIC;
+            uint32_t version = VERSION;
+            uint32_t count = 0;
+            uint64_t size = 0;
+            uint64_t entries_offset = HEADER_SIZE;
+            uint64_t orig_file_size = 0;
+            uint64_t orig_shoff = 0;
+            uint32_t orig_shnum = 0;
+            uint32_t orig_shstrndx = 0;
+            uint64_t reserved = 0;
+        };
+
+        /* must match emblob_inject_entry. offsets are from the beginning of
+         * the segment. */
+        struct entry {
+            uint64_t name_offset = 0;
+            uint64_t name_len = 0;
+            uint64_t offset = 0;
+            uint64_t size = 0;
+        };
+
+        static_assert(sizeof(header) == HEADER_SIZE);
+        static_assert(sizeof(entry) == ENTRY_SIZE);
+
+        struct blob {
+            std::string name;
+            std::string fname;
+        };
+
+        elf_injector() = delete;
+        ~elf_injector() = delete;
+
+        /* parses a blob argument: either a path (in which case the blob is
+         * named as emblob would name it, after the path's basename) or
+         * name=path. */
+        static blob parse_blob(const std::string& arg) {
+            blob b;
+            if (auto eq = arg.find('='); eq != std::string::npos && eq > 0) {
+                b.name  = arg.substr(0, eq);
+                b.fname = arg.substr(eq + 1);
+            } else {
+                b.name  = system::file_base_name(arg);
+                b.fname = arg;
+            }
+
+            b.name = string_to_lower(system::sanitize_base_name(b.name));
+            return b;
+        }
+
+        static bool inject(const std::string& exe_file, const std::vector<blob>& blobs) {
+            std::string image;
+            if (!_read_file(exe_file, image)) {
+                return false;
+            }
+
+            if (!_validate(exe_file, image)) {
+                return false;
+            }
+
+            auto* ehdr = reinterpret_cast<Elf64_Ehdr*>(image.data());
+            auto* phdrs = reinterpret_cast<Elf64_Phdr*>(image.data() + ehdr->e_phoff);
+            std::vector<Elf64_Phdr> table(phdrs, phdrs + ehdr->e_phnum);
+
+            /* undo a previous injection. */
+            header hdr;
+            int slot = _find_injected(image, table);
+            if (slot != -1) {
+                header prev {};
+                memcpy(&prev, image.data() + table[slot].p_offset, sizeof(prev));
+                g_logger->info("replacing the %u blob(s) previously injected into %s", prev.count,
+                    exe_file.c_str());
+
+                hdr.orig_file_size = prev.orig_file_size;
+                hdr.orig_shoff     = prev.orig_shoff;
+                hdr.orig_shnum     = prev.orig_shnum;
+                hdr.orig_shstrndx  = prev.orig_shstrndx;
+
+                image.resize(prev.orig_file_size);
+                ehdr = reinterpret_cast<Elf64_Ehdr*>(image.data());
+                ehdr->e_shoff    = prev.orig_shoff;
+                ehdr->e_shnum    = static_cast<Elf64_Half>(prev.orig_shnum);
+                ehdr->e_shstrndx = static_cast<Elf64_Half>(prev.orig_shstrndx);
+            } else {
+                hdr.orig_file_size = image.size();
+                hdr.orig_shoff     = ehdr->e_shoff;
+                hdr.orig_shnum     = ehdr->e_shnum;
+                hdr.orig_shstrndx  = ehdr->e_shstrndx;
+
+                if (slot = _find_free_slot(table); slot == -1) {
+                    g_logger->error("%s has no program header which can be repurposed", exe_file.c_str());
+                    return false;
+                }
+
+                if (table[slot].p_type == PT_NOTE && !_is_redundant_note(table, slot)) {
+                    g_logger->warning("repurposing the PT_NOTE program header at offset %" PRIu64
+                        " of %s", static_cast<uint64_t>(table[slot].p_offset), exe_file.c_str());
+                }
+            }
+
+            /* the contents of the segment. */
+            std::string segment;
+            if (!_build_segment(blobs, hdr, segment)) {
+                return false;
+            }
+
+            /* the segment must not overlap any other (in memory or in the
+             * file), and its offset and address must be congruent modulo the
+             * alignment of the executable's other segments. */
+            uint64_t align = PAGE_SIZE;
+            uint64_t end = 0;
+            for (int n = 0; n < static_cast<int>(table.size()); n++) {
+                if (n != slot && table[n].p_type == PT_LOAD) {
+                    align = std::max<uint64_t>(align, table[n].p_align);
+                    end = std::max<uint64_t>(end, table[n].p_vaddr + table[n].p_memsz);
+                }
+            }
+
+            uint64_t offset = _align_up(image.size(), BLOB_ALIGNMENT);
+            uint64_t vaddr  = _align_up(end, align) + offset % align;
+
+            Elf64_Phdr seg {};
+            seg.p_type   = PT_LOAD;
+            seg.p_flags  = PF_R;
+            seg.p_offset = offset;
+            seg.p_vaddr  = vaddr;
+            seg.p_paddr  = vaddr;
+            seg.p_filesz = segment.size();
+            seg.p_memsz  = segment.size();
+            seg.p_align  = align;
+
+            /* PT_LOAD entries must be sorted by address, so the repurposed entry
+             * is moved to follow the last of them. */
+            table.erase(table.begin() + slot);
+            auto last_load = std::find_if(table.rbegin(), table.rend(), [](const Elf64_Phdr& p) {
+                return p.p_type == PT_LOAD;
+            });
+            table.insert(last_load.base(), seg);
+            memcpy(image.data() + ehdr->e_phoff, table.data(), table.size() * sizeof(Elf64_Phdr));
+
+            image.append(offset - image.size(), '\0');
+            image.append(segment);
+
+            _append_section(image, seg);
+
+            return _write_file(exe_file, image);
+        }
+
+    private:
+        static uint64_t _align_up(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        static bool _validate(const std::string& exe_file, const std::string& image) {
+            if (image.size() < sizeof(Elf64_Ehdr) || 0 != memcmp(image.data(), ELFMAG, SELFMAG)) {
+                g_logger->error("%s is not an ELF file", exe_file.c_str());
+                return false;
+            }
+
+            const auto* ehdr = reinterpret_cast<const Elf64_Ehdr*>(image.data());
+            uint16_t probe = 1;
+            auto native_data = *reinterpret_cast<const uint8_t*>(&probe) == 1 ? ELFDATA2LSB : ELFDATA2MSB;
+            if (ehdr->e_ident[EI_CLASS] != ELFCLASS64 || ehdr->e_ident[EI_DATA] != native_data) {
+                g_logger->error("%s is not a 64-bit ELF file of this machine's byte order",
+                    exe_file.c_str());
+                return false;
+            }
+
+            if (ehdr->e_type != ET_EXEC && ehdr->e_type != ET_DYN) {
+                g_logger->error("%s is not an executable", exe_file.c_str());
+                return false;
+            }
+
+            if (ehdr->e_phentsize != sizeof(Elf64_Phdr) || ehdr->e_phoff > image.size() ||
+                ehdr->e_phnum * sizeof(Elf64_Phdr) > image.size() - ehdr->e_phoff) {
+                g_logger->error("%s has an invalid program header table", exe_file.c_str());
+                return false;
+            }
+
+            return true;
+        }
+
+        /* the index of the program header which describes a previously
+         * injected segment, or -1. */
+        static int _find_injected(const std::string& image, const std::vector<Elf64_Phdr>& table) {
+            for (int n = 0; n < static_cast<int>(table.size()); n++) {
+                const auto& p = table[n];
+                if (p.p_type != PT_LOAD || p.p_flags != PF_R || p.p_filesz < HEADER_SIZE ||
+                    p.p_offset > image.size() - HEADER_SIZE) {
+                    continue;
+                }
+
+                header h {};
+                memcpy(&h, image.data() + p.p_offset, sizeof(h));
+                if (h.magic == MAGIC && h.version == VERSION && h.orig_file_size <= p.p_offset) {
+                    return n;
+                }
+            }
+
+            return -1;
+        }
+
+        /* a PT_NOTE entry which describes the same notes as a PT_GNU_PROPERTY
+         * entry is redundant. */
+        static bool _is_redundant_note(const std::vector<Elf64_Phdr>& table, int n) {
+            return std::ranges::any_of(table, [&note = table[n]](const Elf64_Phdr& p) {
+                return p.p_type == PT_GNU_PROPERTY && p.p_offset == note.p_offset &&
+                    p.p_filesz == note.p_filesz;
+            });
+        }
+
+        static int _find_free_slot(const std::vector<Elf64_Phdr>& table) {
+            int note = -1;
+            for (int n = 0; n < static_cast<int>(table.size()); n++) {
+                if (table[n].p_type == PT_NULL) {
+                    return n;
+                }
+            }
+
+            for (int n = 0; n < static_cast<int>(table.size()); n++) {
+                if (table[n].p_type == PT_NOTE) {
+                    if (_is_redundant_note(table, n)) {
+                        return n;
+                    }
+
+                    note = n;
+                }
+            }
+
+            return note;
+        }
+
+        static bool _build_segment(const std::vector<blob>& blobs, header& hdr, std::string& segment) {
+            std::vector<entry> entries(blobs.size());
+            std::string names;
+            for (size_t n = 0; n < blobs.size(); n++) {
+                entries[n].name_offset = names.size();
+                entries[n].name_len    = blobs[n].name.size();
+                names.append(blobs[n].name);
+                names.push_back('\0');
+            }
+
+            uint64_t names_offset = HEADER_SIZE + blobs.size() * ENTRY_SIZE;
+            uint64_t size = _align_up(names_offset + names.size(), BLOB_ALIGNMENT);
+
+            std::vector<std::string> contents(blobs.size());
+            for (size_t n = 0; n < blobs.size(); n++) {
+                if (!_read_file(blobs[n].fname, contents[n])) {
+                    return false;
+                }
+
+                entries[n].name_offset += names_offset;
+                entries[n].offset = size;
+                entries[n].size   = contents[n].size();
+                size = _align_up(size + contents[n].size(), BLOB_ALIGNMENT);
+
+                g_logger->info("injecting %s as '%s' (%zu bytes)", blobs[n].fname.c_str(),
+                    blobs[n].name.c_str(), contents[n].size());
+            }
+
+            hdr.count = static_cast<uint32_t>(blobs.size());
+            hdr.size  = size;
+
+            segment.reserve(size);
+            segment.append(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+            segment.append(reinterpret_cast<const char*>(entries.data()), entries.size() * ENTRY_SIZE);
+            segment.append(names);
+            for (size_t n = 0; n < blobs.size(); n++) {
+                segment.append(entries[n].offset - segment.size(), '\0');
+                segment.append(contents[n]);
+            }
+
+            segment.append(size - segment.size(), '\0');
+            return true;
+        }
+
+        /* appends a copy of the section header table (and of the section name
+         * string table), with a section which describes the segment. tools
+         * such as readelf and objdump then show the blobs, but the executable
+         * does not depend upon this. */
+        static void _append_section(std::string& image, const Elf64_Phdr& seg) {
+            auto* ehdr = reinterpret_cast<Elf64_Ehdr*>(image.data());
+            if (ehdr->e_shoff == 0 || ehdr->e_shentsize != sizeof(Elf64_Shdr) ||
+                ehdr->e_shnum == 0 || ehdr->e_shnum >= SHN_LORESERVE - 1 ||
+                ehdr->e_shstrndx >= ehdr->e_shnum ||
+                ehdr->e_shoff + ehdr->e_shnum * sizeof(Elf64_Shdr) > image.size()) {
+                return;
+            }
+
+            const auto* shdrs = reinterpret_cast<const Elf64_Shdr*>(image.data() + ehdr->e_shoff);
+            std::vector<Elf64_Shdr> sections(shdrs, shdrs + ehdr->e_shnum);
+
+            auto& strtab = sections[ehdr->e_shstrndx];
+            if (strtab.sh_offset + strtab.sh_size > image.size()) {
+                return;
+            }
+
+            std::string names = image.substr(strtab.sh_offset, strtab.sh_size);
+            auto name_offset = names.size();
+            names.append(SECTION_NAME);
+            names.push_back('\0');
+
+            strtab.sh_offset = image.size();
+            strtab.sh_size   = names.size();
+            image.append(names);
+
+            Elf64_Shdr sec {};
+            sec.sh_name      = static_cast<Elf64_Word>(name_offset);
+            sec.sh_type      = SHT_PROGBITS;
+            sec.sh_flags     = SHF_ALLOC;
+            sec.sh_addr      = seg.p_vaddr;
+            sec.sh_offset    = seg.p_offset;
+            sec.sh_size      = seg.p_filesz;
+            sec.sh_addralign = BLOB_ALIGNMENT;
+            sections.push_back(sec);
+
+            image.append(_align_up(image.size(), 8) - image.size(), '\0');
+
+            ehdr = reinterpret_cast<Elf64_Ehdr*>(image.data());
+            ehdr->e_shoff = image.size();
+            ehdr->e_shnum = static_cast<Elf64_Half>(sections.size());
+            image.append(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(Elf64_Shdr));
+        }
+
+        static bool _read_file(const std::string& fname, std::string& contents) {
+            std::ifstream strm(fname, std::ios::in | std::ios::binary);
+            if (!strm.is_open()) {
+                g_logger->error("failed to open %s: %s", fname.c_str(),
+                    system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            contents.assign(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+            if (strm.bad()) {
+                g_logger->error("failed to read %s", fname.c_str());
+                return false;
+            }
+
+            return true;
+        }
+
+        /* the executable is replaced (keeping its mode) only once the new one
+         * has been written in full. */
+        static bool _write_file(const std::string& exe_file, const std::string& image) {
+            struct stat st {};
+            if (0 != stat(exe_file.c_str(), &st)) {
+                g_logger->error("couldn't stat %s; error: %s", exe_file.c_str(),
+                    system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            auto tmp_file = exe_file + ".emblob-tmp";
+            auto wrote = system::write_file_contents(tmp_file, std::ios::out | std::ios::trunc |
+                std::ios::binary, [&image](std::ostream& strm) {
+                strm.write(image.data(), static_cast<std::streamsize>(image.size()));
+            });
+
+            if (wrote == std::ofstream::pos_type(-1) || 0 != chmod(tmp_file.c_str(), st.st_mode & 07777) ||
+                0 != rename(tmp_file.c_str(), exe_file.c_str())) {
+                g_logger->error("failed to write %s", exe_file.c_str());
+                [[maybe_unused]] int ret = remove(tmp_file.c_str());
+                return false;
+            }
+
+            return true;
+        }
+    };
+# endif // !__MACOS__
+} // !namespace emblob
+
+#endif // !_EMBLOB_INJECT_HH_INCLUDED
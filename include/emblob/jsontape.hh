@@ -0,0 +1,550 @@
+/*
+ * jsontape.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_JSONTAPE_HH_INCLUDED
+# define _EMBLOB_JSONTAPE_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+
+# include <bit>
+# include <charconv>
+# include <unordered_map>
+
+namespace emblob
+{
+    /* a validated JSON document, flattened into a tape of 64-bit words which
+     * can be walked at runtime without tokenizing or allocating.
+     *
+     * the top 8 bits of each word hold its type; the remaining 56 bits hold a
+     * payload, whose meaning depends upon the type:
+     *
+     *   '{', '[': the number of members/elements in bits 32-55 (saturated at
+     *             COUNT_MAX), and the index of the matching close word in bits
+     *             0-31.
+     *   '}', ']': the index of the matching open word.
+     *   's':      the offset of the (decoded, NUL-terminated) string in the
+     *             string pool. the following word holds its length.
+     *   'l', 'u', 'd': nothing; the following word holds the int64_t, uint64_t,
+     *             or double value.
+     *   'n', 't', 'f': nothing.
+     *
+     * the tape ends with a zero word, so that stepping past the root value
+     * always lands on a word of an invalid type. */
+    class json_tape
+    {
+    public:
+        CONST_STATIC_X(char) TYPE_NULL   = 'n';
+        CONST_STATIC_X(char) TYPE_TRUE   = 't';
+        CONST_STATIC_X(char) TYPE_FALSE  = 'f';
+        CONST_STATIC_X(char) TYPE_INT64  = 'l';
+        CONST_STATIC_X(char) TYPE_UINT64 = 'u';
+        CONST_STATIC_X(char) TYPE_DOUBLE = 'd';
+        CONST_STATIC_X(char) TYPE_STRING = 's';
+
+        CONST_STATIC_X(uint64_t) COUNT_MAX = 0xffffff;
+        CONST_STATIC_X(size_t) MAX_DEPTH   = 1024;
+
+        json_tape() = default;
+        ~json_tape() = default;
+
+        bool build(const std::string& fname) {
+            _tape.clear();
+            _strings.clear();
+            _interned.clear();
+
+            std::ifstream strm(fname, std::ios::in | std::ios::binary);
+            if (!strm.is_open()) {
+                g_logger->error("failed to open %s: %s", fname.c_str(),
+                    system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            std::string text((std::istreambuf_iterator<char>(strm)), std::istreambuf_iterator<char>());
+            if (strm.bad()) {
+                g_logger->error("failed to read %s", fname.c_str());
+                return false;
+            }
+
+            _begin = text.data();
+            _cur   = _begin;
+            _end   = _begin + text.size();
+            _error.clear();
+
+            bool ok = _skip_whitespace() && _parse_value(0);
+            if (ok) {
+                _skip_whitespace();
+                if (_cur != _end) {
+                    ok = _fail("unexpected data following the root value");
+                }
+            }
+
+            if (ok && _tape.size() > std::numeric_limits<uint32_t>::max()) {
+                ok = _fail("the document is too large");
+            }
+
+            if (!ok) {
+                auto [line, column] = _position();
+                g_logger->error("%s:%zu:%zu: invalid JSON: %s", fname.c_str(), line, column,
+                    _error.c_str());
+                return false;
+            }
+
+            _tape.push_back(0);
+            return true;
+        }
+
+        size_t word_count() const {
+            return _tape.size();
+        }
+
+        size_t strings_size() const {
+            return _strings.size();
+        }
+
+        size_t size_in_bytes() const {
+            return _tape.size() * sizeof(uint64_t) + _strings.size();
+        }
+
+        void write_asm(std::ostream& strm, const std::string& lname) const {
+            static constexpr size_t words_per_line = 8;
+            static constexpr size_t bytes_per_line = 64;
+
+            strm << ".balign 8" << std::endl;
+            strm << ".global _" << lname << "_tape" << std::endl;
+            strm << "_" << lname << "_tape:" << std::endl;
+
+            auto old_flags = strm.flags();
+            strm << std::hex;
+            for (size_t n = 0; n < _tape.size(); n++) {
+                strm << ((n % words_per_line) == 0 ? ".quad 0x" : ", 0x") << _tape[n];
+                if ((n % words_per_line) == words_per_line - 1 || n == _tape.size() - 1) {
+                    strm << std::endl;
+                }
+            }
+            strm.flags(old_flags);
+
+            strm << ".global _" << lname << "_tape_strings" << std::endl;
+            strm << "_" << lname << "_tape_strings:" << std::endl;
+            for (size_t n = 0; n < _strings.size(); n += bytes_per_line) {
+                strm << ".ascii \"";
+                for (size_t b = n; b < std::min(n + bytes_per_line, _strings.size()); b++) {
+                    auto c = static_cast<unsigned char>(_strings[b]);
+                    if (c == '"' || c == '\\') {
+                        strm << '\\' << static_cast<char>(c);
+                    } else if (c >= 0x20 && c < 0x7f) {
+                        strm << static_cast<char>(c);
+                    } else {
+                        strm << fmt_str("\\%03o", c);
+                    }
+                }
+                strm << "\"" << std::endl;
+            }
+
+            /* so that the symbol is valid even if there are no strings. */
+            strm << ".byte 0" << std::endl;
+        }
+
+    private:
+        static uint64_t _word(char type, uint64_t payload) {
+            return (static_cast<uint64_t>(static_cast<unsigned char>(type)) << 56) | payload;
+        }
+
+        bool _fail(const char* msg) {
+            if (_error.empty()) {
+                _error = msg;
+            }
+
+            return false;
+        }
+
+        std::pair<size_t, size_t> _position() const {
+            size_t line = 1;
+            size_t column = 1;
+            for (const char* p = _begin; p < _cur; p++) {
+                if (*p == '\n') {
+                    line++;
+                    column = 1;
+                } else {
+                    column++;
+                }
+            }
+
+            return { line, column };
+        }
+
+        bool _skip_whitespace() {
+            while (_cur < _end && (*_cur == ' ' || *_cur == '\t' || *_cur == '\n' || *_cur == '\r')) {
+                _cur++;
+            }
+
+            return true;
+        }
+
+        bool _literal(const char* lit, char type) {
+            auto len = strlen(lit);
+            if (static_cast<size_t>(_end - _cur) < len || 0 != memcmp(_cur, lit, len)) {
+                return _fail("invalid literal");
+            }
+
+            _cur += len;
+            _tape.push_back(_word(type, 0));
+            return true;
+        }
+
+        bool _parse_value(size_t depth) {
+            if (_cur == _end) {
+                return _fail("unexpected end of input");
+            }
+
+            switch (*_cur) {
+                case '{': return _parse_container(depth, '{', '}');
+                case '[': return _parse_container(depth, '[', ']');
+                case '"': return _parse_string();
+                case 't': return _literal("true", TYPE_TRUE);
+                case 'f': return _literal("false", TYPE_FALSE);
+                case 'n': return _literal("null", TYPE_NULL);
+                default:
+                    if (*_cur == '-' || (*_cur >= '0' && *_cur <= '9')) {
+                        return _parse_number();
+                    }
+                    return _fail("unexpected character");
+            }
+        }
+
+        bool _parse_container(size_t depth, char open, char close) {
+            if (depth >= MAX_DEPTH) {
+                return _fail("maximum nesting depth exceeded");
+            }
+
+            auto open_idx = _tape.size();
+            _tape.push_back(0);
+            _cur++;
+            _skip_whitespace();
+
+            uint64_t count = 0;
+            if (_cur < _end && *_cur == close) {
+                _cur++;
+            } else {
+                while (true) {
+                    if (open == '{') {
+                        if (_cur == _end || *_cur != '"') {
+                            return _fail("expected a string (member name)");
+                        }
+
+                        if (!_parse_string()) {
+                            return false;
+                        }
+
+                        _skip_whitespace();
+                        if (_cur == _end || *_cur != ':') {
+                            return _fail("expected ':'");
+                        }
+
+                        _cur++;
+                        _skip_whitespace();
+                    }
+
+                    if (!_parse_value(depth + 1)) {
+                        return false;
+                    }
+
+                    count++;
+                    _skip_whitespace();
+
+                    if (_cur == _end) {
+                        return _fail("unexpected end of input");
+                    } else if (*_cur == ',') {
+                        _cur++;
+                        _skip_whitespace();
+                    } else if (*_cur == close) {
+                        _cur++;
+                        break;
+                    } else {
+                        return _fail(open == '{' ? "expected ',' or '}'" : "expected ',' or ']'");
+                    }
+                }
+            }
+
+            auto close_idx = _tape.size();
+            _tape.push_back(_word(close, open_idx));
+            _tape[open_idx] = _word(open, (std::min(count, COUNT_MAX) << 32) |
+                (close_idx & std::numeric_limits<uint32_t>::max()));
+            return true;
+        }
+
+        static void _append_utf8(std::string& out, uint32_t cp) {
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            } else {
+                out.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            }
+        }
+
+        bool _parse_hex4(uint32_t& value) {
+            if (_end - _cur < 4) {
+                return _fail("truncated \\u escape");
+            }
+
+            auto res = std::from_chars(_cur, _cur + 4, value, 16);
+            if (res.ec != std::errc() || res.ptr != _cur + 4) {
+                return _fail("invalid \\u escape");
+            }
+
+            _cur += 4;
+            return true;
+        }
+
+        /* validates a multi-byte UTF-8 sequence beginning at _cur, and appends
+         * it to out. */
+        bool _copy_utf8(std::string& out) {
+            auto lead = static_cast<unsigned char>(*_cur);
+            size_t len = 0;
+            uint32_t cp = 0;
+
+            if (lead >= 0xc2 && lead <= 0xdf) {
+                len = 2; cp = lead & 0x1fu;
+            } else if (lead >= 0xe0 && lead <= 0xef) {
+                len = 3; cp = lead & 0x0fu;
+            } else if (lead >= 0xf0 && lead <= 0xf4) {
+                len = 4; cp = lead & 0x07u;
+            } else {
+                return _fail("invalid UTF-8");
+            }
+
+            if (static_cast<size_t>(_end - _cur) < len) {
+                return _fail("invalid UTF-8");
+            }
+
+            for (size_t n = 1; n < len; n++) {
+                auto c = static_cast<unsigned char>(_cur[n]);
+                if ((c & 0xc0) != 0x80) {
+                    return _fail("invalid UTF-8");
+                }
+
+                cp = (cp << 6) | (c & 0x3fu);
+            }
+
+            if ((len == 3 && (cp < 0x800 || (cp >= 0xd800 && cp <= 0xdfff))) ||
+                (len == 4 && (cp < 0x10000 || cp > 0x10ffff))) {
+                return _fail("invalid UTF-8");
+            }
+
+            out.append(_cur, len);
+            _cur += len;
+            return true;
+        }
+
+        bool _parse_string() {
+            _cur++;
+            std::string decoded;
+
+            while (true) {
+                /* copy runs of ordinary characters in one go. */
+                const char* run = _cur;
+                while (_cur < _end && *_cur != '"' && *_cur != '\\' &&
+                    static_cast<unsigned char>(*_cur) >= 0x20 && static_cast<unsigned char>(*_cur) < 0x80) {
+                    _cur++;
+                }
+
+                decoded.append(run, static_cast<size_t>(_cur - run));
+
+                if (_cur == _end) {
+                    return _fail("unterminated string");
+                }
+
+                auto c = static_cast<unsigned char>(*_cur);
+                if (c == '"') {
+                    _cur++;
+                    break;
+                } else if (c < 0x20) {
+                    return _fail("unescaped control character in string");
+                } else if (c >= 0x80) {
+                    if (!_copy_utf8(decoded)) {
+                        return false;
+                    }
+                    continue;
+                }
+
+                /* an escape sequence. */
+                _cur++;
+                if (_cur == _end) {
+                    return _fail("unterminated string");
+                }
+
+                switch (*_cur++) {
+                    case '"':  decoded.push_back('"');  break;
+                    case '\\': decoded.push_back('\\'); break;
+                    case '/':  decoded.push_back('/');  break;
+                    case 'b':  decoded.push_back('\b'); break;
+                    case 'f':  decoded.push_back('\f'); break;
+                    case 'n':  decoded.push_back('\n'); break;
+                    case 'r':  decoded.push_back('\r'); break;
+                    case 't':  decoded.push_back('\t'); break;
+                    case 'u': {
+                        uint32_t cp = 0;
+                        if (!_parse_hex4(cp)) {
+                            return false;
+                        }
+
+                        if (cp >= 0xd800 && cp <= 0xdbff) {
+                            uint32_t low = 0;
+                            if (_end - _cur < 2 || _cur[0] != '\\' || _cur[1] != 'u') {
+                                return _fail("unpaired surrogate in \\u escape");
+                            }
+
+                            _cur += 2;
+                            if (!_parse_hex4(low)) {
+                                return false;
+                            }
+
+                            if (low < 0xdc00 || low > 0xdfff) {
+                                return _fail("unpaired surrogate in \\u escape");
+                            }
+
+                            cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                        } else if (cp >= 0xdc00 && cp <= 0xdfff) {
+                            return _fail("unpaired surrogate in \\u escape");
+                        }
+
+                        _append_utf8(decoded, cp);
+                    }
+                    break;
+                    default:
+                        _cur--;
+                        return _fail("invalid escape sequence");
+                }
+            }
+
+            _tape.push_back(_word(TYPE_STRING, _intern(decoded)));
+            _tape.push_back(decoded.size());
+            return true;
+        }
+
+        /* identical strings (most often member names) are stored only once. */
+        uint64_t _intern(const std::string& str) {
+            if (auto it = _interned.find(str); it != _interned.end()) {
+                return it->second;
+            }
+
+            uint64_t offset = _strings.size();
+            _strings.append(str);
+            _strings.push_back('\0');
+            _interned.emplace(str, offset);
+            return offset;
+        }
+
+        bool _parse_number() {
+            const char* start = _cur;
+            bool integral = true;
+
+            if (*_cur == '-') {
+                _cur++;
+            }
+
+            auto digits = [this]() {
+                const char* p = _cur;
+                while (_cur < _end && *_cur >= '0' && *_cur <= '9') {
+                    _cur++;
+                }
+                return _cur != p;
+            };
+
+            if (_cur < _end && *_cur == '0') {
+                _cur++;
+                if (_cur < _end && *_cur >= '0' && *_cur <= '9') {
+                    return _fail("leading zeros are not permitted");
+                }
+            } else if (!digits()) {
+                return _fail("invalid number");
+            }
+
+            if (_cur < _end && *_cur == '.') {
+                integral = false;
+                _cur++;
+                if (!digits()) {
+                    return _fail("invalid number");
+                }
+            }
+
+            if (_cur < _end && (*_cur == 'e' || *_cur == 'E')) {
+                integral = false;
+                _cur++;
+                if (_cur < _end && (*_cur == '+' || *_cur == '-')) {
+                    _cur++;
+                }
+
+                if (!digits()) {
+                    return _fail("invalid number");
+                }
+            }
+
+            if (integral) {
+                if (int64_t i = 0; std::from_chars(start, _cur, i).ec == std::errc()) {
+                    _tape.push_back(_word(TYPE_INT64, 0));
+                    _tape.push_back(static_cast<uint64_t>(i));
+                    return true;
+                }
+
+                if (uint64_t u = 0; *start != '-' && std::from_chars(start, _cur, u).ec == std::errc()) {
+                    _tape.push_back(_word(TYPE_UINT64, 0));
+                    _tape.push_back(u);
+                    return true;
+                }
+            }
+
+            double d = 0.0;
+            if (std::from_chars(start, _cur, d).ec != std::errc()) {
+                _cur = start;
+                return _fail("number out of range");
+            }
+
+            _tape.push_back(_word(TYPE_DOUBLE, 0));
+            _tape.push_back(std::bit_cast<uint64_t>(d));
+            return true;
+        }
+
+        std::vector<uint64_t> _tape;
+        std::string _strings;
+        std::unordered_map<std::string, uint64_t> _interned;
+        const char* _begin = nullptr;
+        const char* _cur = nullptr;
+        const char* _end = nullptr;
+        std::string _error;
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_JSONTAPE_HH_INCLUDED
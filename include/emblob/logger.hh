@@ -99,6 +99,18 @@ namespace emblob
             }
         }
 
+        /* sends every message to stderr (e.g., so that stdout may be parsed). */
+        void set_use_stderr(bool use_stderr) {
+            _use_stderr = use_stderr;
+        }
+
+        /* where messages are written, instead of stdout and stderr (e.g., so
+         * that they may be returned to a client of --serve). */
+        void set_streams(std::ostream* out, std::ostream* err) {
+            _out = out;
+            _err = err;
+        }
+
         static std::string level_to_string(level lvl, bool prefix = false) {
             using enum level;
             switch (lvl) {
@@ -172,7 +184,8 @@ namespace emblob
                     return;
             }
 
-            std::ostream& strm = (lvl == level::error || lvl == level::fatal) ? std::cerr : std::cout;
+            std::ostream& strm = (_use_stderr || lvl == level::error || lvl == level::fatal)
+                ? *_err : *_out;
             strm << "\x1b[" << attr << ";" << fg_color << ";49m" << APP_NAME << " "
                 << level_to_string(lvl, true) << ": " << buf.data() << "\x1b[0m" << std::endl;
         }
@@ -182,10 +195,15 @@ namespace emblob
 # else
         level _level = level::info;
 # endif
+        bool _use_stderr = false;
+        std::ostream* _out = &std::cout;
+        std::ostream* _err = &std::cerr;
     };
 
+    /* per-thread, so that each request to a server (see server.hh) is logged
+     * at its own level, to its own client. */
     using logger_ptr = std::unique_ptr<logger>;
-    logger_ptr g_logger = std::make_unique<logger>();
+    inline thread_local logger_ptr g_logger = std::make_unique<logger>();
 
 } // !namespace emblob
 
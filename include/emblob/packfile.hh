@@ -0,0 +1,167 @@
+/*
+ * packfile.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_PACKFILE_HH_INCLUDED
+# define _EMBLOB_PACKFILE_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+# include "emblob/directory.hh"
+
+namespace emblob
+{
+    /* a standalone pack file, which the generated loader maps at runtime in
+     * place of a blob linked into the executable. it begins with a header
+     * (which describes everything else in the file, so that the pack may be
+     * regenerated without rebuilding the code that uses it), followed by the
+     * directory tables (if any), followed by the blob itself, at a page-aligned
+     * offset. all words are in the byte order of the machine which generated
+     * the pack. */
+    class pack_file
+    {
+    public:
+        CONST_STATIC_X(uint64_t) MAGIC           = 0x4b50424f4c424d45ULL; /* "EMBLOBPK" */
+        CONST_STATIC_X(uint32_t) VERSION         = 1;
+        CONST_STATIC_X(uint32_t) BYTE_ORDER_MARK = 0x01020304;
+        CONST_STATIC_X(uint64_t) HEADER_SIZE     = 128;
+        CONST_STATIC_X(uint64_t) BLOB_ALIGNMENT  = 4096;
+        CONST_STATIC_X(size_t) COPY_CHUNK        = 1024 * 1024;
+
+        /* the size of emblob_pack_state, which the assembly file reserves. */
+        CONST_STATIC_X(size_t) STATE_SIZE = 32;
+
+        /* must match emblob_pack_header in the generated header. */
+        struct header {
+            uint64_t magic = MAGIC;
+            uint32_t version = VERSION;
+            uint32_t byte_order = BYTE_ORDER_MARK;
+            uint64_t header_size = HEADER_SIZE;
+            uint64_t blob_offset = 0;
+            uint64_t blob_size = 0;
+            uint64_t member_count = 0;
+            uint64_t slot_mask = 0;
+            uint64_t members_offset = 0;
+            uint64_t slots_offset = 0;
+            uint64_t names_offset = 0;
+            uint64_t dictionary_offset = 0;
+            uint64_t dictionary_size = 0;
+            uint64_t http_offset = 0;
+            uint64_t http_strings_offset = 0;
+            uint64_t file_size = 0;
+            uint64_t reserved = 0;
+        };
+
+        static_assert(sizeof(header) == HEADER_SIZE);
+
+        pack_file() = delete;
+        ~pack_file() = delete;
+
+        /* writes the blob in blob_file, along with the tables of dir (if it is
+         * not null), to fname. */
+        static bool write(const std::string& fname, const std::string& blob_file, const directory_pack* dir) {
+            header hdr;
+            std::string tables;
+
+            /* the tables are laid out after the header; every offset is from
+             * the beginning of the file. */
+            auto append = [&](const void* data, size_t len, size_t alignment) {
+                tables.append((alignment - (tables.size() % alignment)) % alignment, '\0');
+                uint64_t offset = HEADER_SIZE + tables.size();
+                tables.append(static_cast<const char*>(data), len);
+                return offset;
+            };
+
+            /* tables which may be empty still get a valid offset. */
+            uint64_t empty = append("\0\0\0\0\0\0\0\0", 8, 8);
+            hdr.members_offset = hdr.slots_offset = hdr.names_offset = empty;
+            hdr.dictionary_offset = hdr.http_offset = hdr.http_strings_offset = empty;
+
+            if (dir) {
+                auto members = dir->member_words();
+                auto slots   = dir->slots();
+                auto names   = dir->names_pool();
+
+                hdr.member_count   = dir->members().size();
+                hdr.slot_mask      = slots.size() - 1;
+                hdr.members_offset = append(members.data(), members.size() * sizeof(uint64_t), 8);
+                hdr.slots_offset   = append(slots.data(), slots.size() * sizeof(uint32_t), 8);
+                hdr.names_offset   = append(names.data(), names.size(), 1);
+
+                hdr.dictionary_size   = dir->dictionary().size();
+                hdr.dictionary_offset = append(dir->dictionary().data(), dir->dictionary().size(), 8);
+
+                if (dir->has_http()) {
+                    std::vector<uint64_t> words;
+                    std::string pool;
+                    dir->http_tables(words, pool);
+
+                    hdr.http_offset         = append(words.data(), words.size() * sizeof(uint64_t), 8);
+                    hdr.http_strings_offset = append(pool.data(), pool.size(), 1);
+                }
+            }
+
+            auto blob_size = system::file_size(blob_file);
+            if (blob_size < 0) {
+                g_logger->error("failed to get the size of %s", blob_file.c_str());
+                return false;
+            }
+
+            uint64_t tables_end = HEADER_SIZE + tables.size();
+            hdr.blob_offset = (tables_end + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+            hdr.blob_size   = static_cast<uint64_t>(blob_size);
+            hdr.file_size   = hdr.blob_offset + hdr.blob_size;
+
+            std::ifstream in(blob_file, std::ios::in | std::ios::binary);
+            if (!in.is_open()) {
+                g_logger->error("failed to open %s: %s", blob_file.c_str(),
+                    system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            auto wrote = system::write_file_contents(fname, std::ios::out | std::ios::trunc |
+                std::ios::binary, [&](std::ostream& strm) {
+                strm.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+                strm.write(tables.data(), static_cast<std::streamsize>(tables.size()));
+                strm << std::string(hdr.blob_offset - tables_end, '\0');
+
+                std::vector<char> buf(COPY_CHUNK);
+                while (in) {
+                    in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+                    strm.write(buf.data(), in.gcount());
+                }
+            });
+
+            if (wrote == std::ofstream::pos_type(-1) || in.bad()) {
+                g_logger->error("failed to write %s", fname.c_str());
+                return false;
+            }
+
+            return true;
+        }
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_PACKFILE_HH_INCLUDED
@@ -0,0 +1,58 @@
+/*
+ * payload.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_PAYLOAD_HH_INCLUDED
+# define _EMBLOB_PAYLOAD_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+# include "emblob/filter.hh"
+
+namespace emblob
+{
+    /* produces the bytes that are actually embedded (the payload) from the
+     * input file, if they differ from the input file's contents. */
+    class payload
+    {
+    public:
+        payload() = delete;
+        ~payload() = delete;
+
+        /* streams in_fname through chain, writing the result to out_fname. */
+        static bool write(const std::string& in_fname, const std::string& out_fname,
+            filter_chain& chain) {
+            bool run_ok = false;
+            auto wrote = system::write_file_contents(out_fname, std::ios::out | std::ios::trunc |
+                std::ios::binary, [&](std::ostream& strm) {
+                run_ok = chain.run(in_fname, strm);
+            });
+
+            return wrote != std::ofstream::pos_type(-1) && run_ok;
+        }
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_PAYLOAD_HH_INCLUDED
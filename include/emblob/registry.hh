@@ -0,0 +1,100 @@
+/*
+ * registry.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_REGISTRY_HH_INCLUDED
+# define _EMBLOB_REGISTRY_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/directory.hh"
+
+namespace emblob
+{
+    /* a blob's record in the link-time registry: the address of its name, its
+     * address, its size, the hash of its name, and its flags. the records of
+     * every registered blob are gathered by the linker into one section, which
+     * is bounded by the __start_/__stop_ (or section$start/section$end)
+     * symbols; the section is writable, so that the runtime may sort it in
+     * place. */
+    class registry
+    {
+    public:
+        /* must match EMBLOB_REGISTRY_* in the generated header. */
+        CONST_STATIC_X(uint64_t) FLAG_DIRECTORY  = 0x01;
+        CONST_STATIC_X(uint64_t) FLAG_COMPRESSED = 0x02;
+        CONST_STATIC_X(uint64_t) FLAG_SPARSE     = 0x04;
+        CONST_STATIC_X(uint64_t) FLAG_ELEMENTS   = 0x08;
+        CONST_STATIC_X(uint64_t) FLAG_JSON_TAPE  = 0x10;
+        CONST_STATIC_X(uint64_t) FLAG_INDEX      = 0x20;
+
+        registry() = delete;
+        ~registry() = delete;
+
+        static void write_asm(std::ostream& strm, const std::string& lname, uint64_t size, uint64_t flags) {
+# if defined(__MACOS__)
+            strm << ".section __TEXT,__cstring,cstring_literals" << std::endl;
+            strm << "L_" << lname << "_registry_name:" << std::endl;
+            strm << ".asciz \"" << lname << "\"" << std::endl;
+            strm << ".section __DATA,__emblob_reg" << std::endl;
+            strm << ".balign 8" << std::endl;
+            strm << ".quad L_" << lname << "_registry_name, _" << lname << "_data" << std::endl;
+# else
+            strm << ".section .rodata.emblob." << lname << ".registry,\"a\",%progbits" << std::endl;
+            strm << ".L" << lname << "_registry_name:" << std::endl;
+            strm << ".asciz \"" << lname << "\"" << std::endl;
+            strm << ".section emblob_registry,\"aw\",%progbits" << std::endl;
+            strm << ".balign 8" << std::endl;
+            strm << ".dc.a .L" << lname << "_registry_name, _" << lname << "_data" << std::endl;
+# endif
+            strm << ".quad " << size << ", " << directory_pack::hash_name(lname) << ", " << flags
+                 << std::endl;
+
+            /* every registered blob defines the (shared) state of the registry
+             * weakly; the linker keeps one of them. like the bounds of the
+             * section, it is hidden, so that each executable or shared library
+             * sorts its own records, rather than binding to another's state. */
+# if defined(__MACOS__)
+            strm << ".section __DATA,__data" << std::endl;
+            strm << ".globl _emblob_registry_state" << std::endl;
+            strm << ".weak_definition _emblob_registry_state" << std::endl;
+            strm << ".private_extern _emblob_registry_state" << std::endl;
+            strm << ".balign 4" << std::endl;
+            strm << "_emblob_registry_state:" << std::endl;
+            strm << ".long 0" << std::endl;
+# else
+            strm << ".section .bss._emblob_registry_state,\"awG\",%nobits,_emblob_registry_state,comdat"
+                 << std::endl;
+            strm << ".weak _emblob_registry_state" << std::endl;
+            strm << ".hidden _emblob_registry_state" << std::endl;
+            strm << ".type _emblob_registry_state, %object" << std::endl;
+            strm << ".balign 4" << std::endl;
+            strm << "_emblob_registry_state:" << std::endl;
+            strm << ".zero 4" << std::endl;
+            strm << ".size _emblob_registry_state, 4" << std::endl;
+# endif
+        }
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_REGISTRY_HH_INCLUDED
@@ -0,0 +1,435 @@
+/*
+ * server.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_SERVER_HH_INCLUDED
+# define _EMBLOB_SERVER_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+
+# include <condition_variable>
+# include <deque>
+# include <mutex>
+# include <thread>
+# include <csignal>
+# include <fcntl.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+
+# if defined(__LINUS__)
+#  include <sched.h>
+# endif
+
+namespace emblob
+{
+    /* emblob --serve: runs requests from `emblob --connect` clients, on a pool
+     * of threads, over a Unix domain socket, so that the cost of starting
+     * emblob (and detecting the compiler) is paid once.
+     *
+     * every message is a frame: a 32-bit length (in host byte order, since
+     * both ends are on the same machine), a type, and that many bytes of data.
+     * the client sends one REQUEST frame, whose data is the protocol version,
+     * the client's working directory, and the arguments, each terminated by a
+     * NUL. the server runs the compiler that it detected itself, never one
+     * named by a client. the server replies with STDOUT and STDERR frames,
+     * then an EXIT frame (the 32-bit exit status), and closes the connection.
+     *
+     * each request runs in the client's working directory. on Linux, each
+     * thread has a working directory of its own (unshare(CLONE_FS)), so
+     * requests run concurrently; elsewhere, they run one at a time. */
+    class server
+    {
+    public:
+        CONST_STATIC_STRING PROTOCOL_VERSION = "2";
+        CONST_STATIC_X(uint32_t) MAX_FRAME   = 64 * 1024 * 1024;
+
+        CONST_STATIC_X(char) FRAME_REQUEST = 'q';
+        CONST_STATIC_X(char) FRAME_STDOUT  = 'o';
+        CONST_STATIC_X(char) FRAME_STDERR  = 'e';
+        CONST_STATIC_X(char) FRAME_EXIT    = 'x';
+
+        struct request {
+            std::string cwd;
+            std::vector<std::string> args;
+        };
+
+        /* runs a request, writing its output to out and err; returns its exit
+         * status. */
+        using handler = std::function<int(const request& req, std::ostream& out, std::ostream& err)>;
+
+        server() = delete;
+        ~server() = delete;
+
+        /* listens on path until SIGINT or SIGTERM. */
+        static int serve(const std::string& path, size_t threads, const handler& handle) {
+            sockaddr_un addr {};
+            if (!_make_address(path, addr)) {
+                return EXIT_FAILURE;
+            }
+
+            /* a socket left behind by a server which is no longer running is
+             * replaced; one which is in use is not. */
+            if (struct stat st {}; 0 == lstat(path.c_str(), &st)) {
+                if (!S_ISSOCK(st.st_mode)) {
+                    g_logger->fatal("%s exists, and is not a socket", path.c_str());
+                    return EXIT_FAILURE;
+                }
+
+                if (int probe = _connect(addr); probe != -1) {
+                    close(probe);
+                    g_logger->fatal("another server is listening on %s", path.c_str());
+                    return EXIT_FAILURE;
+                }
+
+                unlink(path.c_str());
+            }
+
+            /* the socket is created accessible to its owner alone (there are
+             * no other threads yet, so the umask may be changed briefly), and
+             * connections from any other user are refused as well. */
+            int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            auto old_mask = umask(S_IRWXG | S_IRWXO | S_IXUSR);
+            bool bound = listen_fd != -1 && -1 != fcntl(listen_fd, F_SETFD, FD_CLOEXEC) &&
+                0 == bind(listen_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+            umask(old_mask);
+            if (!bound || 0 != listen(listen_fd, SOMAXCONN)) {
+                g_logger->fatal("failed to listen on %s: %s", path.c_str(),
+                    system::get_error_message(errno).c_str());
+                if (listen_fd != -1) {
+                    close(listen_fd);
+                }
+                return EXIT_FAILURE;
+            }
+
+            /* accept() is interrupted (rather than restarted) by these, and
+             * a client which goes away must not take the server with it. */
+            struct sigaction sa {};
+            sa.sa_handler = [](int) { _stop_requested = 1; };
+            sigemptyset(&sa.sa_mask);
+            sigaction(SIGINT, &sa, nullptr);
+            sigaction(SIGTERM, &sa, nullptr);
+            signal(SIGPIPE, SIG_IGN);
+
+            std::mutex lock;
+            std::condition_variable ready;
+            std::deque<int> pending;
+            bool stopping = false;
+
+            /* serializes requests on threads which share a working directory. */
+            std::mutex cwd_lock;
+
+            std::vector<std::thread> workers;
+            for (size_t n = 0; n < threads; n++) {
+                workers.emplace_back([&]() {
+                    bool private_cwd = _unshare_cwd();
+                    for (;;) {
+                        int fd = -1;
+                        {
+                            std::unique_lock<std::mutex> guard(lock);
+                            ready.wait(guard, [&]() { return stopping || !pending.empty(); });
+                            if (pending.empty()) {
+                                return;
+                            }
+
+                            fd = pending.front();
+                            pending.pop_front();
+                        }
+
+                        if (private_cwd) {
+                            _handle(fd, handle);
+                        } else {
+                            std::lock_guard<std::mutex> guard(cwd_lock);
+                            _handle(fd, handle);
+                        }
+
+                        close(fd);
+                    }
+                });
+            }
+
+            g_logger->info("listening on %s (%zu threads)", path.c_str(), threads);
+
+            while (!_stop_requested) {
+                int fd = accept(listen_fd, nullptr, nullptr);
+                if (fd == -1) {
+                    if (errno != EINTR) {
+                        g_logger->error("accept failed: %s", system::get_error_message(errno).c_str());
+                    }
+                    continue;
+                }
+
+                [[maybe_unused]] int ret = fcntl(fd, F_SETFD, FD_CLOEXEC);
+                if (uid_t uid = 0; !_peer_uid(fd, uid) || uid != geteuid()) {
+                    g_logger->warning("refusing a connection from another user (uid %lld)",
+                        static_cast<long long>(uid));
+                    close(fd);
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> guard(lock);
+                pending.push_back(fd);
+                ready.notify_one();
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+                ready.notify_all();
+            }
+
+            for (auto& w : workers) {
+                w.join();
+            }
+
+            close(listen_fd);
+            unlink(path.c_str());
+            g_logger->info("stopped listening on %s", path.c_str());
+            return EXIT_SUCCESS;
+        }
+
+        /* sends req to the server listening on path, and relays its output to
+         * stdout and stderr. returns false if the request could not be sent
+         * (in which case nothing was run); otherwise, stores the exit status
+         * in exit_code. */
+        static bool forward(const std::string& path, const request& req, int& exit_code) {
+            sockaddr_un addr {};
+            if (!_make_address(path, addr)) {
+                return false;
+            }
+
+            int fd = _connect(addr);
+            if (fd == -1) {
+                g_logger->debug("unable to connect to %s: %s", path.c_str(),
+                    system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            signal(SIGPIPE, SIG_IGN);
+
+            std::string data = std::string(PROTOCOL_VERSION) + '\0' + req.cwd + '\0';
+            for (const auto& arg : req.args) {
+                data += arg;
+                data.push_back('\0');
+            }
+
+            if (!_write_frame(fd, FRAME_REQUEST, data)) {
+                close(fd);
+                return false;
+            }
+
+            exit_code = EXIT_FAILURE;
+            char type = 0;
+            while (_read_frame(fd, type, data)) {
+                if (type == FRAME_STDOUT || type == FRAME_STDERR) {
+                    auto& strm = type == FRAME_STDOUT ? std::cout : std::cerr;
+                    strm.write(data.data(), static_cast<std::streamsize>(data.size()));
+                    strm.flush();
+                } else if (type == FRAME_EXIT && data.size() == sizeof(int32_t)) {
+                    int32_t status = 0;
+                    memcpy(&status, data.data(), sizeof(status));
+                    exit_code = status;
+                    close(fd);
+                    return true;
+                }
+            }
+
+            g_logger->error("the server at %s closed the connection before replying", path.c_str());
+            close(fd);
+            return true;
+        }
+
+    private:
+        static inline volatile sig_atomic_t _stop_requested = 0;
+
+        static bool _make_address(const std::string& path, sockaddr_un& addr) {
+            if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+                g_logger->fatal("'%s' is not a valid socket path (at most %zu characters)", path.c_str(),
+                    sizeof(addr.sun_path) - 1);
+                return false;
+            }
+
+            addr.sun_family = AF_UNIX;
+            memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            return true;
+        }
+
+        static int _connect(const sockaddr_un& addr) {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd != -1 && 0 != connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr))) {
+                auto err = errno;
+                close(fd);
+                errno = err;
+                return -1;
+            }
+
+            return fd;
+        }
+
+        /* the effective user ID of the process on the other end of fd. */
+        static bool _peer_uid(int fd, uid_t& uid) {
+# if defined(__LINUS__)
+            ucred cred {};
+            socklen_t len = sizeof(cred);
+            if (0 != getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len)) {
+                return false;
+            }
+
+            uid = cred.uid;
+            return true;
+# else
+            gid_t gid = 0;
+            return 0 == getpeereid(fd, &uid, &gid);
+# endif
+        }
+
+        static bool _unshare_cwd() {
+# if defined(__LINUS__)
+            if (0 == unshare(CLONE_FS)) {
+                return true;
+            }
+
+            g_logger->warning("unshare(CLONE_FS) failed (%s); requests will run one at a time",
+                system::get_error_message(errno).c_str());
+# endif
+            return false;
+        }
+
+        static void _handle(int fd, const handler& handle) {
+            char type = 0;
+            std::string data;
+            request req;
+            if (!_read_frame(fd, type, data) || type != FRAME_REQUEST || !_decode(data, req)) {
+                g_logger->error("ignoring a malformed request");
+                return;
+            }
+
+            std::ostringstream out;
+            std::ostringstream err;
+            int32_t status = EXIT_FAILURE;
+            if (0 != chdir(req.cwd.c_str())) {
+                err << APP_NAME << ": failed to change to " << req.cwd << ": "
+                    << system::get_error_message(errno) << std::endl;
+            } else {
+                try {
+                    status = handle(req, out, err);
+                } catch (const std::exception& ex) {
+                    err << APP_NAME << ": caught exception: " << ex.what() << std::endl;
+                }
+            }
+
+            std::string status_data(reinterpret_cast<const char*>(&status), sizeof(status));
+            if ((!out.str().empty() && !_write_frame(fd, FRAME_STDOUT, out.str())) ||
+                (!err.str().empty() && !_write_frame(fd, FRAME_STDERR, err.str())) ||
+                !_write_frame(fd, FRAME_EXIT, status_data)) {
+                g_logger->error("failed to reply to a client: %s", system::get_error_message(errno).c_str());
+            }
+        }
+
+        static bool _decode(const std::string& data, request& req) {
+            std::vector<std::string> fields;
+            for (size_t pos = 0; pos < data.size();) {
+                auto end = data.find('\0', pos);
+                if (end == std::string::npos) {
+                    return false;
+                }
+
+                fields.push_back(data.substr(pos, end - pos));
+                pos = end + 1;
+            }
+
+            if (fields.size() < 2 || fields[0] != PROTOCOL_VERSION) {
+                return false;
+            }
+
+            req.cwd = fields[1];
+            req.args.assign(fields.begin() + 2, fields.end());
+            return true;
+        }
+
+        static bool _write_all(int fd, const char* data, size_t len) {
+            while (len > 0) {
+                auto wrote = write(fd, data, len);
+                if (wrote == -1 && errno == EINTR) {
+                    continue;
+                } else if (wrote <= 0) {
+                    return false;
+                }
+
+                data += wrote;
+                len -= static_cast<size_t>(wrote);
+            }
+
+            return true;
+        }
+
+        static bool _read_all(int fd, char* data, size_t len) {
+            while (len > 0) {
+                auto got = read(fd, data, len);
+                if (got == -1 && errno == EINTR) {
+                    continue;
+                } else if (got <= 0) {
+                    return false;
+                }
+
+                data += got;
+                len -= static_cast<size_t>(got);
+            }
+
+            return true;
+        }
+
+        static bool _write_frame(int fd, char type, const std::string& data) {
+            if (data.size() > MAX_FRAME) {
+                return false;
+            }
+
+            char header[sizeof(uint32_t) + 1];
+            auto len = static_cast<uint32_t>(data.size());
+            memcpy(header, &len, sizeof(len));
+            header[sizeof(len)] = type;
+            return _write_all(fd, header, sizeof(header)) && _write_all(fd, data.data(), data.size());
+        }
+
+        static bool _read_frame(int fd, char& type, std::string& data) {
+            char header[sizeof(uint32_t) + 1];
+            if (!_read_all(fd, header, sizeof(header))) {
+                return false;
+            }
+
+            uint32_t len = 0;
+            memcpy(&len, header, sizeof(len));
+            if (len > MAX_FRAME) {
+                return false;
+            }
+
+            type = header[sizeof(len)];
+            data.resize(len);
+            return _read_all(fd, data.data(), len);
+        }
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_SERVER_HH_INCLUDED
@@ -0,0 +1,164 @@
+/*
+ * sparse.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_SPARSE_HH_INCLUDED
+# define _EMBLOB_SPARSE_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+
+namespace emblob
+{
+    /* the segments of the input file which are not part of a run of at least
+     * MIN_ZERO_RUN zero bytes. only these segments are stored in the object
+     * file; the blob itself is a zero-filled (NOBITS) region into which they
+     * are copied at runtime.
+     *
+     * each segment is described by three 64-bit words: its offset within the
+     * blob, its length, and its offset within the packed segment data. */
+    class sparse_map
+    {
+    public:
+        CONST_STATIC_X(uint64_t) MIN_ZERO_RUN = 4096;
+        CONST_STATIC_X(size_t) READ_CHUNK     = 1024 * 1024;
+
+        struct segment {
+            uint64_t offset = 0;
+            uint64_t length = 0;
+        };
+
+        sparse_map() = default;
+        ~sparse_map() = default;
+
+        bool build(const std::string& fname) {
+            _segments.clear();
+            _size = 0;
+
+            std::ifstream strm(fname, std::ios::in | std::ios::binary);
+            if (!strm.is_open()) {
+                g_logger->error("failed to open %s: %s", fname.c_str(),
+                    system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            std::vector<char> buf(READ_CHUNK);
+            uint64_t pos = 0;
+            uint64_t seg_start = 0;
+            uint64_t nonzero_end = 0; /* one past the last non-zero byte. */
+            bool seg_open = false;
+
+            while (strm) {
+                strm.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+                auto got = static_cast<size_t>(strm.gcount());
+                if (got == 0) {
+                    break;
+                }
+
+                for (size_t n = 0; n < got; n++) {
+                    if (buf[n] == 0) {
+                        continue;
+                    }
+
+                    uint64_t at = pos + n;
+                    bool long_run = at - nonzero_end >= MIN_ZERO_RUN;
+                    if (!seg_open) {
+                        seg_start = long_run ? at : 0;
+                        seg_open = true;
+                    } else if (long_run) {
+                        _segments.push_back({ seg_start, nonzero_end - seg_start });
+                        seg_start = at;
+                    }
+
+                    nonzero_end = at + 1;
+                }
+
+                pos += got;
+            }
+
+            if (strm.bad()) {
+                g_logger->error("failed to read %s", fname.c_str());
+                return false;
+            }
+
+            if (seg_open) {
+                uint64_t end = pos - nonzero_end >= MIN_ZERO_RUN ? nonzero_end : pos;
+                _segments.push_back({ seg_start, end - seg_start });
+            }
+
+            _size = pos;
+            return true;
+        }
+
+        const std::vector<segment>& segments() const {
+            return _segments;
+        }
+
+        uint64_t stored_bytes() const {
+            uint64_t total = 0;
+            for (const auto& s : _segments) {
+                total += s.length;
+            }
+
+            return total;
+        }
+
+        uint64_t elided_bytes() const {
+            return _size - stored_bytes();
+        }
+
+        /* writes the segment map, and the segments themselves (straight from
+         * the input file, via .incbin's skip and count arguments). */
+        void write_asm(std::ostream& strm, const std::string& lname, const std::string& fname) const {
+            strm << ".balign 8" << std::endl;
+            strm << ".global _" << lname << "_sparse_map" << std::endl;
+            strm << "_" << lname << "_sparse_map:" << std::endl;
+
+            uint64_t data_offset = 0;
+            for (const auto& s : _segments) {
+                strm << ".quad " << s.offset << ", " << s.length << ", " << data_offset << std::endl;
+                data_offset += s.length;
+            }
+
+            /* so that the symbol is valid even if there are no segments. */
+            strm << ".quad 0, 0, 0" << std::endl;
+
+            strm << ".balign 16" << std::endl;
+            strm << ".global _" << lname << "_sparse_data" << std::endl;
+            strm << "_" << lname << "_sparse_data:" << std::endl;
+            for (const auto& s : _segments) {
+                strm << ".incbin \"" << fname << "\", " << s.offset << ", " << s.length << std::endl;
+            }
+
+            strm << ".byte 0" << std::endl;
+        }
+
+    private:
+        std::vector<segment> _segments;
+        uint64_t _size = 0;
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_SPARSE_HH_INCLUDED
@@ -28,12 +28,20 @@
 
 # include "emblob/platform.hh"
 # include "emblob/util.hh"
+# include "emblob/trace.hh"
+
+# include <atomic>
 
 namespace emblob
 {
     class system
     {
     public:
+        CONST_STATIC_STRING STDIN_FILENAME = "-";
+
+        /* the size of the buffer through which output files are written. */
+        CONST_STATIC_X(size_t) WRITE_BUFFER_SIZE = 1024 * 1024;
+
         system() = delete;
         ~system() = delete;
 
@@ -70,6 +78,7 @@ namespace emblob
         }
 
         static bool file_exists(const std::string& fname) {
+            auto traced = g_tracer->begin("stat", tracer::CAT_SYSTEM, fname);
             struct stat st {};
             if (int ret = stat(fname.c_str(), &st); 0 != ret) {
                 if (ENOENT != errno) {
@@ -82,8 +91,14 @@ namespace emblob
             return true;
         }
 
+        static bool is_directory(const std::string& fname) {
+            struct stat st {};
+            return 0 == stat(fname.c_str(), &st) && S_ISDIR(st.st_mode);
+        }
+
         /* file size in bytes, or -1 upon failure */
         static off_t file_size(const std::string& fname) {
+            auto traced = g_tracer->begin("stat", tracer::CAT_SYSTEM, fname);
             struct stat st {};
             if (0 != stat(fname.c_str(), &st)) {
                 g_logger->error("couldn't stat %s; error: %s", fname.c_str(),
@@ -94,7 +109,11 @@ namespace emblob
             return st.st_size;
         }
 
-        static std::string file_base_name(const std::string& fname) {
+        static std::string file_base_name(std::string fname) {
+            while (fname.size() > 1 && (fname.back() == '/' || fname.back() == '\\')) {
+                fname.pop_back();
+            }
+
             auto slash = fname.find_last_of('/');
             if (slash == std::string::npos) {
                 slash = fname.find_last_of('\\');
@@ -126,29 +145,57 @@ namespace emblob
             return base_name;
         }
 
+        /* writes a file by way of a temporary file in the same directory,
+         * which is renamed over it once it has been written in full; so a
+         * file is never seen (e.g. by a parallel build) half-written, and a
+         * failure leaves whatever was there before in place. */
         static std::ofstream::pos_type write_file_contents(const std::string& fname,
             std::ios_base::openmode mode, const std::function<void(std::ostream&)>& cb) {
             if (!cb) {
                 return std::ofstream::pos_type(-1);
             }
 
+            auto traced = g_tracer->begin("write_file", tracer::CAT_SYSTEM, fname);
+            auto tmp_file = temp_filename(fname);
+            auto pos = std::ofstream::pos_type(-1);
+
             try {
-                g_logger->debug("opening %s for writing (mode: 0x%x)...", fname.c_str(), mode);
-                std::ofstream strm(fname, mode);
+                g_logger->debug("opening %s for writing (mode: 0x%x)...", tmp_file.c_str(), mode);
+                std::vector<char> buf(WRITE_BUFFER_SIZE);
+                std::ofstream strm;
+                strm.rdbuf()->pubsetbuf(buf.data(), static_cast<std::streamsize>(buf.size()));
                 strm.exceptions(strm.badbit | strm.failbit);
+                strm.open(tmp_file, mode);
 
                 cb(strm);
                 strm.flush();
-
-                if (strm.good()) {
-                    return strm.tellp();
-                }
+                pos = strm.tellp();
+                strm.close();
             } catch (const std::ios_base::failure& ex) {
                 g_logger->error("caught exception while writing to %s: %s", fname.c_str(),
                     ex.what());
+                pos = std::ofstream::pos_type(-1);
+            }
+
+            if (pos != std::ofstream::pos_type(-1) && 0 != rename(tmp_file.c_str(), fname.c_str())) {
+                g_logger->error("failed to rename %s to %s: %s", tmp_file.c_str(), fname.c_str(),
+                    get_error_message(errno).c_str());
+                pos = std::ofstream::pos_type(-1);
+            }
+
+            if (pos == std::ofstream::pos_type(-1)) {
+                [[maybe_unused]] int ret = remove(tmp_file.c_str());
             }
 
-            return std::ofstream::pos_type(-1);
+            return pos;
+        }
+
+        /* a name, unique to this process (and call), for a temporary file in
+         * the same directory as fname (and so on the same file system). */
+        static std::string temp_filename(const std::string& fname) {
+            static std::atomic<uint64_t> counter { 0 };
+            return fmt_str("%s.%s-%d-%" PRIu64 ".tmp", fname.c_str(), APP_NAME, static_cast<int>(getpid()),
+                counter++);
         }
 
         static bool delete_file(const std::string& fname) {
@@ -172,11 +219,25 @@ namespace emblob
             return err_code == 0;
         }
 
+        /* "-" (standard input), or a pipe, socket, or character device (e.g.
+         * /dev/fd/3): an input which can only be read once, from start to end. */
+        static bool is_stream(const std::string& fname) {
+            struct stat st {};
+            return fname == STDIN_FILENAME || (0 == stat(fname.c_str(), &st) &&
+                (S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode) || S_ISCHR(st.st_mode)));
+        }
+
         static bool is_valid_input_filename(const std::string& fname, std::string& err_msg) {
             bool opened = false;
             err_msg.clear();
 
-            if (auto size = file_size(fname); -1 == size) {
+            if (is_stream(fname)) {
+                opened = true;
+                g_logger->info("input stream %s", fname == STDIN_FILENAME ? "(stdin)" : fname.c_str());
+            } else if (is_directory(fname)) {
+                opened = true;
+                g_logger->info("input directory %s", fname.c_str());
+            } else if (auto size = file_size(fname); -1 == size) {
                 err_msg = get_error_message(errno);
             } else if (0 == size) {
                 err_msg = fmt_str("input file %s is empty", fname.c_str());
@@ -188,38 +249,24 @@ namespace emblob
             return opened;
         }
 
+        /* whether fname could be written: its directory must exist and be
+         * writable, and it must not be a directory itself. nothing is
+         * created, since outputs are only written once they are complete. */
         static bool is_valid_output_filename(const std::string& fname, std::string& err_msg) {
-            bool created = false;
             err_msg.clear();
 
-            FILE *f = nullptr;
-            int err = 0;
-
-# if defined(__HAVE_STDC_SECURE_LIB__)
-            err = fopen_s(&f, fname.c_str(), "wx");
-            if (0 == err) {
-                created = true;
-            }
-# else
-            f = fopen(fname.c_str(), "wx");
-            if (f) {
-                created = true;
-            } else {
-                err = errno;
-            }
-# endif
-            if (created) {
-                fclose(f);
-                f = nullptr;
+            auto slash = fname.find_last_of('/');
+            auto dir = slash == std::string::npos ? std::string(".") : fname.substr(0, std::max<size_t>(slash, 1));
 
-                if (!delete_file(fname)) {
-                    err_msg = get_error_message(errno);
-                }
-            } else {
-                err_msg = get_error_message(err);
+            if (is_directory(fname)) {
+                err_msg = get_error_message(EISDIR);
+            } else if (!is_directory(dir)) {
+                err_msg = fmt_str("%s is not a directory", dir.c_str());
+            } else if (0 != access(dir.c_str(), W_OK | X_OK)) {
+                err_msg = get_error_message(errno);
             }
 
-            return created;
+            return err_msg.empty();
         }
 
         static std::string detect_c_compiler() {
@@ -260,7 +307,9 @@ namespace emblob
 
                 g_logger->debug("executing system command '%s'...", cmd.c_str());
 
+                auto traced = g_tracer->begin("execute_system_command", tracer::CAT_SUBPROCESS, cmd);
                 int sysret = std::system(cmd.c_str());
+                traced.end();
                 int status = WEXITSTATUS(sysret);
                 retval = status == 0;
                 std::cout.flush();
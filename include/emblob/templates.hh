@@ -0,0 +1,2802 @@
+/*
+ * templates.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_TEMPLATES_HH_INCLUDED
+# define _EMBLOB_TEMPLATES_HH_INCLUDED
+
+# include "emblob/util.hh"
+
+/* Optional sections of the generated header. Each is self-contained (it takes
+ * care of its own includes and extern "C" linkage) and is inserted at the
+ * {EXTENSIONS} placeholder in the header template (or, for those which must
+ * precede the accessor functions, at {PRELUDE}), before any placeholders are
+ * substituted. Code that is shared by all blobs is guarded so that it may be
+ * included by more than one generated header in the same translation unit. */
+namespace emblob::templates
+{
+    CONST_STATIC_STRING zero_copy = R"EOF(
+#if defined(__linux__)
+# if !defined(__cplusplus) && !defined(_GNU_SOURCE)
+#  error "emblob zero-copy functions require _GNU_SOURCE to be defined before any system header is included"
+# endif
+
+# if !defined(_EMBLOB_ZERO_COPY_INCLUDED)
+#  define _EMBLOB_ZERO_COPY_INCLUDED
+
+#  include <elf.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/auxv.h>
+#  include <sys/sendfile.h>
+#  include <sys/types.h>
+
+#  if UINTPTR_MAX > UINT32_MAX
+#   define EMBLOB_ELF_EHDR Elf64_Ehdr
+#   define EMBLOB_ELF_PHDR Elf64_Phdr
+#  else
+#   define EMBLOB_ELF_EHDR Elf32_Ehdr
+#   define EMBLOB_ELF_PHDR Elf32_Phdr
+#  endif
+
+#  if defined(__cplusplus)
+    extern "C" {
+#  endif
+
+/**
+ * Returns a read-only file descriptor for the running executable, or -1 if it
+ * could not be opened. The descriptor is opened once and remains open for the
+ * lifetime of the process; it is only ever used with explicit offsets.
+ */
+static inline
+int emblob_exe_fd(void)
+{
+    static int cached_fd = -1;
+    int fd = __atomic_load_n(&cached_fd, __ATOMIC_ACQUIRE);
+
+    if (fd == -1) {
+        int expected = -1;
+        fd = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+        if (fd != -1 && !__atomic_compare_exchange_n(&cached_fd, &expected, fd, 0,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            close(fd);
+            fd = expected;
+        }
+    }
+
+    return fd;
+}
+
+/**
+ * Translates the address of len bytes of data in the running executable into
+ * an offset within the executable file by way of its program headers. Returns
+ * -1 if the data is not backed by the file (e.g. it resides in a shared library).
+ */
+static inline
+off_t emblob_exe_offset_of(const void* addr, size_t len)
+{
+    const EMBLOB_ELF_PHDR* phdrs = (const EMBLOB_ELF_PHDR*)getauxval(AT_PHDR);
+    size_t phnum = (size_t)getauxval(AT_PHNUM);
+    uintptr_t bias = 0;
+    int have_bias = 0;
+    size_t n;
+
+    if (!phdrs || !phnum)
+        return -1;
+
+    for (n = 0; n < phnum; n++) {
+        if (phdrs[n].p_type == PT_PHDR) {
+            bias = (uintptr_t)phdrs - (uintptr_t)phdrs[n].p_vaddr;
+            have_bias = 1;
+            break;
+        }
+    }
+
+    if (!have_bias) {
+        /* no PT_PHDR (e.g. a static executable); locate the segment that maps
+         * the program headers by way of the ELF header. */
+        EMBLOB_ELF_EHDR ehdr;
+        int fd = emblob_exe_fd();
+        if (fd == -1 || pread(fd, &ehdr, sizeof(ehdr), 0) != (ssize_t)sizeof(ehdr))
+            return -1;
+
+        for (n = 0; n < phnum; n++) {
+            if (phdrs[n].p_type == PT_LOAD && ehdr.e_phoff >= phdrs[n].p_offset &&
+                ehdr.e_phoff < phdrs[n].p_offset + phdrs[n].p_filesz) {
+                bias = (uintptr_t)phdrs -
+                    (uintptr_t)(phdrs[n].p_vaddr + (ehdr.e_phoff - phdrs[n].p_offset));
+                have_bias = 1;
+                break;
+            }
+        }
+
+        if (!have_bias)
+            return -1;
+    }
+
+    uintptr_t vaddr = (uintptr_t)addr - bias;
+    for (n = 0; n < phnum; n++) {
+        if (phdrs[n].p_type == PT_LOAD && vaddr >= phdrs[n].p_vaddr &&
+            vaddr + len <= phdrs[n].p_vaddr + phdrs[n].p_filesz) {
+            return (off_t)(phdrs[n].p_offset + (vaddr - phdrs[n].p_vaddr));
+        }
+    }
+
+    return -1;
+}
+
+#  if defined(__cplusplus)
+    }
+#  endif
+# endif // !_EMBLOB_ZERO_COPY_INCLUDED
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/**
+ * Returns the offset of the embedded blob within the executable file, or -1 if
+ * it could not be determined. The offset is computed once and then cached.
+ */
+static inline
+off_t emblob_{lname}_file_offset(void)
+{
+    static off_t cached_offset = -2;
+    off_t offset = __atomic_load_n(&cached_offset, __ATOMIC_RELAXED);
+
+    if (offset == -2) {
+        offset = emblob_exe_offset_of(&EMBLOB_{NAME}, (size_t)emblob_get_{lname}_size());
+        __atomic_store_n(&cached_offset, offset, __ATOMIC_RELAXED);
+    }
+
+    return offset;
+}
+
+/**
+ * Sends up to len bytes of the embedded blob, starting at off, to out_fd using
+ * sendfile(2), so that the data travels directly from the page cache without
+ * being copied through user space. Returns the number of bytes sent (which may
+ * be fewer than requested), or -1 if an error occurred (errno is set).
+ */
+static inline
+ssize_t emblob_{lname}_sendfile(int out_fd, uint64_t off, size_t len)
+{
+    off_t file_off = emblob_{lname}_file_offset();
+    uint64_t size = emblob_get_{lname}_size();
+    int fd = emblob_exe_fd();
+
+    if (file_off == -1 || fd == -1) {
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    if (off >= size)
+        return 0;
+
+    if (len > size - off)
+        len = (size_t)(size - off);
+
+    file_off += (off_t)off;
+    return sendfile(out_fd, fd, &file_off, len);
+}
+
+/**
+ * Copies len bytes of the embedded blob, starting at off, to the current file
+ * position of out_fd using copy_file_range(2) (falling back to sendfile(2) if
+ * the kernel or file systems do not support it). Intended for extracting the
+ * blob to a file. Returns the number of bytes copied, or -1 if an error occurred
+ * (errno is set).
+ */
+static inline
+ssize_t emblob_{lname}_copy_file_range(int out_fd, uint64_t off, size_t len)
+{
+    off_t file_off = emblob_{lname}_file_offset();
+    uint64_t size = emblob_get_{lname}_size();
+    int fd = emblob_exe_fd();
+    size_t total = 0;
+
+    if (file_off == -1 || fd == -1) {
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    if (off >= size)
+        return 0;
+
+    if (len > size - off)
+        len = (size_t)(size - off);
+
+    loff_t in_off = (loff_t)(file_off + (off_t)off);
+    while (total < len) {
+        ssize_t copied = copy_file_range(fd, &in_off, out_fd, NULL, len - total, 0);
+        if (copied == -1 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL)) {
+            off_t sf_off = (off_t)in_off;
+            copied = sendfile(out_fd, fd, &sf_off, len - total);
+            in_off = (loff_t)sf_off;
+        }
+
+        if (copied == -1) {
+            if (errno == EINTR)
+                continue;
+            return total > 0 ? (ssize_t)total : -1;
+        }
+
+        if (copied == 0)
+            break;
+
+        total += (size_t)copied;
+    }
+
+    return (ssize_t)total;
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // __linux__
+)EOF";
+    CONST_STATIC_STRING paging = R"EOF(
+#if !defined(_WIN32)
+# if !defined(_EMBLOB_PAGING_INCLUDED)
+#  define _EMBLOB_PAGING_INCLUDED
+
+#  include <errno.h>
+#  include <pthread.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+
+/* advice values for the emblob_{name}_advise functions. */
+#  define EMBLOB_ADVISE_NORMAL     0
+#  define EMBLOB_ADVISE_WILLNEED   1
+#  define EMBLOB_ADVISE_SEQUENTIAL 2
+#  define EMBLOB_ADVISE_RANDOM     3
+#  define EMBLOB_ADVISE_HUGEPAGE   4
+
+#  if defined(__cplusplus)
+    extern "C" {
+#  endif
+
+/**
+ * Expands [addr, addr + len) to the smallest enclosing range of whole pages.
+ */
+static inline
+void emblob_page_range(const void* addr, size_t len, void** page_start, size_t* page_len)
+{
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start     = (uintptr_t)addr & ~(page_size - 1);
+    uintptr_t end       = ((uintptr_t)addr + len + page_size - 1) & ~(page_size - 1);
+
+    *page_start = (void*)start;
+    *page_len   = (size_t)(end - start);
+}
+
+/**
+ * Applies one of the EMBLOB_ADVISE_* values to the pages spanned by
+ * [addr, addr + len) with madvise(2). Returns 0 upon success, or -1 if an error
+ * occurred (errno is set).
+ */
+static inline
+int emblob_advise_range(const void* addr, size_t len, int advice)
+{
+    void* start = NULL;
+    size_t page_len = 0;
+    int madv = 0;
+
+    switch (advice) {
+        case EMBLOB_ADVISE_NORMAL:     madv = MADV_NORMAL;     break;
+        case EMBLOB_ADVISE_WILLNEED:   madv = MADV_WILLNEED;   break;
+        case EMBLOB_ADVISE_SEQUENTIAL: madv = MADV_SEQUENTIAL; break;
+        case EMBLOB_ADVISE_RANDOM:     madv = MADV_RANDOM;     break;
+#  if defined(MADV_HUGEPAGE)
+        case EMBLOB_ADVISE_HUGEPAGE:   madv = MADV_HUGEPAGE;   break;
+#  endif
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+
+    emblob_page_range(addr, len, &start, &page_len);
+    return madvise(start, page_len, madv);
+}
+
+/**
+ * Synchronously faults in the pages spanned by [addr, addr + len), using
+ * MADV_POPULATE_READ where available and by reading one byte from each page
+ * otherwise.
+ */
+static inline
+void emblob_prefault_range(const void* addr, size_t len)
+{
+    void* start = NULL;
+    size_t page_len = 0;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t n;
+
+    emblob_page_range(addr, len, &start, &page_len);
+
+#  if defined(MADV_POPULATE_READ)
+    if (0 == madvise(start, page_len, MADV_POPULATE_READ))
+        return;
+#  endif
+
+    for (n = 0; n < page_len; n += page_size)
+        (void)*(const volatile uint8_t*)((const uint8_t*)start + n);
+}
+
+#  if defined(__cplusplus)
+    }
+#  endif
+# endif // !_EMBLOB_PAGING_INCLUDED
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/**
+ * Advises the kernel how the embedded blob's pages will be accessed, with one of
+ * the EMBLOB_ADVISE_* values (EMBLOB_ADVISE_HUGEPAGE is only supported on Linux).
+ * Returns 0 upon success, or -1 if an error occurred (errno is set).
+ */
+static inline
+int emblob_{lname}_advise(int advice)
+{
+    return emblob_advise_range(emblob_get_{lname}_raw(), (size_t)emblob_get_{lname}_size(), advice);
+}
+
+/**
+ * Locks the embedded blob's pages into memory with mlock(2), faulting them in
+ * if necessary. Returns 0 upon success, or -1 if an error occurred (errno is set).
+ */
+static inline
+int emblob_{lname}_lock(void)
+{
+    void* start = NULL;
+    size_t page_len = 0;
+
+    emblob_page_range(emblob_get_{lname}_raw(), (size_t)emblob_get_{lname}_size(), &start, &page_len);
+    return mlock(start, page_len);
+}
+
+/**
+ * Unlocks pages previously locked by emblob_{lname}_lock. Returns 0 upon
+ * success, or -1 if an error occurred (errno is set).
+ */
+static inline
+int emblob_{lname}_unlock(void)
+{
+    void* start = NULL;
+    size_t page_len = 0;
+
+    emblob_page_range(emblob_get_{lname}_raw(), (size_t)emblob_get_{lname}_size(), &start, &page_len);
+    return munlock(start, page_len);
+}
+
+/**
+ * Synchronously faults in all of the embedded blob's pages.
+ */
+static inline
+void emblob_{lname}_prefault(void)
+{
+    emblob_prefault_range(emblob_get_{lname}_raw(), (size_t)emblob_get_{lname}_size());
+}
+
+static inline
+void* emblob_{lname}_warmup_thread(void* arg)
+{
+    (void)arg;
+    emblob_{lname}_prefault();
+    return NULL;
+}
+
+/**
+ * Starts a detached background thread which faults in all of the embedded blob's
+ * pages, so that the first access from other threads is less likely to stall.
+ * Returns 0 if the thread was started, or an error code from pthread_create.
+ */
+static inline
+int emblob_{lname}_warmup(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    int ret = pthread_attr_init(&attr);
+
+    if (0 != ret)
+        return ret;
+
+    (void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    ret = pthread_create(&thread, &attr, &emblob_{lname}_warmup_thread, NULL);
+    (void)pthread_attr_destroy(&attr);
+    return ret;
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_WIN32
+)EOF";
+    CONST_STATIC_STRING sparse = R"EOF(
+#if defined(__APPLE__)
+# define EMBLOB_{NAME}_SPARSE_MAP {lname}_sparse_map
+# define EMBLOB_{NAME}_SPARSE_DATA {lname}_sparse_data
+# define EMBLOB_{NAME}_SPARSE_STATE {lname}_sparse_state
+#else
+# define EMBLOB_{NAME}_SPARSE_MAP _{lname}_sparse_map
+# define EMBLOB_{NAME}_SPARSE_DATA _{lname}_sparse_data
+# define EMBLOB_{NAME}_SPARSE_STATE _{lname}_sparse_state
+#endif
+
+#define EMBLOB_{NAME}_SPARSE_SEGMENTS UINT64_C({SPARSE_SEGMENTS})
+
+/**
+ * The embedded blob is sparse: only its non-zero segments are stored in the
+ * executable, and the blob itself is a zero-filled region into which they are
+ * copied the first time that it is accessed. The segment map consists of an
+ * (offset, length, data offset) triple for each segment, in order of offset.
+ */
+EMBLOB_EXTERNAL const uint64_t EMBLOB_{NAME}_SPARSE_MAP[];
+EMBLOB_EXTERNAL const uint8_t EMBLOB_{NAME}_SPARSE_DATA[];
+EMBLOB_EXTERNAL int EMBLOB_{NAME}_SPARSE_STATE;
+
+#if !defined(_EMBLOB_SPARSE_INCLUDED)
+# define _EMBLOB_SPARSE_INCLUDED
+
+# include <string.h>
+# include <sched.h>
+
+# define EMBLOB_SPARSE_PENDING 0
+# define EMBLOB_SPARSE_BUSY    1
+# define EMBLOB_SPARSE_DONE    2
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/**
+ * Copies the segments described by map into dst, exactly once, no matter how
+ * many threads call it concurrently; all callers return once it is done.
+ */
+static inline
+void emblob_sparse_materialize(int* state, uint8_t* dst, const uint64_t* map,
+    uint64_t segments, const uint8_t* data)
+{
+    int expected = EMBLOB_SPARSE_PENDING;
+    uint64_t n;
+
+    if (__atomic_load_n(state, __ATOMIC_ACQUIRE) == EMBLOB_SPARSE_DONE)
+        return;
+
+    if (__atomic_compare_exchange_n(state, &expected, EMBLOB_SPARSE_BUSY, 0,
+        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        for (n = 0; n < segments; n++)
+            memcpy(dst + map[n * 3], data + map[n * 3 + 2], (size_t)map[n * 3 + 1]);
+        __atomic_store_n(state, EMBLOB_SPARSE_DONE, __ATOMIC_RELEASE);
+        return;
+    }
+
+    while (__atomic_load_n(state, __ATOMIC_ACQUIRE) != EMBLOB_SPARSE_DONE)
+        sched_yield();
+}
+
+/**
+ * Copies up to len bytes beginning at offset from a sparse blob of the given
+ * size into buf, directly from its segments. Returns the number of bytes
+ * copied.
+ */
+static inline
+size_t emblob_sparse_read(const uint64_t* map, uint64_t segments, const uint8_t* data,
+    uint64_t size, uint64_t offset, void* buf, size_t len)
+{
+    uint8_t* out = (uint8_t*)buf;
+    uint64_t lo = 0, hi = segments, end;
+
+    if (offset >= size)
+        return 0;
+    if (len > size - offset)
+        len = (size_t)(size - offset);
+
+    /* find the first segment which ends after offset. */
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (map[mid * 3] + map[mid * 3 + 1] <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    end = offset + len;
+    memset(out, 0, len);
+    for (; lo < segments && map[lo * 3] < end; lo++) {
+        uint64_t seg_start = map[lo * 3];
+        uint64_t seg_end   = seg_start + map[lo * 3 + 1];
+        uint64_t from      = seg_start > offset ? seg_start : offset;
+        uint64_t to        = seg_end < end ? seg_end : end;
+        memcpy(out + (from - offset), data + map[lo * 3 + 2] + (from - seg_start), (size_t)(to - from));
+    }
+
+    return len;
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_SPARSE_INCLUDED
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Reconstructs the embedded blob, if it has not been already, and returns its
+ * address. Every accessor function calls this, so it need only be called
+ * directly in order to control when the (one-time) cost is incurred.
+ */
+static inline
+const void* emblob_{lname}_materialize(void)
+{
+    emblob_sparse_materialize(&EMBLOB_{NAME}_SPARSE_STATE, (uint8_t*)&EMBLOB_{NAME},
+        EMBLOB_{NAME}_SPARSE_MAP, EMBLOB_{NAME}_SPARSE_SEGMENTS, EMBLOB_{NAME}_SPARSE_DATA);
+    return (const void*)&EMBLOB_{NAME};
+}
+
+/**
+ * Copies up to len bytes beginning at offset from the embedded blob into buf,
+ * without reconstructing the entire blob. Returns the number of bytes copied.
+ */
+static inline
+size_t emblob_{lname}_read(uint64_t offset, void* buf, size_t len)
+{
+    return emblob_sparse_read(EMBLOB_{NAME}_SPARSE_MAP, EMBLOB_{NAME}_SPARSE_SEGMENTS,
+        EMBLOB_{NAME}_SPARSE_DATA, UINT64_C({BLOB_SIZE}), offset, buf, len);
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+
+#define EMBLOB_{NAME}_ADDRESS emblob_{lname}_materialize()
+)EOF";
+    CONST_STATIC_STRING pack = R"EOF(
+#if !defined(_EMBLOB_PACK_INCLUDED)
+# define _EMBLOB_PACK_INCLUDED
+
+# include <errno.h>
+# include <fcntl.h>
+# include <sched.h>
+# include <stdlib.h>
+# include <string.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+
+# define EMBLOB_PACK_MAGIC      UINT64_C(0x4b50424f4c424d45)
+# define EMBLOB_PACK_VERSION    1
+# define EMBLOB_PACK_BYTE_ORDER UINT32_C(0x01020304)
+
+/* the pack must have HTTP metadata for its members (see emblob_pack_map). */
+# define EMBLOB_PACK_HTTP 0x01
+
+/* the number of words in a member's record (emblob_member: name offset, name
+ * length, offset, stored size, size, hash and flags) and in its HTTP metadata
+ * (emblob_http_info: MIME type offset, ETag offset, and the offset and size of
+ * each variant), and the flag of a compressed member. */
+# define EMBLOB_PACK_MEMBER_WORDS   7
+# define EMBLOB_PACK_HTTP_WORDS     6
+# define EMBLOB_PACK_MEMBER_DEFLATE UINT64_C(1)
+
+/**
+ * The header of a pack file. Every offset is from the beginning of the file.
+ */
+typedef struct emblob_pack_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t header_size;
+    uint64_t blob_offset;
+    uint64_t blob_size;
+    uint64_t member_count;
+    uint64_t slot_mask;
+    uint64_t members_offset;
+    uint64_t slots_offset;
+    uint64_t names_offset;
+    uint64_t dictionary_offset;
+    uint64_t dictionary_size;
+    uint64_t http_offset;
+    uint64_t http_strings_offset;
+    uint64_t file_size;
+    uint64_t reserved;
+} emblob_pack_header;
+
+/**
+ * The state of a pack file's mapping (reserved by the assembly file, and
+ * zero-filled).
+ */
+typedef struct emblob_pack_state {
+    int state; /* 0: not yet loaded, 1: loading, 2: loaded (or failed). */
+    int error; /* the errno value, if loading failed. */
+    const emblob_pack_header* header;
+    uint64_t reserved;
+} emblob_pack_state;
+
+/**
+ * What a pack which fails to load looks like: empty, with an empty hash table.
+ */
+typedef struct emblob_pack_empty {
+    emblob_pack_header header;
+    uint64_t zero;
+} emblob_pack_empty;
+
+static const emblob_pack_empty emblob_pack_empty_image = {
+    { EMBLOB_PACK_MAGIC, EMBLOB_PACK_VERSION, EMBLOB_PACK_BYTE_ORDER, sizeof(emblob_pack_header),
+      sizeof(emblob_pack_header), 0, 0, 0, sizeof(emblob_pack_header), sizeof(emblob_pack_header),
+      sizeof(emblob_pack_header), sizeof(emblob_pack_header), 0, sizeof(emblob_pack_header),
+      sizeof(emblob_pack_header), sizeof(emblob_pack_empty), 0 },
+    0
+};
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/* whether the len bytes at offset lie within a file of size bytes. */
+static inline
+int emblob_pack_fits(uint64_t offset, uint64_t len, uint64_t size)
+{
+    return offset <= size && len <= size - offset;
+}
+
+/* whether a table of count records of len bytes each, aligned to alignment,
+ * lies at offset within a file of size bytes. */
+static inline
+int emblob_pack_table_fits(uint64_t offset, uint64_t count, uint64_t len, uint64_t alignment, uint64_t size)
+{
+    return offset % alignment == 0 && offset <= size && count <= (size - offset) / len;
+}
+
+/* whether a NUL-terminated string begins at offset within the pool of size
+ * bytes at pool (which runs to the end of the file). */
+static inline
+int emblob_pack_string_fits(const uint8_t* pool, uint64_t size, uint64_t offset)
+{
+    return offset < size && NULL != memchr(pool + offset, '\0', (size_t)(size - offset));
+}
+
+/**
+ * Checks that everything the header of the mapped pack file at hdr describes
+ * lies within the file: the blob, each table, each member's name and stored
+ * bytes, and (if flags has EMBLOB_PACK_HTTP) each member's HTTP metadata; and
+ * that the hash table has an empty slot, and refers only to members which
+ * exist. Returns 0 if anything does not.
+ */
+static inline
+int emblob_pack_valid(const emblob_pack_header* hdr, int flags)
+{
+    const uint8_t* base = (const uint8_t*)hdr;
+    const uint64_t* members;
+    const uint32_t* slots;
+    const uint64_t* http;
+    uint64_t size = hdr->file_size;
+    uint64_t names_size, strings_size, i;
+    int empty_slot = 0;
+
+    if (!emblob_pack_fits(hdr->blob_offset, hdr->blob_size, size) ||
+        !emblob_pack_fits(hdr->dictionary_offset, hdr->dictionary_size, size) ||
+        !emblob_pack_table_fits(hdr->members_offset, hdr->member_count,
+            EMBLOB_PACK_MEMBER_WORDS * sizeof(uint64_t), sizeof(uint64_t), size) ||
+        hdr->slot_mask >= UINT32_MAX || (hdr->slot_mask & (hdr->slot_mask + 1)) != 0 ||
+        !emblob_pack_table_fits(hdr->slots_offset, hdr->slot_mask + 1, sizeof(uint32_t),
+            sizeof(uint32_t), size) ||
+        hdr->names_offset > size || hdr->http_strings_offset > size)
+        return 0;
+
+    if ((flags & EMBLOB_PACK_HTTP) && !emblob_pack_table_fits(hdr->http_offset, hdr->member_count,
+        EMBLOB_PACK_HTTP_WORDS * sizeof(uint64_t), sizeof(uint64_t), size))
+        return 0;
+
+    /* a lookup probes until it finds an empty slot. */
+    slots = (const uint32_t*)(base + hdr->slots_offset);
+    for (i = 0; i <= hdr->slot_mask; i++) {
+        if (slots[i] > hdr->member_count)
+            return 0;
+        empty_slot |= slots[i] == 0;
+    }
+
+    if (!empty_slot)
+        return 0;
+
+    members = (const uint64_t*)(base + hdr->members_offset);
+    http = (const uint64_t*)(base + hdr->http_offset);
+    names_size = size - hdr->names_offset;
+    strings_size = size - hdr->http_strings_offset;
+    for (i = 0; i < hdr->member_count; i++) {
+        const uint64_t* m = &members[i * EMBLOB_PACK_MEMBER_WORDS];
+        if (!emblob_pack_fits(m[0], m[1], names_size) || m[1] == names_size - m[0] ||
+            base[hdr->names_offset + m[0] + m[1]] != '\0' ||
+            !emblob_pack_fits(m[2], m[3], hdr->blob_size) ||
+            (!(m[6] & EMBLOB_PACK_MEMBER_DEFLATE) && m[4] > m[3]))
+            return 0;
+
+        if (flags & EMBLOB_PACK_HTTP) {
+            const uint64_t* h = &http[i * EMBLOB_PACK_HTTP_WORDS];
+            if (!emblob_pack_string_fits(base + hdr->http_strings_offset, strings_size, h[0]) ||
+                !emblob_pack_string_fits(base + hdr->http_strings_offset, strings_size, h[1]) ||
+                !emblob_pack_fits(h[2], h[3], hdr->blob_size) ||
+                !emblob_pack_fits(h[4], h[5], hdr->blob_size))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Maps the pack file at path (read-only and shared, so that every process
+ * which maps it shares the same pages) and validates it (see
+ * emblob_pack_valid; this reads its tables, but not its blob). Returns NULL
+ * and stores an errno value in err upon failure.
+ */
+static inline
+const emblob_pack_header* emblob_pack_map(const char* path, int flags, int* err)
+{
+    const emblob_pack_header* hdr;
+    struct stat st;
+    void* addr;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1) {
+        *err = errno;
+        return NULL;
+    }
+
+    if (0 != fstat(fd, &st)) {
+        *err = errno;
+        close(fd);
+        return NULL;
+    }
+
+    if (st.st_size < (off_t)sizeof(emblob_pack_header)) {
+        *err = EINVAL;
+        close(fd);
+        return NULL;
+    }
+
+    addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    *err = errno;
+    close(fd);
+
+    if (addr == MAP_FAILED)
+        return NULL;
+
+    hdr = (const emblob_pack_header*)addr;
+    if (hdr->magic != EMBLOB_PACK_MAGIC || hdr->version != EMBLOB_PACK_VERSION ||
+        hdr->byte_order != EMBLOB_PACK_BYTE_ORDER || hdr->header_size != sizeof(emblob_pack_header) ||
+        hdr->file_size != (uint64_t)st.st_size || !emblob_pack_valid(hdr, flags)) {
+        munmap(addr, (size_t)st.st_size);
+        *err = EINVAL;
+        return NULL;
+    }
+
+    *err = 0;
+    return hdr;
+}
+
+/**
+ * Loads the pack file exactly once, no matter how many threads call this
+ * concurrently. The path is taken from the environment variable env, if it is
+ * set, or else path. If the pack cannot be loaded (or is not valid; see
+ * emblob_pack_map), an empty one is used in its place (and the error is
+ * recorded in state).
+ */
+static inline
+const emblob_pack_header* emblob_pack_load(emblob_pack_state* state, const char* path, const char* env,
+    int flags)
+{
+    int expected = 0;
+
+    if (__atomic_load_n(&state->state, __ATOMIC_ACQUIRE) == 2)
+        return state->header;
+
+    if (__atomic_compare_exchange_n(&state->state, &expected, 1, 0,
+        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        const char* env_path = env ? getenv(env) : NULL;
+        state->header = emblob_pack_map(env_path && *env_path ? env_path : path, flags, &state->error);
+        if (!state->header)
+            state->header = &emblob_pack_empty_image.header;
+        __atomic_store_n(&state->state, 2, __ATOMIC_RELEASE);
+        return state->header;
+    }
+
+    while (__atomic_load_n(&state->state, __ATOMIC_ACQUIRE) != 2)
+        sched_yield();
+
+    return state->header;
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_PACK_INCLUDED
+
+#if defined(__APPLE__)
+# define EMBLOB_{NAME}_PACK_STATE {lname}_pack_state
+#else
+# define EMBLOB_{NAME}_PACK_STATE _{lname}_pack_state
+#endif
+
+/**
+ * The blob (and its tables) are not linked into the executable, but are in a
+ * separate pack file, which is mapped the first time that it is accessed.
+ */
+EMBLOB_EXTERNAL emblob_pack_state EMBLOB_{NAME}_PACK_STATE;
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the header of the pack file, mapping it if it has not been already.
+ * The pack file is "{PACK_PATH}" (relative to the working directory), unless
+ * the environment variable EMBLOB_{NAME}_PACK is set, or another path is given
+ * to emblob_{lname}_pack_open. Every accessor function calls this.
+ */
+static inline
+const emblob_pack_header* emblob_{lname}_pack(void)
+{
+    return emblob_pack_load(&EMBLOB_{NAME}_PACK_STATE, "{PACK_PATH}", "EMBLOB_{NAME}_PACK", {PACK_FLAGS});
+}
+
+/**
+ * Maps the pack file at path. Must be called before any other accessor
+ * function in order to have any effect. Returns 0 upon success, or -1 if the
+ * pack file could not be loaded (see emblob_{lname}_pack_error) or was loaded
+ * already.
+ */
+static inline
+int emblob_{lname}_pack_open(const char* path)
+{
+    if (__atomic_load_n(&EMBLOB_{NAME}_PACK_STATE.state, __ATOMIC_ACQUIRE) != 0)
+        return -1;
+
+    return emblob_pack_load(&EMBLOB_{NAME}_PACK_STATE, path, NULL, {PACK_FLAGS}) !=
+        &emblob_pack_empty_image.header ? 0 : -1;
+}
+
+/**
+ * Returns 0 if the pack file was loaded successfully, or else the errno value
+ * which describes why it was not (EINVAL if it is not a valid pack file).
+ */
+static inline
+int emblob_{lname}_pack_error(void)
+{
+    (void)emblob_{lname}_pack();
+    return EMBLOB_{NAME}_PACK_STATE.error;
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+
+#define EMBLOB_{NAME}_PACKED 1
+#define EMBLOB_{NAME}_PACK_AT(type, field) \
+    ((const type*)((const uint8_t*)emblob_{lname}_pack() + emblob_{lname}_pack()->field))
+
+#define EMBLOB_{NAME}_ADDRESS EMBLOB_{NAME}_PACK_AT(uint8_t, blob_offset)
+#define EMBLOB_{NAME}_SIZE (emblob_{lname}_pack()->blob_size)
+#define EMBLOB_{NAME}_MEMBERS EMBLOB_{NAME}_PACK_AT(emblob_member, members_offset)
+#define EMBLOB_{NAME}_MEMBER_SLOTS EMBLOB_{NAME}_PACK_AT(uint32_t, slots_offset)
+#define EMBLOB_{NAME}_MEMBER_NAMES EMBLOB_{NAME}_PACK_AT(char, names_offset)
+#define EMBLOB_{NAME}_DICTIONARY EMBLOB_{NAME}_PACK_AT(uint8_t, dictionary_offset)
+#define EMBLOB_{NAME}_MEMBER_COUNT (emblob_{lname}_pack()->member_count)
+#define EMBLOB_{NAME}_SLOT_MASK (emblob_{lname}_pack()->slot_mask)
+#define EMBLOB_{NAME}_DICTIONARY_SIZE ((size_t)emblob_{lname}_pack()->dictionary_size)
+#define EMBLOB_{NAME}_HTTP EMBLOB_{NAME}_PACK_AT(emblob_http_info, http_offset)
+#define EMBLOB_{NAME}_HTTP_STRINGS EMBLOB_{NAME}_PACK_AT(char, http_strings_offset)
+)EOF";
+    CONST_STATIC_STRING inject = R"EOF(
+#if !defined(_EMBLOB_INJECT_INCLUDED)
+# define _EMBLOB_INJECT_INCLUDED
+
+# include <elf.h>
+# include <sched.h>
+# include <string.h>
+
+# define EMBLOB_INJECT_MAGIC   UINT64_C(0x4753424f4c424d45)
+# define EMBLOB_INJECT_VERSION 1
+
+/**
+ * The header of the segment which emblob inject adds to an executable.
+ */
+typedef struct emblob_inject_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t count;          /* the number of blobs. */
+    uint64_t size;           /* the size of the segment. */
+    uint64_t entries_offset; /* offset of the first emblob_inject_entry. */
+    uint64_t orig_file_size;
+    uint64_t orig_shoff;
+    uint32_t orig_shnum;
+    uint32_t orig_shstrndx;
+    uint64_t reserved;
+} emblob_inject_header;
+
+/**
+ * An injected blob. Offsets are from the beginning of the segment.
+ */
+typedef struct emblob_inject_entry {
+    uint64_t name_offset;
+    uint64_t name_len;
+    uint64_t offset;
+    uint64_t size;
+} emblob_inject_entry;
+
+/**
+ * The location of an injected blob (reserved by the assembly file, and
+ * zero-filled).
+ */
+typedef struct emblob_inject_state {
+    int state; /* 0: not yet located, 1: locating, 2: located (or not found). */
+    int found;
+    const uint8_t* address;
+    uint64_t size;
+    uint64_t reserved;
+} emblob_inject_state;
+
+static const uint8_t emblob_inject_empty[1] = { 0 };
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/* the ELF header of the executable (or shared library) into which this is
+ * linked, as defined by the linker. */
+extern const Elf64_Ehdr __ehdr_start __attribute__((weak, visibility("hidden")));
+
+/**
+ * Returns the segment which emblob inject added, or NULL if there is none, by
+ * walking the program headers of the executable.
+ */
+static inline
+const emblob_inject_header* emblob_inject_segment(void)
+{
+    const Elf64_Ehdr* ehdr = &__ehdr_start;
+    const Elf64_Phdr* phdr;
+    uintptr_t base = 0;
+    int found_base = 0;
+    int n;
+
+    if (UINTPTR_MAX != UINT64_MAX || !ehdr)
+        return NULL;
+
+    /* the ELF header is at the beginning of the first segment. */
+    phdr = (const Elf64_Phdr*)((const uint8_t*)ehdr + ehdr->e_phoff);
+    for (n = 0; n < ehdr->e_phnum && !found_base; n++) {
+        if (phdr[n].p_type == PT_LOAD && phdr[n].p_offset == 0) {
+            base = (uintptr_t)ehdr - (uintptr_t)phdr[n].p_vaddr;
+            found_base = 1;
+        }
+    }
+
+    for (n = 0; n < ehdr->e_phnum && found_base; n++) {
+        const emblob_inject_header* hdr;
+
+        if (phdr[n].p_type != PT_LOAD || phdr[n].p_flags != PF_R ||
+            phdr[n].p_filesz < sizeof(emblob_inject_header))
+            continue;
+
+        hdr = (const emblob_inject_header*)(base + (uintptr_t)phdr[n].p_vaddr);
+        if (hdr->magic == EMBLOB_INJECT_MAGIC && hdr->version == EMBLOB_INJECT_VERSION &&
+            hdr->size <= phdr[n].p_filesz)
+            return hdr;
+    }
+
+    return NULL;
+}
+
+/**
+ * Looks up the blob called name in the injected segment exactly once, no
+ * matter how many threads call this concurrently. A blob which was not
+ * injected is empty.
+ */
+static inline
+void emblob_inject_locate(emblob_inject_state* state, const char* name, size_t name_len)
+{
+    int expected = 0;
+
+    if (__atomic_load_n(&state->state, __ATOMIC_ACQUIRE) == 2)
+        return;
+
+    if (__atomic_compare_exchange_n(&state->state, &expected, 1, 0,
+        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        const emblob_inject_header* seg = emblob_inject_segment();
+        const uint8_t* base = (const uint8_t*)seg;
+        uint32_t n;
+
+        state->address = emblob_inject_empty;
+        state->size    = 0;
+
+        for (n = 0; seg && n < seg->count; n++) {
+            const emblob_inject_entry* e =
+                (const emblob_inject_entry*)(base + seg->entries_offset) + n;
+            if (e->name_len == name_len && 0 == memcmp(base + e->name_offset, name, name_len)) {
+                state->address = base + e->offset;
+                state->size    = e->size;
+                state->found   = 1;
+                break;
+            }
+        }
+
+        __atomic_store_n(&state->state, 2, __ATOMIC_RELEASE);
+        return;
+    }
+
+    while (__atomic_load_n(&state->state, __ATOMIC_ACQUIRE) != 2)
+        sched_yield();
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_INJECT_INCLUDED
+
+#define EMBLOB_{NAME}_INJECT_STATE _{lname}_inject_state
+
+/**
+ * The blob is not linked into the executable, but is added to it afterwards,
+ * by emblob inject.
+ */
+EMBLOB_EXTERNAL emblob_inject_state EMBLOB_{NAME}_INJECT_STATE;
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the location of the blob, looking it up if it has not been already.
+ * Every accessor function calls this.
+ */
+static inline
+const emblob_inject_state* emblob_{lname}_inject(void)
+{
+    emblob_inject_locate(&EMBLOB_{NAME}_INJECT_STATE, "{lname}", sizeof("{lname}") - 1);
+    return &EMBLOB_{NAME}_INJECT_STATE;
+}
+
+/**
+ * Returns nonzero if the blob was injected into the executable (if it was not,
+ * the blob is empty).
+ */
+static inline
+int emblob_{lname}_is_injected(void)
+{
+    return emblob_{lname}_inject()->found;
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+
+#define EMBLOB_{NAME}_INJECTED 1
+#define EMBLOB_{NAME}_ADDRESS (emblob_{lname}_inject()->address)
+#define EMBLOB_{NAME}_SIZE (emblob_{lname}_inject()->size)
+)EOF";
+    CONST_STATIC_STRING inflate = R"EOF(
+#if !defined(_EMBLOB_INFLATE_INCLUDED)
+# define _EMBLOB_INFLATE_INCLUDED
+
+# include <string.h>
+# include <zlib.h>
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/**
+ * Inflates in (raw DEFLATE, compressed against the dictionary dict) into out,
+ * which must be exactly out_len bytes long. Returns 0 upon success, or -1 if
+ * the data could not be inflated. Requires linking with zlib (-lz).
+ */
+static inline
+int emblob_inflate(const uint8_t* in, size_t in_len, const uint8_t* dict, size_t dict_len,
+    void* out, size_t out_len)
+{
+    z_stream strm;
+    int ret;
+
+    memset(&strm, 0, sizeof(strm));
+    if (Z_OK != inflateInit2(&strm, -15))
+        return -1;
+
+    if (dict_len > 0 && Z_OK != inflateSetDictionary(&strm, (const Bytef*)dict, (uInt)dict_len)) {
+        inflateEnd(&strm);
+        return -1;
+    }
+
+    strm.next_in   = (Bytef*)(uintptr_t)in;
+    strm.avail_in  = (uInt)in_len;
+    strm.next_out  = (Bytef*)out;
+    strm.avail_out = (uInt)out_len;
+
+    ret = inflate(&strm, Z_FINISH);
+    inflateEnd(&strm);
+
+    return (ret == Z_STREAM_END && strm.total_out == out_len) ? 0 : -1;
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_INFLATE_INCLUDED
+
+#define EMBLOB_{NAME}_COMPRESSED 1
+)EOF";
+    CONST_STATIC_STRING directory = R"EOF(
+#if !defined(_EMBLOB_DIRECTORY_INCLUDED)
+# define _EMBLOB_DIRECTORY_INCLUDED
+
+# include <string.h>
+
+/* the member's stored bytes are raw DEFLATE, against the blob's dictionary. */
+# define EMBLOB_MEMBER_DEFLATE UINT64_C(1)
+
+/**
+ * Describes one file (member) of an embedded directory.
+ */
+typedef struct emblob_member {
+    uint64_t name_offset; /* offset of the NUL-terminated name in the name pool. */
+    uint64_t name_len;    /* length of the name, in bytes. */
+    uint64_t offset;      /* offset of the stored bytes within the blob. */
+    uint64_t stored_size; /* size of the stored bytes. */
+    uint64_t size;        /* size of the member's contents. */
+    uint64_t hash;        /* FNV-1a hash of the name. */
+    uint64_t flags;       /* EMBLOB_MEMBER_* flags. */
+} emblob_member;
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/**
+ * Returns the FNV-1a hash of the len bytes at name.
+ */
+static inline
+uint64_t emblob_hash_name(const char* name, size_t len)
+{
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    size_t n;
+
+    for (n = 0; n < len; n++) {
+        hash ^= (uint8_t)name[n];
+        hash *= UINT64_C(0x100000001b3);
+    }
+
+    return hash;
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_DIRECTORY_INCLUDED
+
+/* (in pack mode, these are all defined in terms of the pack file instead.) */
+#if !defined(EMBLOB_{NAME}_PACKED)
+# if defined(__APPLE__)
+#  define EMBLOB_{NAME}_MEMBERS {lname}_members
+#  define EMBLOB_{NAME}_MEMBER_SLOTS {lname}_member_slots
+#  define EMBLOB_{NAME}_MEMBER_NAMES {lname}_member_names
+#  define EMBLOB_{NAME}_DICTIONARY {lname}_dictionary
+# else
+#  define EMBLOB_{NAME}_MEMBERS _{lname}_members
+#  define EMBLOB_{NAME}_MEMBER_SLOTS _{lname}_member_slots
+#  define EMBLOB_{NAME}_MEMBER_NAMES _{lname}_member_names
+#  define EMBLOB_{NAME}_DICTIONARY _{lname}_dictionary
+# endif
+
+# define EMBLOB_{NAME}_MEMBER_COUNT UINT64_C({MEMBER_COUNT})
+# define EMBLOB_{NAME}_SLOT_MASK UINT64_C({SLOT_MASK})
+# define EMBLOB_{NAME}_DICTIONARY_SIZE {DICTIONARY_SIZE}
+
+/**
+ * The members of the embedded directory (in order of name), the slots of the
+ * hash table used to look them up by name (each holds a member index + 1, or
+ * zero), the pool of their names, and the dictionary that compressed members
+ * were compressed against.
+ */
+EMBLOB_EXTERNAL const emblob_member EMBLOB_{NAME}_MEMBERS[];
+EMBLOB_EXTERNAL const uint32_t EMBLOB_{NAME}_MEMBER_SLOTS[];
+EMBLOB_EXTERNAL const char EMBLOB_{NAME}_MEMBER_NAMES[];
+EMBLOB_EXTERNAL const uint8_t EMBLOB_{NAME}_DICTIONARY[];
+#endif
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the number of members in the embedded directory.
+ */
+static inline
+uint64_t emblob_{lname}_member_count(void)
+{
+    return EMBLOB_{NAME}_MEMBER_COUNT;
+}
+
+/**
+ * Returns the description of member i, or NULL if i is out of range.
+ */
+static inline
+const emblob_member* emblob_{lname}_member(uint64_t i)
+{
+    return i < EMBLOB_{NAME}_MEMBER_COUNT ? &EMBLOB_{NAME}_MEMBERS[i] : NULL;
+}
+
+/**
+ * Returns the name of member i (its path relative to the embedded directory,
+ * with '/' separators), or NULL if i is out of range.
+ */
+static inline
+const char* emblob_{lname}_member_name(uint64_t i)
+{
+    const emblob_member* m = emblob_{lname}_member(i);
+    return m ? EMBLOB_{NAME}_MEMBER_NAMES + m->name_offset : NULL;
+}
+
+/**
+ * Returns the index of the member whose name is the len bytes at name, or -1
+ * if there is no such member. Takes O(1) time (on average).
+ */
+static inline
+int64_t emblob_{lname}_findn(const char* name, size_t len)
+{
+    uint64_t hash = emblob_hash_name(name, len);
+    uint64_t slot = hash & EMBLOB_{NAME}_SLOT_MASK;
+
+    {PROFILE_HIT}
+    while (EMBLOB_{NAME}_MEMBER_SLOTS[slot] != 0) {
+        const emblob_member* m = &EMBLOB_{NAME}_MEMBERS[EMBLOB_{NAME}_MEMBER_SLOTS[slot] - 1];
+        if (m->hash == hash && m->name_len == len &&
+            0 == memcmp(EMBLOB_{NAME}_MEMBER_NAMES + m->name_offset, name, len))
+            return (int64_t)(EMBLOB_{NAME}_MEMBER_SLOTS[slot] - 1);
+        slot = (slot + 1) & EMBLOB_{NAME}_SLOT_MASK;
+    }
+
+    return -1;
+}
+
+/**
+ * Returns the index of the member whose name is the NUL-terminated string name,
+ * or -1 if there is no such member.
+ */
+static inline
+int64_t emblob_{lname}_find(const char* name)
+{
+    return emblob_{lname}_findn(name, strlen(name));
+}
+
+/**
+ * Returns a pointer to the contents of member i, and stores their size in len,
+ * if it is not NULL. Returns NULL if i is out of range, or if the member is
+ * compressed (see emblob_{lname}_member_extract).
+ */
+static inline
+const uint8_t* emblob_{lname}_member_data(uint64_t i, size_t* len)
+{
+    const emblob_member* m = emblob_{lname}_member(i);
+
+    if (len)
+        *len = 0;
+
+    if (!m || (m->flags & EMBLOB_MEMBER_DEFLATE))
+        return NULL;
+
+    {PROFILE_MEMBER(i)}
+    if (len)
+        *len = (size_t)m->size;
+
+    return (const uint8_t*)EMBLOB_{NAME}_ADDRESS + m->offset;
+}
+
+/**
+ * Does the work of emblob_{lname}_member_extract, without counting the access
+ * in the profile counters (if any). The member cache loads members with it.
+ */
+static inline
+int emblob_{lname}_member_load(uint64_t i, void* buf, size_t buf_len)
+{
+    const emblob_member* m = emblob_{lname}_member(i);
+
+    if (!m || buf_len < m->size)
+        return -1;
+
+    if (m->flags & EMBLOB_MEMBER_DEFLATE) {
+#if defined(EMBLOB_{NAME}_COMPRESSED)
+        return emblob_inflate((const uint8_t*)EMBLOB_{NAME}_ADDRESS + m->offset, (size_t)m->stored_size,
+            EMBLOB_{NAME}_DICTIONARY, EMBLOB_{NAME}_DICTIONARY_SIZE, buf, (size_t)m->size);
+#else
+        return -1;
+#endif
+    }
+
+    memcpy(buf, (const uint8_t*)EMBLOB_{NAME}_ADDRESS + m->offset, (size_t)m->size);
+    return 0;
+}
+
+/**
+ * Copies the contents of member i (decompressing them, if necessary) into buf,
+ * which must be at least emblob_{lname}_member(i)->size bytes long. Returns 0
+ * upon success, or -1 if i is out of range, buf is too small, or the contents
+ * could not be decompressed.
+ */
+static inline
+int emblob_{lname}_member_extract(uint64_t i, void* buf, size_t buf_len)
+{
+    {PROFILE_MEMBER(i)}
+    return emblob_{lname}_member_load(i, buf, buf_len);
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+)EOF";
+    CONST_STATIC_STRING member_cache = R"EOF(
+#if !defined(_EMBLOB_MEMBER_CACHE_INCLUDED)
+# define _EMBLOB_MEMBER_CACHE_INCLUDED
+
+# include <stdlib.h>
+# include <string.h>
+# include <sched.h>
+
+/* the default byte budget of a member cache; may be overridden here, or at
+ * runtime with emblob_{blob}_cache_set_budget. */
+# if !defined(EMBLOB_CACHE_DEFAULT_BUDGET)
+#  define EMBLOB_CACHE_DEFAULT_BUDGET (UINT64_C(8) * 1024 * 1024)
+# endif
+
+/* a slot's state word is one of the EMBLOB_CACHE_* states, plus the number of
+ * readers which hold its contents, in units of EMBLOB_CACHE_REF. */
+# define EMBLOB_CACHE_EMPTY      UINT64_C(0)
+# define EMBLOB_CACHE_LOADING    UINT64_C(1)
+# define EMBLOB_CACHE_READY      UINT64_C(2)
+# define EMBLOB_CACHE_EVICTING   UINT64_C(3)
+# define EMBLOB_CACHE_STATE_MASK UINT64_C(3)
+# define EMBLOB_CACHE_REF        UINT64_C(4)
+
+/**
+ * The cached (decompressed) contents of one member. The storage for the slots
+ * is reserved by the assembly file (32 bytes apiece, zero-filled), or in pack
+ * mode, allocated upon first use.
+ */
+typedef struct emblob_cache_slot {
+    uint64_t word;
+    uint64_t referenced; /* set on each hit; cleared by the CLOCK hand. */
+    uint64_t size;
+    void* data;
+} emblob_cache_slot;
+
+/**
+ * The state of a member cache (64 bytes, zero-filled).
+ */
+typedef struct emblob_cache {
+    uint64_t budget;
+    uint64_t budget_set;
+    uint64_t used;
+    uint64_t hand;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t slots; /* in pack mode, the address of the (allocated) slots. */
+} emblob_cache;
+
+/**
+ * A snapshot of the counters of a member cache.
+ */
+typedef struct emblob_cache_stats {
+    uint64_t hits;      /* requests satisfied from the cache. */
+    uint64_t misses;    /* requests which decompressed the member. */
+    uint64_t evictions; /* members evicted to stay within the budget. */
+    uint64_t used;      /* bytes of decompressed members currently cached. */
+    uint64_t budget;    /* the byte budget. */
+} emblob_cache_stats;
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+static inline
+uint64_t emblob_cache_budget(const emblob_cache* cache)
+{
+    return __atomic_load_n(&cache->budget_set, __ATOMIC_ACQUIRE)
+        ? __atomic_load_n(&cache->budget, __ATOMIC_RELAXED) : EMBLOB_CACHE_DEFAULT_BUDGET;
+}
+
+/**
+ * Evicts unreferenced members (by way of the CLOCK algorithm: a member which
+ * has been hit since the hand last passed it gets a second chance) until no
+ * more than target bytes are cached, or every cached member is in use.
+ */
+static inline
+void emblob_cache_trim(emblob_cache* cache, emblob_cache_slot* slots, uint64_t count,
+    uint64_t target)
+{
+    uint64_t scanned;
+
+    if (!slots || count == 0)
+        return;
+
+    for (scanned = 0; scanned < count * 2 &&
+        __atomic_load_n(&cache->used, __ATOMIC_RELAXED) > target; scanned++) {
+        emblob_cache_slot* slot = &slots[__atomic_fetch_add(&cache->hand, 1, __ATOMIC_RELAXED) % count];
+        uint64_t expected = EMBLOB_CACHE_READY;
+
+        /* skip slots which are empty, busy, or in use. */
+        if (__atomic_load_n(&slot->word, __ATOMIC_RELAXED) != EMBLOB_CACHE_READY)
+            continue;
+        if (__atomic_exchange_n(&slot->referenced, 0, __ATOMIC_RELAXED))
+            continue;
+        if (!__atomic_compare_exchange_n(&slot->word, &expected, EMBLOB_CACHE_EVICTING, 0,
+            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            continue;
+
+        free(slot->data);
+        slot->data = NULL;
+        __atomic_fetch_sub(&cache->used, slot->size, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&cache->evictions, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->word, EMBLOB_CACHE_EMPTY, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * Returns the decompressed contents of member i, which remain valid until the
+ * caller releases them with emblob_cache_release. A hit takes no locks. Upon a
+ * miss, exactly one thread decompresses the member (by calling extract); any
+ * others which want it meanwhile wait for that thread to finish. Returns NULL
+ * if the member could not be decompressed.
+ */
+static inline
+const uint8_t* emblob_cache_acquire(emblob_cache* cache, emblob_cache_slot* slots, uint64_t count,
+    uint64_t i, uint64_t size, int (*extract)(uint64_t, void*, size_t))
+{
+    emblob_cache_slot* slot = &slots[i];
+    uint64_t word = __atomic_load_n(&slot->word, __ATOMIC_ACQUIRE);
+    void* data;
+
+    for (;;) {
+        switch (word & EMBLOB_CACHE_STATE_MASK) {
+            case EMBLOB_CACHE_READY:
+                if (__atomic_compare_exchange_n(&slot->word, &word, word + EMBLOB_CACHE_REF, 0,
+                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+                    if (!__atomic_load_n(&slot->referenced, __ATOMIC_RELAXED))
+                        __atomic_store_n(&slot->referenced, 1, __ATOMIC_RELAXED);
+                    __atomic_fetch_add(&cache->hits, 1, __ATOMIC_RELAXED);
+                    return (const uint8_t*)slot->data;
+                }
+                continue;
+            case EMBLOB_CACHE_EMPTY:
+                if (__atomic_compare_exchange_n(&slot->word, &word, EMBLOB_CACHE_LOADING, 0,
+                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+                    break;
+                continue;
+            default:
+                /* another thread is loading or evicting it. */
+                sched_yield();
+                word = __atomic_load_n(&slot->word, __ATOMIC_ACQUIRE);
+                continue;
+        }
+
+        break;
+    }
+
+    __atomic_fetch_add(&cache->misses, 1, __ATOMIC_RELAXED);
+
+    data = malloc(size > 0 ? (size_t)size : 1);
+    if (!data || 0 != extract(i, data, (size_t)size)) {
+        free(data);
+        __atomic_store_n(&slot->word, EMBLOB_CACHE_EMPTY, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    slot->data = data;
+    slot->size = size;
+    __atomic_store_n(&slot->referenced, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&cache->used, size, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->word, EMBLOB_CACHE_READY + EMBLOB_CACHE_REF, __ATOMIC_RELEASE);
+
+    emblob_cache_trim(cache, slots, count, emblob_cache_budget(cache));
+    return (const uint8_t*)data;
+}
+
+/**
+ * Releases contents of member i obtained from emblob_cache_acquire.
+ */
+static inline
+void emblob_cache_release(emblob_cache* cache, emblob_cache_slot* slots, uint64_t count, uint64_t i)
+{
+    uint64_t budget;
+
+    __atomic_fetch_sub(&slots[i].word, EMBLOB_CACHE_REF, __ATOMIC_RELEASE);
+
+    /* members which were in use may have kept the cache over its budget. */
+    budget = emblob_cache_budget(cache);
+    if (__atomic_load_n(&cache->used, __ATOMIC_RELAXED) > budget)
+        emblob_cache_trim(cache, slots, count, budget);
+}
+
+static inline
+void emblob_cache_get_stats(const emblob_cache* cache, emblob_cache_stats* stats)
+{
+    stats->hits      = __atomic_load_n(&cache->hits, __ATOMIC_RELAXED);
+    stats->misses    = __atomic_load_n(&cache->misses, __ATOMIC_RELAXED);
+    stats->evictions = __atomic_load_n(&cache->evictions, __ATOMIC_RELAXED);
+    stats->used      = __atomic_load_n(&cache->used, __ATOMIC_RELAXED);
+    stats->budget    = emblob_cache_budget(cache);
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_MEMBER_CACHE_INCLUDED
+
+#if defined(__APPLE__)
+# define EMBLOB_{NAME}_CACHE {lname}_cache
+#else
+# define EMBLOB_{NAME}_CACHE _{lname}_cache
+#endif
+
+/**
+ * The cache of decompressed members, shared by every translation unit which
+ * includes this file.
+ */
+EMBLOB_EXTERNAL emblob_cache EMBLOB_{NAME}_CACHE;
+
+#if defined(EMBLOB_{NAME}_PACKED)
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/**
+ * The number of members is not known until the pack file is loaded, so the
+ * slots are allocated upon first use.
+ */
+static inline
+emblob_cache_slot* emblob_{lname}_cache_slots(void)
+{
+    uint64_t slots = __atomic_load_n(&EMBLOB_{NAME}_CACHE.slots, __ATOMIC_ACQUIRE);
+    uint64_t expected = 0;
+    uint64_t count = EMBLOB_{NAME}_MEMBER_COUNT;
+    void* alloc;
+
+    if (slots)
+        return (emblob_cache_slot*)(uintptr_t)slots;
+
+    alloc = calloc(count > 0 ? (size_t)count : 1, sizeof(emblob_cache_slot));
+    if (!alloc)
+        return NULL;
+
+    if (!__atomic_compare_exchange_n(&EMBLOB_{NAME}_CACHE.slots, &expected, (uint64_t)(uintptr_t)alloc,
+        0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(alloc);
+        return (emblob_cache_slot*)(uintptr_t)expected;
+    }
+
+    return (emblob_cache_slot*)alloc;
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+
+# define EMBLOB_{NAME}_CACHE_SLOTS emblob_{lname}_cache_slots()
+#else
+# if defined(__APPLE__)
+#  define EMBLOB_{NAME}_CACHE_SLOTS {lname}_cache_slots
+# else
+#  define EMBLOB_{NAME}_CACHE_SLOTS _{lname}_cache_slots
+# endif
+
+EMBLOB_EXTERNAL emblob_cache_slot EMBLOB_{NAME}_CACHE_SLOTS[];
+#endif
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the contents of member i, and stores their size in len, if it is not
+ * NULL. Compressed members are decompressed once and cached, within the cache's
+ * byte budget; the contents remain valid until they are released with
+ * emblob_{lname}_cache_release. Returns NULL if i is out of range, or if the
+ * contents could not be decompressed. Safe to call from any thread.
+ */
+static inline
+const uint8_t* emblob_{lname}_cache_get(uint64_t i, size_t* len)
+{
+    const emblob_member* m = emblob_{lname}_member(i);
+    emblob_cache_slot* slots;
+    const uint8_t* data;
+
+    if (len)
+        *len = 0;
+
+    if (!m)
+        return NULL;
+
+    if (!(m->flags & EMBLOB_MEMBER_DEFLATE))
+        return emblob_{lname}_member_data(i, len);
+
+    {PROFILE_MEMBER(i)}
+    slots = EMBLOB_{NAME}_CACHE_SLOTS;
+    if (!slots)
+        return NULL;
+
+    data = emblob_cache_acquire(&EMBLOB_{NAME}_CACHE, slots, EMBLOB_{NAME}_MEMBER_COUNT, i, m->size,
+        emblob_{lname}_member_load);
+    if (data && len)
+        *len = (size_t)m->size;
+
+    return data;
+}
+
+/**
+ * Releases the contents of member i, which were obtained from
+ * emblob_{lname}_cache_get, so that they may be evicted.
+ */
+static inline
+void emblob_{lname}_cache_release(uint64_t i)
+{
+    const emblob_member* m = emblob_{lname}_member(i);
+
+    if (m && (m->flags & EMBLOB_MEMBER_DEFLATE))
+        emblob_cache_release(&EMBLOB_{NAME}_CACHE, EMBLOB_{NAME}_CACHE_SLOTS,
+            EMBLOB_{NAME}_MEMBER_COUNT, i);
+}
+
+/**
+ * Sets the maximum number of bytes of decompressed members to keep cached
+ * (EMBLOB_CACHE_DEFAULT_BUDGET by default), evicting members if necessary.
+ * Members which are in use are never evicted, so the budget may be exceeded
+ * while they are.
+ */
+static inline
+void emblob_{lname}_cache_set_budget(uint64_t bytes)
+{
+    __atomic_store_n(&EMBLOB_{NAME}_CACHE.budget, bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&EMBLOB_{NAME}_CACHE.budget_set, 1, __ATOMIC_RELEASE);
+    emblob_cache_trim(&EMBLOB_{NAME}_CACHE, EMBLOB_{NAME}_CACHE_SLOTS,
+        EMBLOB_{NAME}_MEMBER_COUNT, bytes);
+}
+
+/**
+ * Evicts every cached member which is not in use.
+ */
+static inline
+void emblob_{lname}_cache_clear(void)
+{
+    emblob_cache_trim(&EMBLOB_{NAME}_CACHE, EMBLOB_{NAME}_CACHE_SLOTS,
+        EMBLOB_{NAME}_MEMBER_COUNT, 0);
+}
+
+/**
+ * Stores a snapshot of the cache's counters in stats.
+ */
+static inline
+void emblob_{lname}_cache_stats(emblob_cache_stats* stats)
+{
+    emblob_cache_get_stats(&EMBLOB_{NAME}_CACHE, stats);
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+)EOF";
+    CONST_STATIC_STRING http = R"EOF(
+#if !defined(_EMBLOB_HTTP_INCLUDED)
+# define _EMBLOB_HTTP_INCLUDED
+
+# include <string.h>
+
+# define EMBLOB_ENCODING_IDENTITY 0
+# define EMBLOB_ENCODING_GZIP     1
+# define EMBLOB_ENCODING_BR       2
+
+/**
+ * A precompressed variant of a member: its offset within the blob, and its
+ * size (zero if there is no such variant).
+ */
+typedef struct emblob_http_variant {
+    uint64_t offset;
+    uint64_t size;
+} emblob_http_variant;
+
+/**
+ * The HTTP response metadata of a member.
+ */
+typedef struct emblob_http_info {
+    uint64_t mime_offset; /* offset of the MIME type in the string pool. */
+    uint64_t etag_offset; /* offset of the (quoted) strong ETag in the string pool. */
+    emblob_http_variant variants[2]; /* gzip, br. */
+} emblob_http_info;
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+static inline
+int emblob_http_token_eq(const char* a, size_t a_len, const char* b)
+{
+    size_t n;
+
+    for (n = 0; n < a_len; n++) {
+        char ca = a[n], cb = b[n];
+        if (cb == '\0')
+            return 0;
+        if (ca >= 'A' && ca <= 'Z')
+            ca = (char)(ca - 'A' + 'a');
+        if (ca != cb)
+            return 0;
+    }
+
+    return b[a_len] == '\0';
+}
+
+/**
+ * Returns nonzero if the value of an Accept-Encoding header permits the
+ * (lowercase) content coding, either by name or by way of "*", with a
+ * nonzero q-value.
+ */
+static inline
+int emblob_http_accepts(const char* accept_encoding, const char* coding)
+{
+    const char* p = accept_encoding;
+    int named = -1, wildcard = -1;
+
+    while (p && *p) {
+        const char* tok;
+        size_t tok_len;
+        int accepted = 1;
+
+        while (*p == ' ' || *p == '\t' || *p == ',')
+            p++;
+
+        tok = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ' && *p != '\t')
+            p++;
+        tok_len = (size_t)(p - tok);
+
+        /* parameters; only q matters, and only whether it is zero. */
+        while (*p && *p != ',') {
+            if ((*p == 'q' || *p == 'Q') && p[1] == '=') {
+                const char* q = p + 2;
+                accepted = 0;
+                for (; *q && *q != ',' && *q != ';' && *q != ' '; q++) {
+                    if (*q != '0' && *q != '.')
+                        accepted = 1;
+                }
+                p = q;
+                continue;
+            }
+            p++;
+        }
+
+        if (tok_len == 1 && tok[0] == '*')
+            wildcard = accepted;
+        else if (tok_len > 0 && emblob_http_token_eq(tok, tok_len, coding))
+            named = accepted;
+    }
+
+    return named != -1 ? named : wildcard == 1;
+}
+
+/**
+ * Returns nonzero if the value of an If-None-Match header matches etag, in
+ * which case the response should be 304 (Not Modified).
+ */
+static inline
+int emblob_http_etag_matches(const char* if_none_match, const char* etag)
+{
+    const char* p = if_none_match;
+    size_t etag_len = strlen(etag);
+
+    while (p && *p) {
+        const char* tok;
+
+        while (*p == ' ' || *p == '\t' || *p == ',')
+            p++;
+
+        if (*p == '*')
+            return 1;
+
+        /* If-None-Match uses the weak comparison. */
+        if (p[0] == 'W' && p[1] == '/')
+            p += 2;
+
+        tok = p;
+        while (*p && *p != ',' && *p != ' ' && *p != '\t')
+            p++;
+
+        if ((size_t)(p - tok) == etag_len && 0 == memcmp(tok, etag, etag_len))
+            return 1;
+    }
+
+    return 0;
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_HTTP_INCLUDED
+
+#if !defined(EMBLOB_{NAME}_PACKED)
+# if defined(__APPLE__)
+#  define EMBLOB_{NAME}_HTTP {lname}_http
+#  define EMBLOB_{NAME}_HTTP_STRINGS {lname}_http_strings
+# else
+#  define EMBLOB_{NAME}_HTTP _{lname}_http
+#  define EMBLOB_{NAME}_HTTP_STRINGS _{lname}_http_strings
+# endif
+
+/**
+ * The HTTP response metadata of each member, and the pool of strings (MIME
+ * types and ETags) that it refers to.
+ */
+EMBLOB_EXTERNAL const emblob_http_info EMBLOB_{NAME}_HTTP[];
+EMBLOB_EXTERNAL const char EMBLOB_{NAME}_HTTP_STRINGS[];
+#endif
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the HTTP response metadata of member i, or NULL if i is out of range.
+ */
+static inline
+const emblob_http_info* emblob_{lname}_http(uint64_t i)
+{
+    return i < EMBLOB_{NAME}_MEMBER_COUNT ? &EMBLOB_{NAME}_HTTP[i] : NULL;
+}
+
+/**
+ * Returns the MIME type of member i (e.g. "text/html; charset=utf-8"), or NULL
+ * if i is out of range.
+ */
+static inline
+const char* emblob_{lname}_member_mime(uint64_t i)
+{
+    const emblob_http_info* h = emblob_{lname}_http(i);
+    return h ? EMBLOB_{NAME}_HTTP_STRINGS + h->mime_offset : NULL;
+}
+
+/**
+ * Returns the strong ETag of member i, quoted, as it appears in an ETag header,
+ * or NULL if i is out of range.
+ */
+static inline
+const char* emblob_{lname}_member_etag(uint64_t i)
+{
+    const emblob_http_info* h = emblob_{lname}_http(i);
+    return h ? EMBLOB_{NAME}_HTTP_STRINGS + h->etag_offset : NULL;
+}
+
+/**
+ * Returns a pointer to the contents of member i in the given content coding
+ * (one of the EMBLOB_ENCODING_* values), and stores their size in len, if it is
+ * not NULL. Returns NULL if there is no such variant (or, for identity, if the
+ * member is compressed; see emblob_{lname}_member_extract).
+ */
+static inline
+const uint8_t* emblob_{lname}_member_variant(uint64_t i, int encoding, size_t* len)
+{
+    const emblob_http_info* h = emblob_{lname}_http(i);
+    const emblob_http_variant* v;
+
+    if (encoding == EMBLOB_ENCODING_IDENTITY)
+        return emblob_{lname}_member_data(i, len);
+
+    if (len)
+        *len = 0;
+
+    if (!h || (encoding != EMBLOB_ENCODING_GZIP && encoding != EMBLOB_ENCODING_BR))
+        return NULL;
+
+    v = &h->variants[encoding - 1];
+    if (v->size == 0)
+        return NULL;
+
+    {PROFILE_MEMBER(i)}
+    if (len)
+        *len = (size_t)v->size;
+
+    return (const uint8_t*)EMBLOB_{NAME}_ADDRESS + v->offset;
+}
+
+/**
+ * Chooses the best stored variant of member i which the value of an
+ * Accept-Encoding header (which may be NULL) permits, preferring br to gzip,
+ * and returns it (EMBLOB_ENCODING_IDENTITY if neither is permitted or stored).
+ */
+static inline
+int emblob_{lname}_member_negotiate(uint64_t i, const char* accept_encoding)
+{
+    const emblob_http_info* h = emblob_{lname}_http(i);
+
+    if (!h || !accept_encoding)
+        return EMBLOB_ENCODING_IDENTITY;
+
+    if (h->variants[EMBLOB_ENCODING_BR - 1].size > 0 && emblob_http_accepts(accept_encoding, "br"))
+        return EMBLOB_ENCODING_BR;
+
+    if (h->variants[EMBLOB_ENCODING_GZIP - 1].size > 0 && emblob_http_accepts(accept_encoding, "gzip"))
+        return EMBLOB_ENCODING_GZIP;
+
+    return EMBLOB_ENCODING_IDENTITY;
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+)EOF";
+    CONST_STATIC_STRING registry = R"EOF(
+#if !defined(_EMBLOB_REGISTRY_INCLUDED)
+# define _EMBLOB_REGISTRY_INCLUDED
+
+# include <stdlib.h>
+# include <string.h>
+# include <sched.h>
+
+# define EMBLOB_REGISTRY_DIRECTORY  UINT64_C(0x01)
+# define EMBLOB_REGISTRY_COMPRESSED UINT64_C(0x02)
+# define EMBLOB_REGISTRY_SPARSE     UINT64_C(0x04)
+# define EMBLOB_REGISTRY_ELEMENTS   UINT64_C(0x08)
+# define EMBLOB_REGISTRY_JSON_TAPE  UINT64_C(0x10)
+# define EMBLOB_REGISTRY_INDEX      UINT64_C(0x20)
+
+/**
+ * The registry record of a blob which was generated with --registry. The
+ * records of every such blob linked into an executable (or shared library)
+ * are gathered by the linker into a single section.
+ */
+typedef struct emblob_registry_entry {
+    const char* name;  /* the blob's name (e.g. "foo" for emblob_foo.h). */
+    const void* data;  /* the blob's address (for a sparse blob, see its _materialize function). */
+    uint64_t size;     /* the blob's size, in bytes. */
+    uint64_t hash;     /* FNV-1a hash of the name. */
+    uint64_t flags;    /* EMBLOB_REGISTRY_* flags. */
+} emblob_registry_entry;
+
+# if defined(__APPLE__)
+extern emblob_registry_entry emblob_registry_start[] __asm("section$start$__DATA$__emblob_reg");
+extern emblob_registry_entry emblob_registry_stop[] __asm("section$end$__DATA$__emblob_reg");
+#  define EMBLOB_REGISTRY_START emblob_registry_start
+#  define EMBLOB_REGISTRY_STOP emblob_registry_stop
+#  define EMBLOB_REGISTRY_STATE emblob_registry_state
+# else
+extern emblob_registry_entry __start_emblob_registry[] __attribute__((weak, visibility("hidden")));
+extern emblob_registry_entry __stop_emblob_registry[] __attribute__((weak, visibility("hidden")));
+#  define EMBLOB_REGISTRY_START __start_emblob_registry
+#  define EMBLOB_REGISTRY_STOP __stop_emblob_registry
+#  define EMBLOB_REGISTRY_STATE _emblob_registry_state
+# endif
+
+/* defined (weakly) by every blob which is registered, so that the records are
+ * sorted only once. each executable or shared library has its own. */
+EMBLOB_EXTERNAL int EMBLOB_REGISTRY_STATE __attribute__((visibility("hidden")));
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+static inline
+int emblob_registry_compare(const void* a, const void* b)
+{
+    return strcmp(((const emblob_registry_entry*)a)->name, ((const emblob_registry_entry*)b)->name);
+}
+
+/**
+ * Returns the records of every registered blob, sorted by name, and stores
+ * their number in count. The records are sorted in place the first time that
+ * any registry function is called (by exactly one thread; there are no static
+ * initializers), unless the linker happened to put them in order already.
+ */
+static inline
+const emblob_registry_entry* emblob_registry(size_t* count)
+{
+    emblob_registry_entry* start = EMBLOB_REGISTRY_START;
+    size_t n = (size_t)(EMBLOB_REGISTRY_STOP - EMBLOB_REGISTRY_START);
+    int expected = 0;
+
+    *count = n;
+    if (__atomic_load_n(&EMBLOB_REGISTRY_STATE, __ATOMIC_ACQUIRE) == 2)
+        return start;
+
+    if (__atomic_compare_exchange_n(&EMBLOB_REGISTRY_STATE, &expected, 1, 0,
+        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        size_t i;
+        for (i = 1; i < n; i++) {
+            if (emblob_registry_compare(&start[i - 1], &start[i]) > 0) {
+                qsort(start, n, sizeof(*start), emblob_registry_compare);
+                break;
+            }
+        }
+        __atomic_store_n(&EMBLOB_REGISTRY_STATE, 2, __ATOMIC_RELEASE);
+        return start;
+    }
+
+    while (__atomic_load_n(&EMBLOB_REGISTRY_STATE, __ATOMIC_ACQUIRE) != 2)
+        sched_yield();
+
+    return start;
+}
+
+/**
+ * Returns the number of registered blobs.
+ */
+static inline
+size_t emblob_registry_count(void)
+{
+    size_t count;
+    (void)emblob_registry(&count);
+    return count;
+}
+
+/**
+ * Returns the record of the i-th registered blob, in order of name, or NULL if
+ * i is out of range.
+ */
+static inline
+const emblob_registry_entry* emblob_registry_at(size_t i)
+{
+    size_t count;
+    const emblob_registry_entry* entries = emblob_registry(&count);
+    return i < count ? &entries[i] : NULL;
+}
+
+/**
+ * Returns the record of the registered blob whose name is the NUL-terminated
+ * string name, or NULL if there is no such blob. Takes O(log n) time.
+ */
+static inline
+const emblob_registry_entry* emblob_registry_find(const char* name)
+{
+    size_t lo = 0, hi;
+    const emblob_registry_entry* entries = emblob_registry(&hi);
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(entries[mid].name, name);
+        if (cmp == 0)
+            return &entries[mid];
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return NULL;
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_REGISTRY_INCLUDED
+)EOF";
+    CONST_STATIC_STRING cxx_names = R"EOF(
+#if defined(__cplusplus) && __cplusplus >= 202002L
+# if !defined(_EMBLOB_CXX_NAMES_INCLUDED)
+#  define _EMBLOB_CXX_NAMES_INCLUDED
+
+#  include <cstddef>
+#  include <string_view>
+
+namespace emblob
+{
+    /**
+     * A string literal, usable as a template argument (e.g. get<"index.html">()).
+     */
+    template<std::size_t N>
+    struct literal
+    {
+        char str[N] {};
+
+        consteval literal(const char (&s)[N]) {
+            for (std::size_t n = 0; n < N; n++)
+                str[n] = s[n];
+        }
+
+        constexpr std::string_view view() const {
+            return std::string_view(str, N - 1);
+        }
+    };
+
+    /**
+     * The compile-time description of a member.
+     */
+    struct member_info
+    {
+        std::string_view name;
+        uint64_t offset;
+        uint64_t size;
+        bool compressed;
+    };
+
+    /**
+     * The contents of a member.
+     */
+    struct member_ref
+    {
+        const uint8_t* data;
+        std::size_t size;
+    };
+
+    /* the index of the member named key in a table sorted by name, or -1. */
+    template<std::size_t N>
+    consteval int64_t find_member(const member_info (&members)[N], std::string_view key) {
+        std::size_t lo = 0, hi = N;
+        while (lo < hi) {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (members[mid].name == key)
+                return static_cast<int64_t>(mid);
+            if (members[mid].name < key)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return -1;
+    }
+} // !namespace emblob
+# endif // !_EMBLOB_CXX_NAMES_INCLUDED
+
+namespace emblob::{lname}
+{
+    /**
+     * The members of the embedded directory, in order of name.
+     */
+    inline constexpr member_info members[] = {
+{CXX_MEMBERS}
+    };
+
+    /**
+     * The index of the member named N, resolved at compile time; names which
+     * do not exist are a compile error. Use emblob_{lname}_find for names which
+     * are not known until runtime.
+     */
+    template<literal N>
+    consteval uint64_t index_of() {
+        constexpr int64_t index = find_member(members, N.view());
+        static_assert(index >= 0, "emblob_{lname}.h has no member with this name");
+        return index >= 0 ? static_cast<uint64_t>(index) : 0;
+    }
+
+    /**
+     * The contents of the member named N, resolved at compile time (only their
+     * address within the blob is computed at runtime). The member must not be
+     * compressed; use index_of<N>() with emblob_{lname}_member_extract or
+     * emblob_{lname}_cache_get for compressed members.
+     */
+    template<literal N>
+    inline member_ref get() {
+        constexpr member_info info = members[index_of<N>()];
+        static_assert(!info.compressed, "this member of emblob_{lname}.h is compressed");
+        {PROFILE_MEMBER(index_of<N>())}
+        /* the blob is declared as a single uintptr_t, so the offset is added as
+         * an integer, lest the compiler think it is out of bounds. */
+        auto base = reinterpret_cast<uintptr_t>((const uint8_t*)EMBLOB_{NAME}_ADDRESS);
+        return member_ref { reinterpret_cast<const uint8_t*>(base + info.offset),
+            static_cast<std::size_t>(info.size) };
+    }
+} // !namespace emblob::{lname}
+#endif
+)EOF";
+    CONST_STATIC_STRING record_index = R"EOF(
+#if defined(__APPLE__)
+# define EMBLOB_{NAME}_INDEX_BASE {lname}_index_base
+# define EMBLOB_{NAME}_INDEX_REL {lname}_index_rel
+#else
+# define EMBLOB_{NAME}_INDEX_BASE _{lname}_index_base
+# define EMBLOB_{NAME}_INDEX_REL _{lname}_index_rel
+#endif
+
+#define EMBLOB_{NAME}_INDEX_BLOCK_SHIFT {INDEX_BLOCK_SHIFT}
+
+/**
+ * The record index: an absolute offset for each block of records, and the offset
+ * of each record relative to the base of its block.
+ */
+EMBLOB_EXTERNAL const uint64_t EMBLOB_{NAME}_INDEX_BASE[];
+EMBLOB_EXTERNAL const {INDEX_REL_TYPE} EMBLOB_{NAME}_INDEX_REL[];
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the number of records in the embedded blob.
+ */
+static inline
+uint64_t emblob_{lname}_record_count(void)
+{
+    return UINT64_C({RECORD_COUNT});
+}
+
+/**
+ * Returns the offset of record i within the embedded blob. If i is equal to the
+ * number of records, returns the offset one past the end of the last record's
+ * delimiter.
+ */
+static inline
+uint64_t emblob_{lname}_record_offset(uint64_t i)
+{
+    return EMBLOB_{NAME}_INDEX_BASE[i >> EMBLOB_{NAME}_INDEX_BLOCK_SHIFT] +
+        (uint64_t)EMBLOB_{NAME}_INDEX_REL[i];
+}
+
+/**
+ * Returns a pointer to the first byte of record i within the embedded blob, and
+ * stores its length (not including the delimiter) in len, if it is not NULL.
+ * Returns NULL if i is out of range.
+ */
+static inline
+const uint8_t* emblob_{lname}_record(uint64_t i, size_t* len)
+{
+    uint64_t start;
+
+    if (i >= emblob_{lname}_record_count()) {
+        if (len)
+            *len = 0;
+        return NULL;
+    }
+
+    start = emblob_{lname}_record_offset(i);
+    if (len)
+        *len = (size_t)(emblob_{lname}_record_offset(i + 1) - start - 1);
+
+    return emblob_get_{lname}_8() + start;
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+)EOF";
+    CONST_STATIC_STRING elements = R"EOF(
+#if !defined(_EMBLOB_ELEMENT_TYPES_DEFINED)
+# define _EMBLOB_ELEMENT_TYPES_DEFINED
+# define EMBLOB_ELEMENT_U16 1
+# define EMBLOB_ELEMENT_U32 2
+# define EMBLOB_ELEMENT_U64 3
+# define EMBLOB_ELEMENT_F32 4
+# define EMBLOB_ELEMENT_F64 5
+#endif
+
+/**
+ * The type of the embedded blob's elements (one of the EMBLOB_ELEMENT_* values).
+ * The elements were converted to the native byte order of the machine which
+ * generated this file.
+ */
+#define EMBLOB_{NAME}_ELEMENT EMBLOB_ELEMENT_{ELEMENT_MACRO}
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the number of elements in the embedded blob.
+ */
+static inline
+uint64_t emblob_get_{lname}_count(void)
+{
+    return UINT64_C({ELEMENT_COUNT});
+}
+
+/**
+ * Returns a pointer to the embedded blob's elements.
+ */
+static inline
+const {ELEMENT_C_TYPE}* emblob_get_{lname}_elements(void)
+{
+    return (const {ELEMENT_C_TYPE}*)emblob_get_{lname}_raw();
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+)EOF";
+    CONST_STATIC_STRING json_tape = R"EOF(
+#if !defined(_EMBLOB_JSON_TAPE_INCLUDED)
+# define _EMBLOB_JSON_TAPE_INCLUDED
+
+# include <string.h>
+
+# define EMBLOB_JSON_INVALID 0
+# define EMBLOB_JSON_NULL    'n'
+# define EMBLOB_JSON_TRUE    't'
+# define EMBLOB_JSON_FALSE   'f'
+# define EMBLOB_JSON_INT64   'l'
+# define EMBLOB_JSON_UINT64  'u'
+# define EMBLOB_JSON_DOUBLE  'd'
+# define EMBLOB_JSON_STRING  's'
+# define EMBLOB_JSON_OBJECT  '{'
+# define EMBLOB_JSON_ARRAY   '['
+
+# define EMBLOB_JSON_COUNT_MAX UINT64_C(0xffffff)
+
+/**
+ * A reference to a value in a pre-parsed JSON document. Values are small and
+ * are passed around by value; they never own any memory.
+ */
+typedef struct emblob_json_value {
+    const uint64_t* tape;
+    const char* strings;
+    uint64_t index;
+} emblob_json_value;
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/**
+ * Returns an invalid value (whose type is EMBLOB_JSON_INVALID).
+ */
+static inline
+emblob_json_value emblob_json_invalid(void)
+{
+    emblob_json_value v = { NULL, NULL, 0 };
+    return v;
+}
+
+/**
+ * Returns the type of v (one of the EMBLOB_JSON_* values).
+ */
+static inline
+int emblob_json_type(emblob_json_value v)
+{
+    int type;
+
+    if (!v.tape)
+        return EMBLOB_JSON_INVALID;
+
+    type = (int)(v.tape[v.index] >> 56);
+    return (type == '}' || type == ']') ? EMBLOB_JSON_INVALID : type;
+}
+
+/**
+ * Returns nonzero if v refers to a value.
+ */
+static inline
+int emblob_json_valid(emblob_json_value v)
+{
+    return emblob_json_type(v) != EMBLOB_JSON_INVALID;
+}
+
+/**
+ * Returns the value following v in its containing array or object (for an
+ * object, the value following a member's value is the next member's name). If
+ * v is the last one, the returned value is invalid.
+ */
+static inline
+emblob_json_value emblob_json_next(emblob_json_value v)
+{
+    switch (emblob_json_type(v)) {
+        case EMBLOB_JSON_INVALID:
+            return v;
+        case EMBLOB_JSON_OBJECT:
+        case EMBLOB_JSON_ARRAY:
+            v.index = (v.tape[v.index] & UINT64_C(0xffffffff)) + 1;
+            break;
+        case EMBLOB_JSON_INT64:
+        case EMBLOB_JSON_UINT64:
+        case EMBLOB_JSON_DOUBLE:
+        case EMBLOB_JSON_STRING:
+            v.index += 2;
+            break;
+        default:
+            v.index += 1;
+            break;
+    }
+
+    return v;
+}
+
+/**
+ * Returns the first element of an array, or the name of the first member of an
+ * object. The returned value is invalid if v is empty or not a container.
+ */
+static inline
+emblob_json_value emblob_json_first(emblob_json_value v)
+{
+    int type = emblob_json_type(v);
+
+    if (type != EMBLOB_JSON_OBJECT && type != EMBLOB_JSON_ARRAY)
+        return emblob_json_invalid();
+
+    v.index += 1;
+    return v;
+}
+
+/**
+ * Given the name of an object member, returns its value.
+ */
+static inline
+emblob_json_value emblob_json_member_value(emblob_json_value name)
+{
+    if (emblob_json_type(name) != EMBLOB_JSON_STRING)
+        return emblob_json_invalid();
+
+    name.index += 2;
+    return name;
+}
+
+/**
+ * Given the name of an object member, returns the name of the next member.
+ */
+static inline
+emblob_json_value emblob_json_next_member(emblob_json_value name)
+{
+    return emblob_json_next(emblob_json_member_value(name));
+}
+
+/**
+ * Returns the number of elements in an array or members in an object, or zero
+ * if v is not a container.
+ */
+static inline
+uint64_t emblob_json_count(emblob_json_value v)
+{
+    int type = emblob_json_type(v);
+    uint64_t count;
+
+    if (type != EMBLOB_JSON_OBJECT && type != EMBLOB_JSON_ARRAY)
+        return 0;
+
+    count = (v.tape[v.index] >> 32) & EMBLOB_JSON_COUNT_MAX;
+    if (count == EMBLOB_JSON_COUNT_MAX) {
+        /* too many to store; count them. */
+        emblob_json_value e = emblob_json_first(v);
+        for (count = 0; emblob_json_valid(e); count++)
+            e = type == EMBLOB_JSON_OBJECT ? emblob_json_next_member(e) : emblob_json_next(e);
+    }
+
+    return count;
+}
+
+/**
+ * Returns element i of an array, or an invalid value if i is out of range.
+ */
+static inline
+emblob_json_value emblob_json_at(emblob_json_value array, uint64_t i)
+{
+    emblob_json_value e;
+
+    if (emblob_json_type(array) != EMBLOB_JSON_ARRAY)
+        return emblob_json_invalid();
+
+    for (e = emblob_json_first(array); emblob_json_valid(e) && i > 0; i--)
+        e = emblob_json_next(e);
+
+    return e;
+}
+
+/**
+ * Returns the string value of v (NUL-terminated), and stores its length in
+ * len, if it is not NULL. Returns NULL if v is not a string.
+ */
+static inline
+const char* emblob_json_string(emblob_json_value v, size_t* len)
+{
+    if (emblob_json_type(v) != EMBLOB_JSON_STRING) {
+        if (len)
+            *len = 0;
+        return NULL;
+    }
+
+    if (len)
+        *len = (size_t)v.tape[v.index + 1];
+
+    return v.strings + (v.tape[v.index] & UINT64_C(0x00ffffffffffffff));
+}
+
+/**
+ * Returns the value of the member of object whose name is key (len bytes), or
+ * an invalid value if there is no such member.
+ */
+static inline
+emblob_json_value emblob_json_findn(emblob_json_value object, const char* key, size_t len)
+{
+    emblob_json_value name;
+
+    if (emblob_json_type(object) != EMBLOB_JSON_OBJECT)
+        return emblob_json_invalid();
+
+    for (name = emblob_json_first(object); emblob_json_valid(name);
+        name = emblob_json_next_member(name)) {
+        size_t name_len;
+        const char* str = emblob_json_string(name, &name_len);
+        if (name_len == len && 0 == memcmp(str, key, len))
+            return emblob_json_member_value(name);
+    }
+
+    return emblob_json_invalid();
+}
+
+/**
+ * Returns the value of the member of object whose name is the NUL-terminated
+ * string key, or an invalid value if there is no such member.
+ */
+static inline
+emblob_json_value emblob_json_find(emblob_json_value object, const char* key)
+{
+    return emblob_json_findn(object, key, strlen(key));
+}
+
+/**
+ * If v is an integer which is representable as an int64_t, stores it in out
+ * and returns nonzero.
+ */
+static inline
+int emblob_json_int64(emblob_json_value v, int64_t* out)
+{
+    uint64_t word;
+
+    switch (emblob_json_type(v)) {
+        case EMBLOB_JSON_INT64:
+            *out = (int64_t)v.tape[v.index + 1];
+            return 1;
+        case EMBLOB_JSON_UINT64:
+            word = v.tape[v.index + 1];
+            if (word > (uint64_t)INT64_MAX)
+                return 0;
+            *out = (int64_t)word;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * If v is an integer which is representable as a uint64_t, stores it in out
+ * and returns nonzero.
+ */
+static inline
+int emblob_json_uint64(emblob_json_value v, uint64_t* out)
+{
+    switch (emblob_json_type(v)) {
+        case EMBLOB_JSON_INT64:
+            if ((int64_t)v.tape[v.index + 1] < 0)
+                return 0;
+            *out = v.tape[v.index + 1];
+            return 1;
+        case EMBLOB_JSON_UINT64:
+            *out = v.tape[v.index + 1];
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * If v is a number, stores it (converted, if necessary) in out and returns
+ * nonzero.
+ */
+static inline
+int emblob_json_double(emblob_json_value v, double* out)
+{
+    switch (emblob_json_type(v)) {
+        case EMBLOB_JSON_INT64:
+            *out = (double)(int64_t)v.tape[v.index + 1];
+            return 1;
+        case EMBLOB_JSON_UINT64:
+            *out = (double)v.tape[v.index + 1];
+            return 1;
+        case EMBLOB_JSON_DOUBLE:
+            memcpy(out, &v.tape[v.index + 1], sizeof(double));
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * If v is true or false, stores it in out and returns nonzero.
+ */
+static inline
+int emblob_json_bool(emblob_json_value v, int* out)
+{
+    switch (emblob_json_type(v)) {
+        case EMBLOB_JSON_TRUE:
+            *out = 1;
+            return 1;
+        case EMBLOB_JSON_FALSE:
+            *out = 0;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif
+
+#if defined(__APPLE__)
+# define EMBLOB_{NAME}_TAPE {lname}_tape
+# define EMBLOB_{NAME}_TAPE_STRINGS {lname}_tape_strings
+#else
+# define EMBLOB_{NAME}_TAPE _{lname}_tape
+# define EMBLOB_{NAME}_TAPE_STRINGS _{lname}_tape_strings
+#endif
+
+/**
+ * The pre-parsed form of the embedded JSON document: a tape of {TAPE_WORDS}
+ * 64-bit words, and the (decoded) strings that it refers to.
+ */
+EMBLOB_EXTERNAL const uint64_t EMBLOB_{NAME}_TAPE[];
+EMBLOB_EXTERNAL const char EMBLOB_{NAME}_TAPE_STRINGS[];
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the root value of the embedded JSON document.
+ */
+static inline
+emblob_json_value emblob_{lname}_json_root(void)
+{
+    emblob_json_value v = { EMBLOB_{NAME}_TAPE, EMBLOB_{NAME}_TAPE_STRINGS, 0 };
+    return v;
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+)EOF";
+    CONST_STATIC_STRING profile = R"EOF(
+#if !defined(_EMBLOB_PROFILE_INCLUDED)
+# define _EMBLOB_PROFILE_INCLUDED
+
+# include <time.h>
+
+/**
+ * The number of calls counted against a blob (or one of its members), and the
+ * time of the first, in nanoseconds since the epoch (zero until it is known).
+ */
+typedef struct emblob_profile_counter {
+    uint64_t calls;
+    uint64_t first_ns;
+} emblob_profile_counter;
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/**
+ * Counts one call against counter: a relaxed atomic increment, and only upon
+ * the first call, the time at which it was made.
+ */
+static inline
+void emblob_profile_hit(emblob_profile_counter* counter)
+{
+    struct timespec ts;
+
+    if (__atomic_fetch_add(&counter->calls, 1, __ATOMIC_RELAXED) == 0 &&
+        timespec_get(&ts, TIME_UTC) == TIME_UTC)
+        __atomic_store_n(&counter->first_ns,
+            (uint64_t)ts.tv_sec * UINT64_C(1000000000) + (uint64_t)ts.tv_nsec, __ATOMIC_RELAXED);
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_PROFILE_INCLUDED
+
+#if defined(__APPLE__)
+# define EMBLOB_{NAME}_PROFILE {lname}_profile
+#else
+# define EMBLOB_{NAME}_PROFILE _{lname}_profile
+#endif
+
+#define EMBLOB_{NAME}_PROFILE_ENTRIES UINT64_C({PROFILE_ENTRIES})
+
+/**
+ * The profile counters of the embedded blob: the first counts calls of its
+ * accessor functions (and name lookups, in a directory), and the rest count
+ * accesses to the contents of each member of a directory, in order. The
+ * storage is reserved by the assembly file (zero-filled), and is shared by
+ * every thread and translation unit.
+ */
+EMBLOB_EXTERNAL emblob_profile_counter EMBLOB_{NAME}_PROFILE[];
+
+#define EMBLOB_{NAME}_PROFILE_HIT() emblob_profile_hit(&EMBLOB_{NAME}_PROFILE[0])
+#define EMBLOB_{NAME}_PROFILE_MEMBER(i) emblob_profile_hit(&EMBLOB_{NAME}_PROFILE[ \
+    (uint64_t)(i) + 1 < EMBLOB_{NAME}_PROFILE_ENTRIES ? (uint64_t)(i) + 1 : 0])
+)EOF";
+    CONST_STATIC_STRING profile_dump = R"EOF(
+#if !defined(_EMBLOB_PROFILE_DUMP_INCLUDED)
+# define _EMBLOB_PROFILE_DUMP_INCLUDED
+
+# include <stdio.h>
+
+# if defined(__cplusplus)
+    extern "C" {
+# endif
+
+/**
+ * Writes one line of a profile file: the kind of the counter, the number of
+ * calls, the time of the first, and the name, separated by tabs.
+ */
+static inline
+void emblob_profile_write(FILE* file, const char* kind, const emblob_profile_counter* counter,
+    const char* name)
+{
+    fprintf(file, "%s\t%llu\t%llu\t%s\n", kind,
+        (unsigned long long)__atomic_load_n(&counter->calls, __ATOMIC_RELAXED),
+        (unsigned long long)__atomic_load_n(&counter->first_ns, __ATOMIC_RELAXED), name);
+}
+
+# if defined(__cplusplus)
+    }
+# endif
+#endif // !_EMBLOB_PROFILE_DUMP_INCLUDED
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Writes the profile counters of the embedded blob to the file at path (or if
+ * path is NULL, emblob_{lname}.profile in the working directory), replacing its
+ * contents. Each line holds the kind of the counter ("blob" or "member"), the
+ * number of calls, the time of the first (in nanoseconds since the epoch, or
+ * zero), and the name of the blob or member, separated by tabs. Members which
+ * were never accessed are included. Returns 0 upon success, or -1 if the file
+ * could not be written. May be called at any time, from any thread.
+ */
+static inline
+int emblob_{lname}_profile_dump(const char* path)
+{
+    FILE* file = fopen(path ? path : "emblob_{lname}.profile", "w");
+    int failed;
+
+    if (!file)
+        return -1;
+
+    emblob_profile_write(file, "blob", &EMBLOB_{NAME}_PROFILE[0], "{lname}");
+{PROFILE_MEMBERS}
+    failed = ferror(file);
+    return fclose(file) == 0 && !failed ? 0 : -1;
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+)EOF";
+    CONST_STATIC_STRING profile_members = R"EOF(
+    {
+        uint64_t i;
+        for (i = 1; i < EMBLOB_{NAME}_PROFILE_ENTRIES; i++)
+            emblob_profile_write(file, "member", &EMBLOB_{NAME}_PROFILE[i],
+                emblob_{lname}_member_name(i - 1));
+    }
+)EOF";
+} // !namespace emblob::templates
+
+#endif // !_EMBLOB_TEMPLATES_HH_INCLUDED
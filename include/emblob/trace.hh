@@ -0,0 +1,274 @@
+/*
+ * trace.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_TRACE_HH_INCLUDED
+# define _EMBLOB_TRACE_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/version.hh"
+
+# include <chrono>
+
+# if !defined(_WIN32)
+#  include <sys/resource.h>
+# endif
+
+namespace emblob
+{
+    /* records how long each phase of a run takes (as complete events, in the
+     * Chrome/Perfetto trace event format), along with the files which were
+     * read and written, so that a run may be written out as a trace and/or
+     * summarized as JSON. phases are timed whether or not either is asked
+     * for, since doing so costs next to nothing. */
+    class tracer
+    {
+    public:
+        CONST_STATIC_STRING CAT_PHASE      = "phase";
+        CONST_STATIC_STRING CAT_SYSTEM     = "system";
+        CONST_STATIC_STRING CAT_SUBPROCESS = "subprocess";
+
+        using clock = std::chrono::steady_clock;
+
+        struct event {
+            std::string name;
+            const char* category = CAT_PHASE;
+            int64_t start_us = 0;
+            int64_t duration_us = 0;
+            std::string detail;
+        };
+
+        struct file {
+            std::string name;
+            int64_t bytes = 0;
+        };
+
+        /* times the enclosing scope. */
+        class scope
+        {
+        public:
+            scope(tracer& t, std::string name, const char* category, std::string detail)
+                : _tracer(t), _start(clock::now()) {
+                _event.name     = std::move(name);
+                _event.category = category;
+                _event.detail   = std::move(detail);
+            }
+
+            ~scope() {
+                end();
+            }
+
+            /* ends the phase before the end of the scope. */
+            void end() {
+                if (_ended) {
+                    return;
+                }
+
+                auto now = clock::now();
+                _event.start_us    = _tracer._micros(_start);
+                _event.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(now - _start).count();
+                _tracer._events.push_back(std::move(_event));
+                _ended = true;
+            }
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+        private:
+            tracer& _tracer;
+            clock::time_point _start;
+            event _event;
+            bool _ended = false;
+        };
+
+        tracer() = default;
+        ~tracer() = default;
+
+        [[nodiscard]] scope begin(std::string name, const char* category = CAT_PHASE,
+            std::string detail = {}) {
+            return scope(*this, std::move(name), category, std::move(detail));
+        }
+
+        void add_input(const std::string& name, int64_t bytes) {
+            _inputs.push_back({ name, bytes });
+        }
+
+        void add_output(const std::string& name, int64_t bytes) {
+            _outputs.push_back({ name, bytes });
+        }
+
+        /* writes every event recorded so far as a Chrome/Perfetto trace. */
+        bool write_trace(const std::string& fname) const {
+            std::ofstream strm(fname, std::ios::out | std::ios::trunc);
+            if (!strm.is_open()) {
+                g_logger->error("failed to open %s: %s", fname.c_str(), strerror(errno));
+                return false;
+            }
+
+            auto pid = static_cast<long>(getpid());
+            strm << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+            strm << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+                 << ",\"tid\":1,\"args\":{\"name\":\"" << APP_NAME << "\"}}";
+
+            for (const auto& e : _events) {
+                strm << "," << std::endl << "{\"name\":" << _json_string(e.name) << ",\"cat\":\""
+                     << e.category << "\",\"ph\":\"X\",\"ts\":" << e.start_us << ",\"dur\":"
+                     << e.duration_us << ",\"pid\":" << pid << ",\"tid\":1";
+                if (!e.detail.empty()) {
+                    strm << ",\"args\":{\"detail\":" << _json_string(e.detail) << "}";
+                }
+                strm << "}";
+            }
+
+            strm << std::endl << "]}" << std::endl;
+            if (!strm.good()) {
+                g_logger->error("failed to write %s", fname.c_str());
+                return false;
+            }
+
+            return true;
+        }
+
+        /* a one-line JSON summary of the run: the time spent in each phase,
+         * the inputs and outputs, throughput, peak RSS, and subprocess time. */
+        std::string stats_json(int exit_code) const {
+            auto wall_us = _micros(clock::now());
+
+            int64_t input_bytes = 0;
+            for (const auto& f : _inputs) {
+                input_bytes += f.bytes;
+            }
+
+            /* phases are totaled by name, in order of first appearance. */
+            std::vector<std::pair<std::string, std::pair<int64_t, int64_t>>> phases;
+            int64_t subprocess_us = 0;
+            int64_t subprocess_count = 0;
+            for (const auto& e : _events) {
+                auto it = std::ranges::find_if(phases, [&e](const auto& p) { return p.first == e.name; });
+                if (it == phases.end()) {
+                    phases.push_back({ e.name, { 0, 0 } });
+                    it = std::prev(phases.end());
+                }
+
+                it->second.first++;
+                it->second.second += e.duration_us;
+
+                if (e.category == CAT_SUBPROCESS) {
+                    subprocess_count++;
+                    subprocess_us += e.duration_us;
+                }
+            }
+
+            std::ostringstream strm;
+            strm << "{\"version\":\"" << VERSION_MAJOR << "." << VERSION_MINOR << "." << VERSION_PATCH
+                 << VERSION_SUFFIX << "\",\"exit_code\":" << exit_code << ",\"wall_time_us\":" << wall_us;
+
+            strm << ",\"phases\":{";
+            for (size_t n = 0; n < phases.size(); n++) {
+                strm << (n > 0 ? "," : "") << _json_string(phases[n].first) << ":{\"count\":"
+                     << phases[n].second.first << ",\"total_us\":" << phases[n].second.second << "}";
+            }
+            strm << "}";
+
+            for (const auto& [key, files] : { std::pair { "inputs", &_inputs }, std::pair { "outputs", &_outputs } }) {
+                strm << ",\"" << key << "\":[";
+                for (size_t n = 0; n < files->size(); n++) {
+                    strm << (n > 0 ? "," : "") << "{\"file\":" << _json_string((*files)[n].name)
+                         << ",\"bytes\":" << (*files)[n].bytes << "}";
+                }
+                strm << "]";
+            }
+
+            strm << ",\"input_bytes\":" << input_bytes << ",\"throughput_bytes_per_sec\":"
+                 << (wall_us > 0 ? input_bytes * 1000000 / wall_us : 0);
+
+            strm << ",\"subprocess\":{\"count\":" << subprocess_count << ",\"wall_time_us\":" << subprocess_us
+                 << ",\"cpu_time_us\":" << _children_cpu_us() << "}";
+
+            strm << ",\"peak_rss_bytes\":" << _peak_rss_bytes() << "}";
+            return strm.str();
+        }
+
+    private:
+        int64_t _micros(clock::time_point tp) const {
+            return std::chrono::duration_cast<std::chrono::microseconds>(tp - _origin).count();
+        }
+
+        static int64_t _peak_rss_bytes() {
+# if !defined(_WIN32)
+            struct rusage ru {};
+            if (0 == getrusage(RUSAGE_SELF, &ru)) {
+#  if defined(__MACOS__)
+                return static_cast<int64_t>(ru.ru_maxrss);
+#  else
+                return static_cast<int64_t>(ru.ru_maxrss) * 1024;
+#  endif
+            }
+# endif
+            return 0;
+        }
+
+        static int64_t _children_cpu_us() {
+# if !defined(_WIN32)
+            struct rusage ru {};
+            if (0 == getrusage(RUSAGE_CHILDREN, &ru)) {
+                return (static_cast<int64_t>(ru.ru_utime.tv_sec) + ru.ru_stime.tv_sec) * 1000000 +
+                    ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+            }
+# endif
+            return 0;
+        }
+
+        static std::string _json_string(const std::string& str) {
+            std::string out = "\"";
+            for (char ch : str) {
+                auto c = static_cast<unsigned char>(ch);
+                if (c == '"' || c == '\\') {
+                    out.push_back('\\');
+                    out.push_back(ch);
+                } else if (c < 0x20) {
+                    out += fmt_str("\\u%04x", c);
+                } else {
+                    out.push_back(ch);
+                }
+            }
+
+            out.push_back('"');
+            return out;
+        }
+
+        clock::time_point _origin = clock::now();
+        std::vector<event> _events;
+        std::vector<file> _inputs;
+        std::vector<file> _outputs;
+    };
+
+    /* per-thread, like g_logger. */
+    using tracer_ptr = std::unique_ptr<tracer>;
+    inline thread_local tracer_ptr g_tracer = std::make_unique<tracer>();
+
+} // !namespace emblob
+
+#endif // !_EMBLOB_TRACE_HH_INCLUDED
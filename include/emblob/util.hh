@@ -35,7 +35,7 @@ namespace emblob
 
     CONST_STATIC_STRING APP_NAME = "emblob";
 
-    static std::string fmt_str(const char* fmt, ...) {
+    static inline std::string fmt_str(const char* fmt, ...) {
         va_list args1;
         va_start(args1, fmt);
         va_list args2;
@@ -59,7 +59,25 @@ namespace emblob
         return buf.get();
     }
 
-    static std::string string_to_lower(const std::string& str) {
+    /* escapes str for use in a string literal in C or assembly. */
+    static inline std::string c_escape(const std::string& str) {
+        std::string out;
+        for (char ch : str) {
+            auto c = static_cast<unsigned char>(ch);
+            if (c == '"' || c == '\\') {
+                out.push_back('\\');
+                out.push_back(ch);
+            } else if (c >= 0x20 && c < 0x7f) {
+                out.push_back(ch);
+            } else {
+                out += fmt_str("\\%03o", c);
+            }
+        }
+
+        return out;
+    }
+
+    static inline std::string string_to_lower(const std::string& str) {
         auto retval = str;
 
         std::ranges::for_each(retval.begin(), retval.end(), [](char& c) {
@@ -69,7 +87,7 @@ namespace emblob
         return retval;
     }
 
-    static std::string string_to_upper(const std::string& str) {
+    static inline std::string string_to_upper(const std::string& str) {
         auto retval = str;
 
         std::ranges::for_each(retval.begin(), retval.end(), [](char& c) {
@@ -0,0 +1,252 @@
+/*
+ * watch.hh
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_WATCH_HH_INCLUDED
+# define _EMBLOB_WATCH_HH_INCLUDED
+
+# include "emblob/util.hh"
+# include "emblob/logger.hh"
+# include "emblob/system.hh"
+
+# include <filesystem>
+# include <csignal>
+
+# if defined(__LINUS__)
+#  include <poll.h>
+#  include <sys/inotify.h>
+# endif
+
+namespace emblob
+{
+    /* waits for changes to an input file, or to any file beneath an input
+     * directory, with inotify.
+     *
+     * a file is watched by way of the directory which contains it, since most
+     * editors save by writing a new file and renaming it over the old one
+     * (which would end a watch on the file itself). a burst of events (one
+     * save is often several) is reported as a single change, once no event
+     * has arrived for DEBOUNCE_MS. */
+    class input_watcher
+    {
+    public:
+        CONST_STATIC_X(int) DEBOUNCE_MS = 100;
+
+        input_watcher() = default;
+
+        ~input_watcher() {
+# if defined(__LINUS__)
+            if (_fd != -1) {
+                close(_fd);
+            }
+# endif
+        }
+
+        static bool supported() {
+# if defined(__LINUS__)
+            return true;
+# else
+            return false;
+# endif
+        }
+
+        bool start(const std::string& input) {
+# if defined(__LINUS__)
+            _input = input;
+            _is_dir = system::is_directory(input);
+            _fd = inotify_init1(IN_CLOEXEC);
+            if (_fd == -1) {
+                g_logger->fatal("inotify_init1 failed: %s", system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            /* SIGINT and SIGTERM end the wait (rather than the process), so
+             * that a generation in progress is not cut short. */
+            struct sigaction sa {};
+            sa.sa_handler = [](int) { _stop_requested = 1; };
+            sigemptyset(&sa.sa_mask);
+            sigaction(SIGINT, &sa, nullptr);
+            sigaction(SIGTERM, &sa, nullptr);
+
+            if (_is_dir) {
+                return _watch_tree();
+            }
+
+            auto parent = std::filesystem::path(input).parent_path();
+            _name = std::filesystem::path(input).filename().string();
+            return _add_watch(parent.empty() ? "." : parent.string());
+# else
+            g_logger->fatal("watching for changes is only supported on Linux (%s)", input.c_str());
+            return false;
+# endif
+        }
+
+        /* blocks until the input changes (returning true), or until SIGINT or
+         * SIGTERM (returning false). */
+        bool wait_for_change() {
+# if defined(__LINUS__)
+            bool changed = false;
+            while (!_stop_requested) {
+                pollfd pfd { _fd, POLLIN, 0 };
+                int ret = poll(&pfd, 1, changed ? DEBOUNCE_MS : -1);
+                if (ret == -1) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    g_logger->fatal("poll failed: %s", system::get_error_message(errno).c_str());
+                    return false;
+                } else if (ret == 0) {
+                    /* directories created since the last change must be
+                     * watched, too. */
+                    return !_is_dir || _watch_tree();
+                }
+
+                changed |= _read_events();
+            }
+# endif
+            return false;
+        }
+
+        /* FNV-1a over the contents of the input (and, for a directory, the
+         * relative path of each file beneath it), so that saves which change
+         * nothing can be ignored. returns false if the input can't be read
+         * (e.g., in the middle of being replaced). */
+        static bool content_hash(const std::string& input, uint64_t& hash) {
+            hash = 0xcbf29ce484222325ULL;
+            if (!system::is_directory(input)) {
+                return _hash_file(input, hash);
+            }
+
+            std::vector<std::filesystem::path> files;
+            std::error_code ec;
+            std::filesystem::recursive_directory_iterator it(input, ec), end;
+            for (; !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file(ec)) {
+                    files.push_back(it->path());
+                }
+            }
+
+            if (ec) {
+                return false;
+            }
+
+            std::sort(files.begin(), files.end());
+            for (const auto& f : files) {
+                auto name = f.lexically_relative(input).generic_string();
+                _hash_bytes(name.c_str(), name.size() + 1, hash);
+                if (!_hash_file(f.string(), hash)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+    private:
+        static inline volatile sig_atomic_t _stop_requested = 0;
+
+        std::string _input;
+        std::string _name;
+        bool _is_dir = false;
+        int _fd = -1;
+
+        static void _hash_bytes(const char* data, size_t len, uint64_t& hash) {
+            for (size_t n = 0; n < len; n++) {
+                hash ^= static_cast<unsigned char>(data[n]);
+                hash *= 0x100000001b3ULL;
+            }
+        }
+
+        static bool _hash_file(const std::string& fname, uint64_t& hash) {
+            std::ifstream strm(fname, std::ios::in | std::ios::binary);
+            if (!strm.is_open()) {
+                return false;
+            }
+
+            std::vector<char> buf(1024 * 1024);
+            while (strm) {
+                strm.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+                _hash_bytes(buf.data(), static_cast<size_t>(strm.gcount()), hash);
+            }
+
+            return !strm.bad();
+        }
+
+# if defined(__LINUS__)
+        bool _add_watch(const std::string& dir) {
+            constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE |
+                IN_DELETE | IN_ATTRIB;
+            if (-1 == inotify_add_watch(_fd, dir.c_str(), mask)) {
+                g_logger->error("failed to watch %s: %s", dir.c_str(), system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            g_logger->debug("watching %s", dir.c_str());
+            return true;
+        }
+
+        /* adding a watch for a directory which is already watched does
+         * nothing, so the whole tree is simply walked again. */
+        bool _watch_tree() {
+            if (!_add_watch(_input)) {
+                return false;
+            }
+
+            std::error_code ec;
+            std::filesystem::recursive_directory_iterator it(_input, ec), end;
+            for (; !ec && it != end; it.increment(ec)) {
+                if (it->is_directory(ec) && !_add_watch(it->path().string())) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /* returns true if any of the events read concern the input. */
+        bool _read_events() {
+            alignas(inotify_event) char buf[64 * 1024];
+            auto got = read(_fd, buf, sizeof(buf));
+            if (got <= 0) {
+                return false;
+            }
+
+            bool relevant = false;
+            for (ssize_t off = 0; off < got;) {
+                auto* ev = reinterpret_cast<const inotify_event*>(buf + off);
+                if (_is_dir || (ev->len > 0 && _name == ev->name)) {
+                    relevant = true;
+                }
+
+                off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+            }
+
+            return relevant;
+        }
+# endif
+    };
+} // !namespace emblob
+
+#endif // !_EMBLOB_WATCH_HH_INCLUDED
@@ -26,25 +26,68 @@
 #include "emblob.hh"
 #include "emblob/cmdline.hh"
 #include "emblob/appstate.hh"
+#include "emblob/generator.hh"
+#include "emblob/inject.hh"
+#include "emblob/server.hh"
+#include "emblob/trace.hh"
+#include "emblob/watch.hh"
 #include "emblob/util.hh"
 
 using namespace std;
 using namespace emblob;
 
 int main(int argc, char** argv) {
+    try {
+        if (!command_line::is_inject_command(argc, argv)) {
+            if (auto sock = command_line::peek_value(argc, argv, command_line::FLAG_SERVE); !sock.empty()) {
+                return serve_main(sock, argc, argv);
+            } else if (command_line::peek_flag(argc, argv, command_line::FLAG_WATCH, command_line::S_FLAG_WATCH)) {
+                return watch_main(argc, argv);
+            } else if (auto sock = command_line::peek_value(argc, argv, command_line::FLAG_CONNECT);
+                !sock.empty()) {
+                return connect_main(sock, argc, argv);
+            }
+        }
+    } catch (const exception& ex) {
+        g_logger->fatal("caught top-level exception: %s", ex.what());
+        return EXIT_FAILURE;
+    }
+
+    return run_main(argc, argv, std::cout, {});
+}
+
+int emblob::run_main(int argc, char** argv, ostream& stats_out, const string& compiler_path,
+    bool keep_unchanged_header) {
     app_state state;
     command_line cmd_line;
 
     auto _exit_main = [&](int code) {
         if (code != EXIT_SUCCESS) {
+            auto cleanup_phase = g_tracer->begin("cleanup");
+
             /* If exiting with an error code, clean up any files created;
-               don't want to leave things in a half-assed state. */
+               don't want to leave things in a half-assed state. (the
+               generator has already removed those that it created.) */
             if (state.created_hdr_file)
                 delete_file_on_unclean_exit(cmd_line.get_hdr_output_filename());
-            if (state.created_asm_file)
-                delete_file_on_unclean_exit(cmd_line.get_asm_output_filename());
-            if (state.created_obj_file)
-                delete_file_on_unclean_exit(cmd_line.get_obj_output_filename());
+        } else {
+            if (state.created_hdr_file) {
+                g_tracer->add_output(cmd_line.get_hdr_output_filename(),
+                    system::file_size(cmd_line.get_hdr_output_filename()));
+            }
+
+            for (const auto& fname : state.created_files) {
+                g_tracer->add_output(fname, system::file_size(fname));
+            }
+        }
+
+        if (auto trace_file = cmd_line.get_trace_filename(); !trace_file.empty() &&
+            g_tracer->write_trace(trace_file)) {
+            g_logger->info("wrote trace to %s", trace_file.c_str());
+        }
+
+        if (cmd_line.get_stats_json()) {
+            stats_out << g_tracer->stats_json(code) << std::endl;
         }
 
         g_logger->debug("exiting with status: %d (%s)", code,
@@ -53,235 +96,351 @@ int main(int argc, char** argv) {
     };
 
     try {
+        if (command_line::is_inject_command(argc, argv)) {
+            return _exit_main(inject_main(argc - 2, argv + 2));
+        }
+
+        /* so that the summary is the only thing on stdout. */
+        g_logger->set_use_stderr(command_line::peek_value(argc, argv, command_line::FLAG_STATS) ==
+            command_line::STATS_JSON);
+
+        auto parse_phase = g_tracer->begin("parse_command_line");
         int exit_code = EXIT_FAILURE;
         if (!cmd_line.parse_and_validate(argc, argv, exit_code)) {
             return _exit_main(exit_code);
         }
 
         g_logger->set_log_level(cmd_line.get_log_level());
+        parse_phase.end();
+
+        /* the executable keeps the assembly file, and the payload (if any), as
+         * build products, and so always assembles the object file; unless the
+         * input is a stream, which is written straight into the object file
+         * where possible (and so is never stored anywhere else). in that case,
+         * the generator looks for the compiler only if it needs it. */
+        auto stream = cmd_line.get_input_is_stream();
+        auto compiler = compiler_path;
+        if (compiler.empty() && !stream) {
+            auto compiler_phase = g_tracer->begin("detect_compiler");
+            compiler = system::detect_c_compiler();
+            if (compiler.empty()) {
+                return _exit_main(EXIT_FAILURE);
+            }
+        }
+        generator::options opts;
+        auto asm_file = cmd_line.get_asm_output_filename();
+        opts.name               = cmd_line.get_input_basename();
+        opts.output_base        = asm_file.substr(0, asm_file.size() - strlen(command_line::EXT_ASM));
+        opts.keep_intermediates = true;
+        opts.compiler           = compiler;
+        opts.native_object      = stream;
+        opts.zero_copy          = cmd_line.get_zero_copy();
+        opts.paging             = cmd_line.get_paging();
+        opts.sparse             = cmd_line.get_sparse();
+        opts.registry           = cmd_line.get_registry();
+        opts.profile            = cmd_line.get_profile();
+        opts.injected           = cmd_line.get_injected();
+        opts.json_tape          = cmd_line.get_json_tape();
+        opts.index_lines        = cmd_line.get_index_lines();
+        opts.delimiter          = cmd_line.get_delimiter();
+        opts.element_type       = cmd_line.get_element_type();
+        opts.source_endian      = cmd_line.get_source_endian();
+        opts.filters            = cmd_line.get_filters();
+        opts.archive            = cmd_line.get_archive();
+        opts.archive_members    = cmd_line.get_archive_members();
+        opts.compress_deflate   = cmd_line.get_compress_deflate();
+        opts.http               = cmd_line.get_http();
+        opts.http_encodings     = cmd_line.get_http_encodings();
+        opts.pack_file          = cmd_line.get_pack() ? cmd_line.get_pack_filename() : "";
 
-        auto compiler = system::detect_c_compiler();
-        if (compiler.empty()) {
-            return _exit_main(EXIT_FAILURE);
+        auto hdr_file = cmd_line.get_hdr_output_filename();
+        generator::outputs out;
+        out.header = [&state, &hdr_file, keep_unchanged_header](const char* data, size_t len) {
+            /* so that the sources which include it needn't be rebuilt. */
+            if (keep_unchanged_header && system::file_exists(hdr_file) &&
+                system::file_size(hdr_file) == static_cast<off_t>(len)) {
+                ifstream strm(hdr_file, ios::in | ios::binary);
+                string existing(len, '\0');
+                if (strm.read(existing.data(), static_cast<streamsize>(len)) &&
+                    0 == memcmp(existing.data(), data, len)) {
+                    g_logger->info("%s is unchanged", hdr_file.c_str());
+                    return true;
+                }
+            }
+
+            g_logger->debug("writing header file contents to %s...", hdr_file.c_str());
+
+            auto wrote = system::write_file_contents(hdr_file, ios::out | ios::trunc, [data, len](ostream& strm) {
+                strm.write(data, static_cast<streamsize>(len));
+            });
+
+            if (wrote == -1) {
+                g_logger->fatal("failed to write %s: %s", hdr_file.c_str(),
+                    system::get_error_message(errno).c_str());
+                return false;
+            }
+
+            g_logger->info("successfully created %s (%lld bytes)", hdr_file.c_str(),
+                system::file_size(hdr_file));
+            state.created_hdr_file = true;
+            return true;
+        };
+
+        generator gen(opts);
+        bool generated = false;
+        if (auto input = cmd_line.get_input_filename(); !stream) {
+            generated = gen.generate_file(input, out);
+        } else if (input == system::STDIN_FILENAME) {
+            generated = gen.generate_fd(STDIN_FILENO, out);
+        } else if (int fd = open(input.c_str(), O_RDONLY | O_CLOEXEC); fd != -1) {
+            generated = gen.generate_fd(fd, out);
+            close(fd);
+        } else {
+            g_logger->fatal("failed to open %s: %s", input.c_str(), system::get_error_message(errno).c_str());
         }
 
-CONST_STATIC_STRING header_template = R"EOF(/*
- * emblob_{lname}.h
- *
- * Author:    Ryan M. Lederman <lederman@gmail.com>
- * Copyright: Copyright (c) 2018-2024
- * Version:   2.0.1
- * License:   The MIT License (MIT)
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy of
- * this software and associated documentation files (the "Software"), to deal in
- * the Software without restriction, including without limitation the rights to
- * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
- * the Software, and to permit persons to whom the Software is furnished to do so,
- * subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
- * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
- * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
- * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
- * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-#ifndef _EMBLOB_{NAME}_H_INCLUDED
-#define _EMBLOB_{NAME}_H_INCLUDED
-
-#include <stdint.h>
-#include <stddef.h>
-#include <stdalign.h>
-
-#if defined(__cplusplus)
-# if !defined(EMBLOB_ALIGNAS)
-#  define EMBLOB_ALIGNAS alignas
-# endif
-# if !defined(EMBLOB_EXTERNAL)
-#  define EMBLOB_EXTERNAL extern "C"
-# endif
-#else
-# if !defined(EMBLOB_ALIGNAS)
-#  if __STDC_VERSION__ < 201710L
-#   define EMBLOB_ALIGNAS _Alignas
-#  elif __STDC_VERSION__ >= 201710L
-#   define EMBLOB_ALIGNAS alignas
-#  endif
-# endif
-# if !defined(EMBLOB_EXTERNAL)
-#  define EMBLOB_EXTERNAL extern
-# endif
-#endif
+        state.created_files = gen.created_files();
 
-#if defined(__APPLE__)
-# define EMBLOB_{NAME} {lname}_data
-#else
-# define EMBLOB_{NAME} _{lname}_data
-#endif
+        return _exit_main(generated ? EXIT_SUCCESS : EXIT_FAILURE);
+    } catch (const exception& ex) {
+        g_logger->fatal("caught top-level exception: %s", ex.what());
+        return _exit_main(EXIT_FAILURE);
+    }
 
-/**
- * The address of the embedded blob, stored as a pointer-sized unsigned integer.
- */
-EMBLOB_EXTERNAL uintptr_t EMBLOB_{NAME};
+    return _exit_main(EXIT_SUCCESS);
+}
 
-#if defined(__cplusplus)
-    extern "C" {
-#endif
+int emblob::serve_main(const string& sock, int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == command_line::FLAG_SERVE) {
+            i++;
+            continue;
+        } else if (arg.starts_with(string(command_line::FLAG_SERVE) + "=")) {
+            continue;
+        }
 
-/**
- * Returns the size of the embedded blob, in bytes.
- */
-static inline
-uint64_t emblob_get_{lname}_size(void)
-{
-    return UINT64_C({BLOB_SIZE});
-}
+        string level;
+        if (arg.starts_with(string(command_line::FLAG_LOG_LEVEL) + "=")) {
+            level = arg.substr(arg.find('=') + 1);
+        } else if ((arg == command_line::FLAG_LOG_LEVEL || arg == command_line::S_FLAG_LOG_LEVEL) &&
+            i + 1 < argc) {
+            level = argv[++i];
+        } else {
+            g_logger->error("'%s' may not be used with '%s'", arg.c_str(), command_line::FLAG_SERVE);
+            return EXIT_FAILURE;
+        }
 
-/**
- * Returns a pointer to the embedded blob that may be used to access the blob's
- * data one byte (8-bits) at a time.
- */
-static inline
-const uint8_t* emblob_get_{lname}_8(void)
-{
-    return (const uint8_t*)&EMBLOB_{NAME};
-}
+        if (logger::level_from_string(level) == logger::level::invalid) {
+            g_logger->error("'%s' is not a valid value for '%s'", level.c_str(), command_line::FLAG_LOG_LEVEL);
+            return EXIT_FAILURE;
+        }
 
-/**
- * Returns a pointer to the embedded blob that may be used to access the blob's
- * data two bytes (16-bits) at a time.
- */
-static inline
-const uint16_t* emblob_get_{lname}_16(void)
-{
-    return (const uint16_t*)&EMBLOB_{NAME};
-}
+        g_logger->set_log_level(logger::level_from_string(level));
+    }
 
-/**
- * Returns a pointer to the embedded blob that may be used to access the blob's
- * data four bytes (32-bits) at a time.
- */
-static inline
-const uint32_t* emblob_get_{lname}_32(void)
-{
-    return (const uint32_t*)&EMBLOB_{NAME};
-}
+    /* detected once, for every request; a client's CC is never used, since
+     * it would be run as the server's user. */
+    auto compiler = system::detect_c_compiler();
+    if (compiler.empty()) {
+        return EXIT_FAILURE;
+    }
 
-/**
- * Returns a pointer to the embedded blob that may be used to access the blob's
- * data eight bytes (64-bits) at a time.
- */
-static inline
-const uint64_t* emblob_get_{lname}_64(void)
-{
-    return (const uint64_t*)&EMBLOB_{NAME};
-}
+    auto handle = [&compiler](const server::request& req, ostream& out, ostream& err) {
+        g_logger = make_unique<logger>();
+        g_logger->set_streams(&out, &err);
+        g_tracer = make_unique<tracer>();
 
-/**
- * Returns a pointer to the embedded blob that may be used to access the blob's
- * data arbitrarily.
- */
-static inline
-const void* emblob_get_{lname}_raw(void)
-{
-    return (const void*)&EMBLOB_{NAME};
+        vector<string> args { APP_NAME };
+        args.insert(args.end(), req.args.begin(), req.args.end());
+
+        vector<char*> argv_req;
+        for (auto& a : args) {
+            argv_req.push_back(a.data());
+        }
+        argv_req.push_back(nullptr);
+
+        return run_main(static_cast<int>(args.size()), argv_req.data(), out, compiler);
+    };
+
+    auto threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    return server::serve(sock, threads, handle);
 }
 
-#if defined(__cplusplus)
+int emblob::watch_main(int argc, char** argv) {
+    if (!command_line::peek_value(argc, argv, command_line::FLAG_CONNECT).empty()) {
+        g_logger->error("'%s' may not be used with '%s'", command_line::FLAG_CONNECT, command_line::FLAG_WATCH);
+        return EXIT_FAILURE;
+    }
+
+    command_line cmd_line;
+    if (int exit_code = EXIT_FAILURE; !check_command_line(argc, argv, &cmd_line, exit_code)) {
+        return exit_code;
+    }
+
+    auto input = cmd_line.get_input_filename();
+    if (cmd_line.get_input_is_stream()) {
+        g_logger->error("'%s' may not be used when the input is a stream", command_line::FLAG_WATCH);
+        return EXIT_FAILURE;
     }
-#endif
 
-#endif // !_EMBLOB_{NAME}_H_INCLUDED
-)EOF";
+    input_watcher watcher;
+    if (!watcher.start(input)) {
+        return EXIT_FAILURE;
+    }
 
-        auto input_file = cmd_line.get_input_filename();
-        auto input_file_size = system::file_size(input_file);
-        auto base_name = cmd_line.get_input_basename();
-        auto blob_lname = string_to_lower(base_name);
-        string header_contents {};
+    auto compiler = system::detect_c_compiler();
+    if (compiler.empty()) {
+        return EXIT_FAILURE;
+    }
 
-        g_logger->debug("generating header file contents...");
+    uint64_t last_hash = 0;
+    bool hashed = input_watcher::content_hash(input, last_hash);
+    int exit_code = run_main(argc, argv, std::cout, compiler, true);
+
+    g_logger->info("watching %s for changes...", input.c_str());
+    while (watcher.wait_for_change()) {
+        uint64_t hash = 0;
+        if (!input_watcher::content_hash(input, hash)) {
+            g_logger->warning("unable to read %s; waiting for the next change", input.c_str());
+            continue;
+        } else if (hashed && hash == last_hash) {
+            g_logger->debug("%s changed, but its contents did not", input.c_str());
+            continue;
+        }
 
-        regex lexpr("\\{lname\\}");
-        header_contents = regex_replace(header_template, lexpr, blob_lname);
+        last_hash = hash;
+        hashed    = true;
 
-        regex uexpr("\\{NAME\\}");
-        header_contents = regex_replace(header_contents, uexpr, string_to_upper(base_name));
+        /* a fresh tracer, so that --trace and --stats describe each run. */
+        g_tracer  = make_unique<tracer>();
+        exit_code = run_main(argc, argv, std::cout, compiler, true);
+        g_logger->info("watching %s for changes...", input.c_str());
+    }
 
-        regex sexpr("\\{BLOB_SIZE\\}");
-        header_contents = regex_replace(header_contents, sexpr, to_string(input_file_size));
+    return exit_code;
+}
 
-        auto hdr_file = cmd_line.get_hdr_output_filename();
-        g_logger->debug("writing header file contents to %s...", hdr_file.c_str());
+bool emblob::check_command_line(int argc, char** argv, command_line* cmd_line, int& exit_code) {
+    /* quietly, since the command line will be parsed (and reported on) again
+     * when it is run. */
+    auto level = g_logger->get_log_level();
+    g_logger->set_log_level(logger::level::error);
 
-        auto openmode = ios::out | ios::trunc;
-        auto wrote = system::write_file_contents(hdr_file, openmode, [&header_contents](ostream& strm) {
-            strm.write(header_contents.c_str(), header_contents.size());
-        });
+    command_line local;
+    bool valid = (cmd_line != nullptr ? cmd_line : &local)->parse_and_validate(argc, argv, exit_code);
+    g_logger->set_log_level(level);
+    return valid;
+}
+
+int emblob::connect_main(const string& sock, int argc, char** argv) {
+    /* the command line is checked here, so that usage errors (and --help,
+     * --version) are reported without involving the server. */
+    command_line cmd_line;
+    if (int exit_code = EXIT_FAILURE; !check_command_line(argc, argv, &cmd_line, exit_code)) {
+        return exit_code;
+    }
 
-        if (wrote == -1) {
-            g_logger->fatal("failed to write %s: %s", hdr_file.c_str(),
-                system::get_error_message(errno).c_str());
-            return _exit_main(EXIT_FAILURE);
+    server::request req;
+    vector<char> cwd(PATH_MAX);
+    if (nullptr == getcwd(cwd.data(), cwd.size())) {
+        g_logger->fatal("failed to get the current directory: %s", system::get_error_message(errno).c_str());
+        return EXIT_FAILURE;
+    }
+
+    req.cwd = cwd.data();
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == command_line::FLAG_CONNECT) {
+            i++;
+        } else if (!arg.starts_with(string(command_line::FLAG_CONNECT) + "=")) {
+            req.args.push_back(arg);
         }
+    }
 
-        g_logger->info("successfully created %s (%lld bytes)", hdr_file.c_str(),
-            system::file_size(hdr_file));
-        state.created_hdr_file = true;
+    /* the server can't read a stream of the client's. */
+    if (cmd_line.get_input_is_stream()) {
+        g_logger->debug("the input is a stream; running locally");
+    } else if (int exit_code = EXIT_FAILURE; server::forward(sock, req, exit_code)) {
+        return exit_code;
+    } else {
+        g_logger->info("no server is listening on %s; running locally", sock.c_str());
+    }
 
-#if defined(__MACOS__) || defined(__LINUS__) || defined(__BSD__)
-        g_logger->debug("generating linker assembly file contents...");
+    vector<char*> argv_local;
+    argv_local.push_back(argv[0]);
+    for (auto& a : req.args) {
+        argv_local.push_back(a.data());
+    }
+    argv_local.push_back(nullptr);
 
-        stringstream sstrm;
-        sstrm << ".global _" << blob_lname << "_data" << endl;
-        sstrm << "_" << blob_lname << "_data:" << endl;
-        sstrm << ".incbin \"" << input_file << "\"" << endl;
-        sstrm << ".global _sizeof__" << blob_lname << "_data" << endl;
-        sstrm << ".set _sizeof__" << blob_lname << "_data, . - _" << blob_lname << "_data" << endl;
+    return run_main(static_cast<int>(argv_local.size() - 1), argv_local.data(), std::cout, {});
+}
 
-        auto asm_file = cmd_line.get_asm_output_filename();
-        g_logger->debug("writing linker assembly file contents to %s...", asm_file.c_str());
-        openmode = ios::out | ios::trunc;
-        wrote = system::write_file_contents(asm_file, openmode, [&sstrm](ostream& strm) {
-            strm << sstrm.str();
-        });
-
-        if (wrote == -1) {
-            g_logger->fatal("failed to write %s: %s", asm_file.c_str(),
-                system::get_error_message(errno).c_str());
-            return _exit_main(EXIT_FAILURE);
+int emblob::inject_main(int argc, char** argv) {
+#if defined(__MACOS__)
+    g_logger->fatal("%s is only supported for ELF executables", command_line::CMD_INJECT);
+    return EXIT_FAILURE;
+#else
+    vector<string> args;
+    for (int i = 0; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == command_line::FLAG_HELP || arg == command_line::S_FLAG_HELP) {
+            [[maybe_unused]] int prn = command_line::print_inject_usage();
+            return EXIT_SUCCESS;
         }
 
-        g_logger->info("successfully created %s (%lld bytes)", asm_file.c_str(),
-            system::file_size(asm_file));
-        state.created_asm_file = true;
+        /* the log level may be given as it is to emblob itself. */
+        string level;
+        if (arg.starts_with(string(command_line::FLAG_LOG_LEVEL) + "=")) {
+            level = arg.substr(arg.find('=') + 1);
+        } else if (arg == command_line::FLAG_LOG_LEVEL || arg == command_line::S_FLAG_LOG_LEVEL) {
+            level = i + 1 < argc ? argv[++i] : "";
+        } else {
+            args.push_back(arg);
+            continue;
+        }
 
-        g_logger->debug("using %s to generate linker object file...", compiler.c_str());
+        if (logger::level_from_string(level) == logger::level::invalid) {
+            g_logger->error("'%s' is not a valid value for '%s'", level.c_str(), command_line::FLAG_LOG_LEVEL);
+            return command_line::print_inject_usage();
+        }
 
-        auto obj_file = cmd_line.get_obj_output_filename();
-        auto cmd = fmt_str("%s -c -o %s %s", compiler.c_str(), obj_file.c_str(), asm_file.c_str());
-        bool asm_to_obj = system::execute_system_command(cmd);
+        g_logger->set_log_level(logger::level_from_string(level));
+    }
+
+    if (args.size() < 2) {
+        return command_line::print_inject_usage();
+    }
 
-        if (asm_to_obj) {
-            state.created_obj_file = true;
-            g_logger->info("successfully created %s (%lld bytes)", obj_file.c_str(),
-            system::file_size(obj_file));
+    vector<elf_injector::blob> blobs;
+    for (size_t i = 1; i < args.size(); i++) {
+        auto b = elf_injector::parse_blob(args[i]);
+        if (b.name.empty() || b.fname.empty()) {
+            g_logger->error("'%s' is not a valid blob", args[i].c_str());
+            return command_line::print_inject_usage();
         }
 
-        return _exit_main(asm_to_obj ? EXIT_SUCCESS : EXIT_FAILURE);
-#else
-# error "support for this platform is not implemented. please contact the author."
-#endif
-    } catch (const exception& ex) {
-        g_logger->fatal("caught top-level exception: %s", ex.what());
-        return _exit_main(EXIT_FAILURE);
+        for (const auto& other : blobs) {
+            if (other.name == b.name) {
+                g_logger->fatal("more than one blob is named '%s'", b.name.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+
+        blobs.push_back(b);
     }
 
-    return _exit_main(EXIT_SUCCESS);
+    if (!elf_injector::inject(args[0], blobs)) {
+        g_logger->fatal("failed to inject blobs into %s", args[0].c_str());
+        return EXIT_FAILURE;
+    }
+
+    g_logger->info("successfully injected %zu blob(s) into %s (%lld bytes)", blobs.size(),
+        args[0].c_str(), system::file_size(args[0]));
+    return EXIT_SUCCESS;
+#endif
 }
 
 void emblob::delete_file_on_unclean_exit(const string& fname) {
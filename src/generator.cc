@@ -0,0 +1,1228 @@
+/*
+ * generator.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "emblob/generator.hh"
+#include "emblob/cmdline.hh"
+#include "emblob/directory.hh"
+#include "emblob/elfobject.hh"
+#include "emblob/index.hh"
+#include "emblob/inject.hh"
+#include "emblob/jsontape.hh"
+#include "emblob/packfile.hh"
+#include "emblob/payload.hh"
+#include "emblob/registry.hh"
+#include "emblob/sparse.hh"
+#include "emblob/templates.hh"
+#include "emblob/trace.hh"
+
+#include <atomic>
+
+using namespace std;
+using namespace emblob;
+
+namespace
+{
+    /* the contents of emblob_{lname}.h, into which the sections of templates.hh
+     * that the options call for are substituted. */
+    CONST_STATIC_STRING header_template = R"EOF(/*
+ * emblob_{lname}.h
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _EMBLOB_{NAME}_H_INCLUDED
+#define _EMBLOB_{NAME}_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdalign.h>
+
+#if defined(__cplusplus)
+# if !defined(EMBLOB_ALIGNAS)
+#  define EMBLOB_ALIGNAS alignas
+# endif
+# if !defined(EMBLOB_EXTERNAL)
+#  define EMBLOB_EXTERNAL extern "C"
+# endif
+#else
+# if !defined(EMBLOB_ALIGNAS)
+#  if __STDC_VERSION__ < 201710L
+#   define EMBLOB_ALIGNAS _Alignas
+#  elif __STDC_VERSION__ >= 201710L
+#   define EMBLOB_ALIGNAS alignas
+#  endif
+# endif
+# if !defined(EMBLOB_EXTERNAL)
+#  define EMBLOB_EXTERNAL extern
+# endif
+#endif
+
+#if defined(__APPLE__)
+# define EMBLOB_{NAME} {lname}_data
+#else
+# define EMBLOB_{NAME} _{lname}_data
+#endif
+
+/**
+ * The address of the embedded blob, stored as a pointer-sized unsigned integer.
+ */
+EMBLOB_EXTERNAL uintptr_t EMBLOB_{NAME};
+{PRELUDE}
+#if !defined(EMBLOB_{NAME}_ADDRESS)
+# define EMBLOB_{NAME}_ADDRESS (&EMBLOB_{NAME})
+#endif
+#if !defined(EMBLOB_{NAME}_SIZE)
+# define EMBLOB_{NAME}_SIZE UINT64_C({BLOB_SIZE})
+#endif
+
+#if defined(__cplusplus)
+    extern "C" {
+#endif
+
+/**
+ * Returns the size of the embedded blob, in bytes.
+ */
+static inline
+uint64_t emblob_get_{lname}_size(void)
+{
+    {PROFILE_HIT}
+    return EMBLOB_{NAME}_SIZE;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data one byte (8-bits) at a time.
+ */
+static inline
+const uint8_t* emblob_get_{lname}_8(void)
+{
+    {PROFILE_HIT}
+    return (const uint8_t*)EMBLOB_{NAME}_ADDRESS;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data two bytes (16-bits) at a time.
+ */
+static inline
+const uint16_t* emblob_get_{lname}_16(void)
+{
+    {PROFILE_HIT}
+    return (const uint16_t*)EMBLOB_{NAME}_ADDRESS;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data four bytes (32-bits) at a time.
+ */
+static inline
+const uint32_t* emblob_get_{lname}_32(void)
+{
+    {PROFILE_HIT}
+    return (const uint32_t*)EMBLOB_{NAME}_ADDRESS;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data eight bytes (64-bits) at a time.
+ */
+static inline
+const uint64_t* emblob_get_{lname}_64(void)
+{
+    {PROFILE_HIT}
+    return (const uint64_t*)EMBLOB_{NAME}_ADDRESS;
+}
+
+/**
+ * Returns a pointer to the embedded blob that may be used to access the blob's
+ * data arbitrarily.
+ */
+static inline
+const void* emblob_get_{lname}_raw(void)
+{
+    {PROFILE_HIT}
+    return (const void*)EMBLOB_{NAME}_ADDRESS;
+}
+
+#if defined(__cplusplus)
+    }
+#endif
+{EXTENSIONS}
+#endif // !_EMBLOB_{NAME}_H_INCLUDED
+)EOF";
+
+    /* replaces each occurrence of placeholder in str with value, literally;
+     * value itself is not searched for further occurrences. */
+    void replace_placeholder(string& str, const string& placeholder, const string& value) {
+        for (auto pos = str.find(placeholder); pos != string::npos;
+            pos = str.find(placeholder, pos + value.size())) {
+            str.replace(pos, placeholder.size(), value);
+        }
+    }
+} // !namespace
+
+struct generator::context {
+    /* the input file or directory; for a buffer, the file it was spilled to,
+     * if one was needed. */
+    string input_file;
+    const void* data = nullptr;
+    size_t len = 0;
+    int fd = -1;
+    bool directory_mode = false;
+
+    string base_name;
+    string lname;
+    string payload_file;
+    string asm_file;
+    string obj_file;
+
+    /* the file that is actually embedded; differs from the input file if the
+     * input's contents have to be transformed. */
+    string blob_file;
+    off_t blob_file_size = 0;
+
+    filter_chain filters;
+    directory_pack pack;
+    sparse_map sparse;
+    record_index index;
+    json_tape tape;
+};
+
+generator::generator(options opts) : _opts(std::move(opts)) {
+}
+
+generator::~generator() = default;
+
+bool generator::generate_file(const string& path, const outputs& out) {
+    context ctx;
+    ctx.input_file     = path;
+    ctx.directory_mode = _opts.archive || system::is_directory(path);
+    ctx.base_name      = _opts.name.empty() ? system::file_base_name(path) : _opts.name;
+    return _generate(ctx, out);
+}
+
+bool generator::generate_buffer(const void* data, size_t len, const outputs& out) {
+    if (_opts.name.empty()) {
+        g_logger->fatal("a name is required in order to embed a buffer");
+        return false;
+    }
+
+    context ctx;
+    ctx.data      = data;
+    ctx.len       = len;
+    ctx.base_name = _opts.name;
+    return _generate(ctx, out);
+}
+
+bool generator::generate_fd(int fd, const outputs& out) {
+    if (_opts.name.empty()) {
+        g_logger->fatal("a name is required in order to embed the contents of a file descriptor");
+        return false;
+    }
+
+    context ctx;
+    ctx.fd        = fd;
+    ctx.base_name = _opts.name;
+    return _generate(ctx, out);
+}
+
+string generator::header_filename(const string& name) {
+    auto base_name = name;
+    return fmt_str("%s_%s.h", APP_NAME, system::sanitize_base_name(base_name).c_str());
+}
+
+generator::sink generator::to_string(string& str) {
+    str.clear();
+    return [&str](const char* data, size_t len) {
+        str.append(data, len);
+        return true;
+    };
+}
+
+generator::sink generator::to_file(const string& fname) {
+    auto strm = make_shared<ofstream>();
+    return [strm, fname](const char* data, size_t len) {
+        if (!strm->is_open()) {
+            strm->open(fname, ios::out | ios::trunc | ios::binary);
+        }
+
+        strm->write(data, static_cast<streamsize>(len));
+        strm->flush();
+        if (!*strm) {
+            g_logger->error("failed to write %s: %s", fname.c_str(),
+                system::get_error_message(errno).c_str());
+            return false;
+        }
+
+        return true;
+    };
+}
+
+bool generator::_generate(context& ctx, const outputs& out) {
+    _created.clear();
+    _files.clear();
+
+    ctx.lname = string_to_lower(system::sanitize_base_name(ctx.base_name));
+
+    auto base = _opts.output_base;
+    if (base.empty()) {
+        static atomic<uint64_t> counter { 0 };
+        const char* tmp_dir = getenv("TMPDIR");
+        base = fmt_str("%s/%s-%d-%" PRIu64 "-%s", valid_str(tmp_dir) ? tmp_dir : "/tmp", APP_NAME,
+            static_cast<int>(getpid()), counter++, ctx.lname.c_str());
+    }
+
+    ctx.payload_file = base + EXT_PAYLOAD;
+    ctx.asm_file     = base + EXT_ASM;
+    ctx.obj_file     = base + EXT_OBJ;
+
+    /* the header comes last, since the size of a streamed blob isn't known
+     * until the object file has been written. */
+    bool ok = _validate(ctx) && _prepare_blob(ctx) && _write_pack_file(ctx) && _assemble(ctx, out);
+    if (ok) {
+        g_logger->debug("generating header file contents...");
+        auto header_phase = g_tracer->begin("generate_header");
+        auto header_contents = _render_header(ctx);
+        header_phase.end();
+
+        ok = !out.header || out.header(header_contents.data(), header_contents.size());
+    }
+
+    _cleanup(ok);
+    return ok;
+}
+
+bool generator::_validate(const context& ctx) const {
+    if (_opts.archive && ctx.input_file.empty()) {
+        g_logger->fatal("%s requires an input file", command_line::FLAG_ARCHIVE);
+        return false;
+    } else if (_opts.archive && system::is_directory(ctx.input_file)) {
+        g_logger->fatal("%s is a directory, not an archive", ctx.input_file.c_str());
+        return false;
+    } else if (!_opts.archive && !_opts.archive_members.empty()) {
+        g_logger->warning("ignoring %s, since %s was not specified", command_line::FLAG_MEMBERS,
+            command_line::FLAG_ARCHIVE);
+    }
+
+    if (ctx.directory_mode) {
+        for (const auto& [used, flag] : {
+            std::pair { _opts.element_type != element::type::none, command_line::FLAG_ELEMENT },
+            std::pair { _opts.json_tape, command_line::FLAG_JSON_TAPE },
+            std::pair { _opts.index_lines, command_line::FLAG_INDEX },
+            std::pair { _opts.sparse, command_line::FLAG_SPARSE },
+            std::pair { _opts.injected, command_line::FLAG_INJECTED } }) {
+            if (used) {
+                g_logger->fatal("%s is not supported when the input is a directory", flag);
+                return false;
+            }
+        }
+    } else {
+        for (const auto& [used, flag] : {
+            std::pair { _opts.compress_deflate, command_line::FLAG_COMPRESS },
+            std::pair { _opts.http, command_line::FLAG_HTTP } }) {
+            if (used) {
+                g_logger->warning("ignoring %s, since the input is not a directory", flag);
+            }
+        }
+    }
+
+    if (_opts.element_type == element::type::none && _opts.source_endian != element::ENDIAN_NATIVE) {
+        g_logger->warning("ignoring %s, since %s was not specified",
+            command_line::FLAG_SOURCE_ENDIAN, command_line::FLAG_ELEMENT);
+    }
+
+    /* in pack mode, the blob (and its tables) are written to a file of their
+     * own, and the header's accessors read everything from it at runtime,
+     * so nothing which is laid out in the object file can be used. */
+    auto pack_mode = !_opts.pack_file.empty();
+    if (_opts.injected) {
+#if defined(__MACOS__)
+        g_logger->fatal("%s is only supported for ELF executables", command_line::FLAG_INJECTED);
+        return false;
+#endif
+        for (const auto& [used, flag] : {
+            std::pair { pack_mode, command_line::FLAG_PACK },
+            std::pair { _opts.zero_copy, command_line::FLAG_ZERO_COPY },
+            std::pair { _opts.sparse, command_line::FLAG_SPARSE },
+            std::pair { _opts.registry, command_line::FLAG_REGISTRY },
+            std::pair { _opts.index_lines, command_line::FLAG_INDEX },
+            std::pair { _opts.json_tape, command_line::FLAG_JSON_TAPE },
+            std::pair { _opts.element_type != element::type::none, command_line::FLAG_ELEMENT } }) {
+            if (used) {
+                g_logger->fatal("%s cannot be combined with %s", flag, command_line::FLAG_INJECTED);
+                return false;
+            }
+        }
+    }
+
+    if (pack_mode) {
+        for (const auto& [used, flag] : {
+            std::pair { _opts.zero_copy, command_line::FLAG_ZERO_COPY },
+            std::pair { _opts.sparse, command_line::FLAG_SPARSE },
+            std::pair { _opts.registry, command_line::FLAG_REGISTRY },
+            std::pair { _opts.index_lines, command_line::FLAG_INDEX },
+            std::pair { _opts.json_tape, command_line::FLAG_JSON_TAPE },
+            std::pair { _opts.element_type != element::type::none, command_line::FLAG_ELEMENT } }) {
+            if (used) {
+                g_logger->fatal("%s cannot be combined with %s", flag, command_line::FLAG_PACK);
+                return false;
+            }
+        }
+    }
+
+    if (_opts.sparse && _opts.zero_copy) {
+        g_logger->fatal("%s cannot be combined with %s, since a sparse blob is not stored "
+            "contiguously in the executable", command_line::FLAG_SPARSE, command_line::FLAG_ZERO_COPY);
+        return false;
+    }
+
+    return true;
+}
+
+bool generator::_prepare_blob(context& ctx) {
+    auto swap_elements = _opts.element_type != element::type::none &&
+        element::needs_swap(_opts.source_endian);
+
+    for (const auto& name : _opts.filters) {
+        ctx.filters.add(filter_chain::create(name));
+    }
+
+    /* byte order conversion is always the last stage, since it has to see
+     * the final arrangement of the elements. */
+    if (swap_elements) {
+        ctx.filters.add(std::make_unique<byteswap_filter>(element::width(_opts.element_type)));
+    }
+
+    /* a buffer is embedded straight from memory if the object file can be
+     * written directly; otherwise, the steps below (and the assembler) need
+     * it in a file. */
+    if (ctx.data && !_native_object(ctx)) {
+        auto spilled = ctx.filters.empty() ? ctx.payload_file : ctx.payload_file + ".in";
+        _track(spilled, spilled == ctx.payload_file ? file_kind::intermediate : file_kind::temporary);
+
+        auto wrote = system::write_file_contents(spilled, ios::out | ios::trunc | ios::binary,
+            [&ctx](ostream& strm) {
+            strm.write(static_cast<const char*>(ctx.data), static_cast<streamsize>(ctx.len));
+        });
+
+        if (wrote == -1) {
+            g_logger->fatal("failed to write %s: %s", spilled.c_str(),
+                system::get_error_message(errno).c_str());
+            return false;
+        }
+
+        ctx.input_file = spilled;
+    } else if (ctx.fd != -1 && !_native_object(ctx)) {
+        auto spilled = ctx.filters.empty() ? ctx.payload_file : ctx.payload_file + ".in";
+        _track(spilled, spilled == ctx.payload_file ? file_kind::intermediate : file_kind::temporary);
+
+        auto spill_phase = g_tracer->begin("read_stream", tracer::CAT_PHASE, spilled);
+        bool read_ok = false;
+        auto wrote = system::write_file_contents(spilled, ios::out | ios::trunc | ios::binary,
+            [&ctx, &read_ok](ostream& strm) {
+            read_ok = _read_fd(ctx.fd, [&strm](const char* data, size_t len) {
+                strm.write(data, static_cast<streamsize>(len));
+                return true;
+            }, ctx.len);
+        });
+
+        if (!read_ok || wrote == -1) {
+            g_logger->fatal("failed to write %s", spilled.c_str());
+            return false;
+        }
+
+        ctx.input_file = spilled;
+    }
+
+    /* a blob streamed into the object file is accounted for as it is. */
+    if (ctx.fd != -1 && _native_object(ctx)) {
+        return true;
+    }
+
+    if (ctx.data || ctx.fd != -1) {
+        if (ctx.fd != -1 && ctx.len == 0) {
+            g_logger->fatal("the input (%s) is empty", _opts.name.c_str());
+            return false;
+        }
+
+        g_tracer->add_input(_opts.name, static_cast<int64_t>(ctx.len));
+        ctx.blob_file      = ctx.input_file;
+        ctx.blob_file_size = static_cast<off_t>(ctx.len);
+    } else if (!ctx.directory_mode) {
+        ctx.blob_file      = ctx.input_file;
+        ctx.blob_file_size = system::file_size(ctx.input_file);
+        if (ctx.blob_file_size == -1) {
+            return false;
+        }
+
+        g_tracer->add_input(ctx.input_file, ctx.blob_file_size);
+    }
+
+    /* in directory mode, every file beneath the input directory becomes a
+     * member of a single blob, which is accompanied by a lookup table. */
+    if (ctx.directory_mode) {
+        g_logger->debug("reading the contents of %s...", ctx.input_file.c_str());
+
+        auto read_phase = g_tracer->begin(_opts.archive ? "read_archive" : "read_directory",
+            tracer::CAT_PHASE, ctx.input_file);
+        if (_opts.archive ? !ctx.pack.load_archive(ctx.input_file, _opts.archive_members, _opts.filters) :
+            !ctx.pack.load(ctx.input_file, _opts.filters)) {
+            return false;
+        }
+        read_phase.end();
+
+        g_tracer->add_input(ctx.input_file, static_cast<int64_t>(ctx.pack.original_size()));
+
+        /* the metadata describes the contents, so it must be gathered
+         * before they are compressed. */
+        auto http_phase = g_tracer->begin("http_metadata");
+        if (_opts.http && !ctx.pack.add_http(_opts.http_encodings)) {
+            return false;
+        }
+        http_phase.end();
+
+#if defined(EMBLOB_HAVE_ZLIB)
+        auto compress_phase = g_tracer->begin("compress");
+        if (_opts.compress_deflate && !ctx.pack.compress_deflate()) {
+            return false;
+        }
+        compress_phase.end();
+#endif
+
+        auto write_phase = g_tracer->begin("write_payload", tracer::CAT_PHASE, ctx.payload_file);
+        _track(ctx.payload_file, file_kind::intermediate);
+        if (!ctx.pack.write_pack(ctx.payload_file)) {
+            g_logger->fatal("failed to write %s", ctx.payload_file.c_str());
+            return false;
+        }
+        write_phase.end();
+
+        ctx.blob_file = ctx.payload_file;
+        ctx.blob_file_size = system::file_size(ctx.blob_file);
+
+        g_logger->info("packed %zu members (%" PRIu64 " bytes) into %s (%lld bytes)",
+            ctx.pack.members().size(), ctx.pack.original_size(), ctx.payload_file.c_str(),
+            ctx.blob_file_size);
+    } else if (!ctx.filters.empty()) {
+        g_logger->debug("transforming %s into %s...", ctx.input_file.c_str(), ctx.payload_file.c_str());
+
+        auto filter_phase = g_tracer->begin("filter", tracer::CAT_PHASE, ctx.payload_file);
+        _track(ctx.payload_file, file_kind::intermediate);
+        if (!payload::write(ctx.input_file, ctx.payload_file, ctx.filters)) {
+            g_logger->fatal("failed to transform %s", ctx.input_file.c_str());
+            return false;
+        }
+        filter_phase.end();
+
+        auto input_size = ctx.blob_file_size;
+        ctx.blob_file = ctx.payload_file;
+        ctx.blob_file_size = system::file_size(ctx.blob_file);
+
+        ctx.filters.for_each([](const filter& f) {
+            g_logger->debug("%s: %" PRIu64 " bytes in, %" PRIu64 " bytes out", f.name(),
+                f.bytes_in(), f.bytes_out());
+        });
+
+        g_logger->info("transformed %s: %lld bytes -> %lld bytes (%s)", ctx.input_file.c_str(),
+            input_size, ctx.blob_file_size, ctx.payload_file.c_str());
+    }
+
+    if (_opts.element_type != element::type::none) {
+        auto width = element::width(_opts.element_type);
+        if (0 != ctx.blob_file_size % static_cast<off_t>(width)) {
+            g_logger->fatal("the size of %s (%lld bytes) is not a multiple of the element size (%zu bytes)",
+                ctx.blob_file.c_str(), ctx.blob_file_size, width);
+            return false;
+        }
+    }
+
+    if (_opts.sparse) {
+        g_logger->debug("looking for runs of zero bytes in %s...", ctx.blob_file.c_str());
+
+        auto sparse_phase = g_tracer->begin("sparse_scan");
+        if (!ctx.sparse.build(ctx.blob_file)) {
+            return false;
+        }
+        sparse_phase.end();
+
+        g_logger->info("sparse blob: %zu segments; %" PRIu64 " of %lld bytes elided",
+            ctx.sparse.segments().size(), ctx.sparse.elided_bytes(), ctx.blob_file_size);
+    }
+
+    if (_opts.index_lines) {
+        g_logger->debug("building record index...");
+
+        auto index_phase = g_tracer->begin("build_index");
+        if (!ctx.index.build(ctx.blob_file, _opts.delimiter)) {
+            return false;
+        }
+        index_phase.end();
+
+        g_logger->info("indexed %" PRIu64 " records (%zu-byte relative offsets; %zu bytes)",
+            ctx.index.count(), ctx.index.rel_width(), ctx.index.size_in_bytes());
+    }
+
+    if (_opts.json_tape) {
+        g_logger->debug("parsing %s as JSON...", ctx.blob_file.c_str());
+
+        auto tape_phase = g_tracer->begin("build_json_tape");
+        if (!ctx.tape.build(ctx.blob_file)) {
+            return false;
+        }
+        tape_phase.end();
+
+        g_logger->info("built JSON tape (%zu words; %zu bytes of strings; %zu bytes)",
+            ctx.tape.word_count(), ctx.tape.strings_size(), ctx.tape.size_in_bytes());
+    }
+
+    return true;
+}
+
+bool generator::_write_pack_file(context& ctx) {
+    if (_opts.pack_file.empty()) {
+        return true;
+    }
+
+    g_logger->debug("writing pack file %s...", _opts.pack_file.c_str());
+
+    auto pack_phase = g_tracer->begin("write_pack_file", tracer::CAT_PHASE, _opts.pack_file);
+    _track(_opts.pack_file, file_kind::product);
+    if (!pack_file::write(_opts.pack_file, ctx.blob_file, ctx.directory_mode ? &ctx.pack : nullptr)) {
+        return false;
+    }
+    pack_phase.end();
+
+    g_logger->info("successfully created %s (%lld bytes)", _opts.pack_file.c_str(),
+        system::file_size(_opts.pack_file));
+    return true;
+}
+
+string generator::_render_header(context& ctx) const {
+    auto pack_mode = !_opts.pack_file.empty();
+
+    string prelude {};
+    if (_opts.profile) {
+        prelude = templates::profile;
+
+        regex nexpr("\\{PROFILE_ENTRIES\\}");
+        prelude = regex_replace(prelude, nexpr, std::to_string(_profile_entries(ctx)));
+    }
+
+    if (pack_mode) {
+        string pack_contents = templates::pack;
+
+        /* the pack is checked for the tables which the header will use. */
+        regex fexpr("\\{PACK_FLAGS\\}");
+        prelude += regex_replace(pack_contents, fexpr,
+            ctx.directory_mode && ctx.pack.has_http() ? "EMBLOB_PACK_HTTP" : "0");
+    } else if (_opts.injected) {
+        prelude += templates::inject;
+    } else if (_opts.sparse) {
+        string sparse_contents = templates::sparse;
+
+        regex sexpr("\\{SPARSE_SEGMENTS\\}");
+        prelude += regex_replace(sparse_contents, sexpr, std::to_string(ctx.sparse.segments().size()));
+    }
+
+    string extensions {};
+    if (_opts.element_type != element::type::none) {
+        string elements_contents = templates::elements;
+
+        regex mexpr("\\{ELEMENT_MACRO\\}");
+        elements_contents = regex_replace(elements_contents, mexpr, element::macro_suffix(_opts.element_type));
+
+        regex cexpr("\\{ELEMENT_COUNT\\}");
+        elements_contents = regex_replace(elements_contents, cexpr,
+            std::to_string(static_cast<uint64_t>(ctx.blob_file_size) / element::width(_opts.element_type)));
+
+        regex texpr("\\{ELEMENT_C_TYPE\\}");
+        elements_contents = regex_replace(elements_contents, texpr, element::c_type(_opts.element_type));
+
+        extensions += elements_contents;
+    }
+
+    if (_opts.zero_copy) {
+        extensions += templates::zero_copy;
+    }
+
+    if (_opts.paging) {
+        extensions += templates::paging;
+    }
+
+    if (_opts.index_lines) {
+        string index_contents = templates::record_index;
+
+        regex cexpr("\\{RECORD_COUNT\\}");
+        index_contents = regex_replace(index_contents, cexpr, std::to_string(ctx.index.count()));
+
+        regex texpr("\\{INDEX_REL_TYPE\\}");
+        index_contents = regex_replace(index_contents, texpr, ctx.index.rel_type());
+
+        regex bexpr("\\{INDEX_BLOCK_SHIFT\\}");
+        index_contents = regex_replace(index_contents, bexpr, std::to_string(record_index::BLOCK_SHIFT));
+
+        extensions += index_contents;
+    }
+
+    if (ctx.directory_mode) {
+        if (ctx.pack.compressed()) {
+            extensions += templates::inflate;
+        }
+
+        string directory_contents = templates::directory;
+
+        regex cexpr("\\{MEMBER_COUNT\\}");
+        directory_contents = regex_replace(directory_contents, cexpr, std::to_string(ctx.pack.members().size()));
+
+        regex mexpr("\\{SLOT_MASK\\}");
+        directory_contents = regex_replace(directory_contents, mexpr, std::to_string(ctx.pack.slot_count() - 1));
+
+        regex dexpr("\\{DICTIONARY_SIZE\\}");
+        directory_contents = regex_replace(directory_contents, dexpr, std::to_string(ctx.pack.dictionary().size()));
+
+        extensions += directory_contents;
+
+        if (ctx.pack.has_http()) {
+            extensions += templates::http;
+        }
+
+        /* the compile-time table is omitted in pack mode, since the pack may
+         * be regenerated with different members. its {CXX_MEMBERS} are not
+         * substituted until the very end (see below). */
+        if (!pack_mode) {
+            extensions += templates::cxx_names;
+        }
+
+        if (ctx.pack.compressed()) {
+            extensions += templates::member_cache;
+        }
+    }
+
+    if (_opts.json_tape) {
+        string tape_contents = templates::json_tape;
+
+        regex wexpr("\\{TAPE_WORDS\\}");
+        tape_contents = regex_replace(tape_contents, wexpr, std::to_string(ctx.tape.word_count()));
+
+        extensions += tape_contents;
+    }
+
+    if (_opts.registry) {
+        extensions += templates::registry;
+    }
+
+    if (_opts.profile) {
+        string dump_contents = templates::profile_dump;
+
+        regex mexpr("\\{PROFILE_MEMBERS\\}");
+        dump_contents = regex_replace(dump_contents, mexpr,
+            _profile_entries(ctx) > 1 ? templates::profile_members : "");
+
+        extensions += dump_contents;
+    }
+
+    string header_contents = header_template;
+    replace_placeholder(header_contents, "{EXTENSIONS}", extensions);
+    replace_placeholder(header_contents, "{PRELUDE}", prelude);
+
+    /* the accessor and lookup functions count their calls on lines of their
+     * own, which are removed entirely if the blob is not profiled. */
+    regex hexpr("( *)\\{PROFILE_HIT\\}\n");
+    header_contents = regex_replace(header_contents, hexpr,
+        _opts.profile ? "$1EMBLOB_{NAME}_PROFILE_HIT();\n" : "");
+
+    regex iexpr("( *)\\{PROFILE_MEMBER\\((.*)\\)\\}\n");
+    header_contents = regex_replace(header_contents, iexpr,
+        _opts.profile ? "$1EMBLOB_{NAME}_PROFILE_MEMBER($2);\n" : "");
+
+    regex lexpr("\\{lname\\}");
+    header_contents = regex_replace(header_contents, lexpr, ctx.lname);
+
+    regex uexpr("\\{NAME\\}");
+    header_contents = regex_replace(header_contents, uexpr, string_to_upper(ctx.base_name));
+
+    regex sexpr("\\{BLOB_SIZE\\}");
+    header_contents = regex_replace(header_contents, sexpr, std::to_string(ctx.blob_file_size));
+
+    /* member names and the pack path come from the user, and may contain
+     * characters which are special in a replacement format (e.g. '$') or
+     * which look like placeholders (e.g. '{lname}'), so they are substituted
+     * literally, and last. */
+    if (ctx.directory_mode && !pack_mode) {
+        replace_placeholder(header_contents, "{CXX_MEMBERS}", ctx.pack.cxx_members());
+    }
+
+    if (pack_mode) {
+        replace_placeholder(header_contents, "{PACK_PATH}", c_escape(_opts.pack_file));
+    }
+
+    return header_contents;
+}
+
+string generator::_render_asm(context& ctx) const {
+    const auto& lname = ctx.lname;
+    auto pack_mode = !_opts.pack_file.empty();
+
+    /* each blob is placed in its own read-only section so that the linker
+     * is able to discard it (--gc-sections, -dead_strip) if nothing in the
+     * executable references it. a sparse blob is instead a zero-filled
+     * (NOBITS) region, which occupies no space in the executable, and its
+     * non-zero segments are stored in a read-only section of their own. in
+     * pack mode, only the (zero-filled) state of the pack's mapping is, and
+     * likewise for the location of a blob which is injected after linking. */
+    stringstream sstrm;
+    if (_opts.injected) {
+        sstrm << ".global _" << lname << "_inject_state" << endl;
+        sstrm << ".section .bss.emblob." << lname << ",\"aw\",%nobits" << endl;
+        sstrm << ".balign 16" << endl;
+        sstrm << ".type _" << lname << "_inject_state, %object" << endl;
+        sstrm << "_" << lname << "_inject_state:" << endl;
+#if !defined(__MACOS__)
+        sstrm << ".zero " << elf_injector::STATE_SIZE << endl;
+        sstrm << ".size _" << lname << "_inject_state, " << elf_injector::STATE_SIZE << endl;
+#endif
+    } else if (pack_mode) {
+        sstrm << ".global _" << lname << "_pack_state" << endl;
+#if defined(__MACOS__)
+        sstrm << ".zerofill __DATA,__bss,_" << lname << "_pack_state,"
+              << pack_file::STATE_SIZE << ",4" << endl;
+#else
+        sstrm << ".section .bss.emblob." << lname << ",\"aw\",%nobits" << endl;
+        sstrm << ".balign 16" << endl;
+        sstrm << ".type _" << lname << "_pack_state, %object" << endl;
+        sstrm << "_" << lname << "_pack_state:" << endl;
+        sstrm << ".zero " << pack_file::STATE_SIZE << endl;
+        sstrm << ".size _" << lname << "_pack_state, " << pack_file::STATE_SIZE << endl;
+#endif
+    } else if (_opts.sparse) {
+        sstrm << ".global _" << lname << "_data" << endl;
+        sstrm << ".global _" << lname << "_sparse_state" << endl;
+#if defined(__MACOS__)
+        sstrm << ".zerofill __DATA,__bss,_" << lname << "_data," << ctx.blob_file_size << ",4" << endl;
+        sstrm << ".zerofill __DATA,__bss,_" << lname << "_sparse_state,4,2" << endl;
+        sstrm << ".section __TEXT,__const" << endl;
+#else
+        sstrm << ".section .bss.emblob." << lname << ",\"aw\",%nobits" << endl;
+        sstrm << ".balign 16" << endl;
+        sstrm << ".type _" << lname << "_data, %object" << endl;
+        sstrm << "_" << lname << "_data:" << endl;
+        sstrm << ".zero " << ctx.blob_file_size << endl;
+        sstrm << ".size _" << lname << "_data, " << ctx.blob_file_size << endl;
+        sstrm << ".balign 4" << endl;
+        sstrm << "_" << lname << "_sparse_state:" << endl;
+        sstrm << ".zero 4" << endl;
+        sstrm << ".section .rodata.emblob." << lname << ".sparse,\"a\",%progbits" << endl;
+#endif
+        sstrm << ".global _sizeof__" << lname << "_data" << endl;
+        sstrm << ".set _sizeof__" << lname << "_data, " << ctx.blob_file_size << endl;
+        ctx.sparse.write_asm(sstrm, lname, ctx.blob_file);
+    } else {
+#if defined(__MACOS__)
+        sstrm << ".section __TEXT,__const" << endl;
+#else
+        sstrm << ".section .rodata.emblob." << lname << ",\"a\",%progbits" << endl;
+#endif
+        sstrm << ".balign 16" << endl;
+        sstrm << ".global _" << lname << "_data" << endl;
+#if !defined(__MACOS__)
+        sstrm << ".type _" << lname << "_data, %object" << endl;
+#endif
+        sstrm << "_" << lname << "_data:" << endl;
+        sstrm << ".incbin \"" << ctx.blob_file << "\"" << endl;
+#if !defined(__MACOS__)
+        sstrm << ".size _" << lname << "_data, . - _" << lname << "_data" << endl;
+#endif
+        sstrm << ".global _sizeof__" << lname << "_data" << endl;
+        sstrm << ".set _sizeof__" << lname << "_data, . - _" << lname << "_data" << endl;
+    }
+
+    if (_opts.index_lines) {
+#if defined(__MACOS__)
+        sstrm << ".section __TEXT,__const" << endl;
+#else
+        sstrm << ".section .rodata.emblob." << lname << ".index,\"a\",%progbits" << endl;
+#endif
+        ctx.index.write_asm(sstrm, lname);
+    }
+
+    /* the members of a directory are not given sections of their own: each
+     * is addressed by its offset within the one contiguous payload (which the
+     * linker would be free to reorder or break up), and any lookup by name or
+     * by index may reach any of them. a directory is therefore discarded, or
+     * kept, as a whole. */
+    if (ctx.directory_mode && !pack_mode) {
+#if defined(__MACOS__)
+        sstrm << ".section __TEXT,__const" << endl;
+#else
+        sstrm << ".section .rodata.emblob." << lname << ".members,\"a\",%progbits" << endl;
+#endif
+        ctx.pack.write_asm(sstrm, lname);
+    }
+
+    /* the cache of decompressed members is writable, and zero-filled. in
+     * pack mode, its slots are allocated at runtime instead, since the
+     * number of members is not known until then. */
+    if (ctx.directory_mode && ctx.pack.compressed()) {
+        auto slots_size = ctx.pack.members().size() * directory_pack::CACHE_SLOT_SIZE;
+        sstrm << ".global _" << lname << "_cache" << endl;
+#if defined(__MACOS__)
+        sstrm << ".zerofill __DATA,__bss,_" << lname << "_cache,"
+              << directory_pack::CACHE_SIZE << ",4" << endl;
+        if (!pack_mode) {
+            sstrm << ".global _" << lname << "_cache_slots" << endl;
+            sstrm << ".zerofill __DATA,__bss,_" << lname << "_cache_slots,"
+                  << slots_size << ",4" << endl;
+        }
+#else
+        sstrm << ".section .bss.emblob." << lname << ".cache,\"aw\",%nobits" << endl;
+        sstrm << ".balign 16" << endl;
+        sstrm << "_" << lname << "_cache:" << endl;
+        sstrm << ".zero " << directory_pack::CACHE_SIZE << endl;
+        if (!pack_mode) {
+            sstrm << ".global _" << lname << "_cache_slots" << endl;
+            sstrm << "_" << lname << "_cache_slots:" << endl;
+            sstrm << ".zero " << slots_size << endl;
+        }
+#endif
+    }
+
+    if (_opts.json_tape) {
+#if defined(__MACOS__)
+        sstrm << ".section __TEXT,__const" << endl;
+#else
+        sstrm << ".section .rodata.emblob." << lname << ".tape,\"a\",%progbits" << endl;
+#endif
+        ctx.tape.write_asm(sstrm, lname);
+    }
+
+    if (_opts.registry) {
+        uint64_t flags = 0;
+        for (const auto& [used, flag] : {
+            std::pair { ctx.directory_mode, registry::FLAG_DIRECTORY },
+            std::pair { ctx.directory_mode && ctx.pack.compressed(), registry::FLAG_COMPRESSED },
+            std::pair { _opts.sparse, registry::FLAG_SPARSE },
+            std::pair { _opts.element_type != element::type::none, registry::FLAG_ELEMENTS },
+            std::pair { _opts.json_tape, registry::FLAG_JSON_TAPE },
+            std::pair { _opts.index_lines, registry::FLAG_INDEX } }) {
+            flags |= used ? flag : 0;
+        }
+
+        registry::write_asm(sstrm, lname, static_cast<uint64_t>(ctx.blob_file_size), flags);
+    }
+
+    /* the profile counters are writable, and zero-filled: one for the blob,
+     * and one for each member of a directory. */
+    if (_opts.profile) {
+        auto profile_size = _profile_entries(ctx) * PROFILE_COUNTER_SIZE;
+        sstrm << ".global _" << lname << "_profile" << endl;
+#if defined(__MACOS__)
+        sstrm << ".zerofill __DATA,__bss,_" << lname << "_profile," << profile_size << ",4" << endl;
+#else
+        sstrm << ".section .bss.emblob." << lname << ".profile,\"aw\",%nobits" << endl;
+        sstrm << ".balign 16" << endl;
+        sstrm << ".type _" << lname << "_profile, %object" << endl;
+        sstrm << "_" << lname << "_profile:" << endl;
+        sstrm << ".zero " << profile_size << endl;
+        sstrm << ".size _" << lname << "_profile, " << profile_size << endl;
+#endif
+    }
+
+#if defined(__MACOS__)
+    sstrm << ".subsections_via_symbols" << endl;
+#else
+    sstrm << ".section .note.GNU-stack,\"\",%progbits" << endl;
+#endif
+
+    return sstrm.str();
+}
+
+bool generator::_native_object(const context& ctx) const {
+#if defined(__MACOS__)
+    (void)ctx;
+    return false;
+#else
+    return _opts.native_object && elf_object::supported() && !ctx.directory_mode &&
+        ctx.filters.empty() && _opts.pack_file.empty() && !_opts.injected && !_opts.sparse &&
+        !_opts.index_lines && !_opts.json_tape && !_opts.registry && !_opts.profile;
+#endif
+}
+
+uint64_t generator::_profile_entries(const context& ctx) const {
+    /* in pack mode, the members are not known until runtime, so accesses to
+     * them are counted against the blob. */
+    if (ctx.directory_mode && _opts.pack_file.empty()) {
+        return 1 + static_cast<uint64_t>(ctx.pack.members().size());
+    }
+
+    return 1;
+}
+
+bool generator::_assemble(context& ctx, const outputs& out) {
+#if defined(__MACOS__) || defined(__LINUS__) || defined(__BSD__)
+# if !defined(__MACOS__)
+    if (_native_object(ctx) && ctx.fd != -1) {
+        return _stream_object(ctx, out);
+    } else if (_native_object(ctx)) {
+        auto object_phase = g_tracer->begin("write_object", tracer::CAT_PHASE, ctx.obj_file);
+
+        string contents;
+        if (!ctx.data) {
+            ifstream strm(ctx.blob_file, ios::in | ios::binary);
+            contents.assign(istreambuf_iterator<char>(strm), istreambuf_iterator<char>());
+            if (strm.bad() || contents.size() != static_cast<size_t>(ctx.blob_file_size)) {
+                g_logger->fatal("failed to read %s", ctx.blob_file.c_str());
+                return false;
+            }
+
+            ctx.data = contents.data();
+            ctx.len  = contents.size();
+        }
+
+        auto object = elf_object::build(ctx.lname, ctx.data, ctx.len);
+        object_phase.end();
+
+        if (_opts.keep_intermediates) {
+            _track(ctx.obj_file, file_kind::intermediate);
+            auto wrote = system::write_file_contents(ctx.obj_file, ios::out | ios::trunc | ios::binary,
+                [&object](ostream& strm) {
+                strm.write(object.data(), static_cast<streamsize>(object.size()));
+            });
+
+            if (wrote == -1) {
+                g_logger->fatal("failed to write %s", ctx.obj_file.c_str());
+                return false;
+            }
+        }
+
+        return !out.object || out.object(object.data(), object.size());
+    }
+# endif
+
+    g_logger->debug("generating linker assembly file contents...");
+    auto asm_phase = g_tracer->begin("generate_asm");
+    auto asm_contents = _render_asm(ctx);
+    asm_phase.end();
+
+    g_logger->debug("writing linker assembly file contents to %s...", ctx.asm_file.c_str());
+    _track(ctx.asm_file, file_kind::intermediate);
+    auto wrote = system::write_file_contents(ctx.asm_file, ios::out | ios::trunc, [&asm_contents](ostream& strm) {
+        strm << asm_contents;
+    });
+
+    if (wrote == -1) {
+        g_logger->fatal("failed to write %s: %s", ctx.asm_file.c_str(),
+            system::get_error_message(errno).c_str());
+        return false;
+    }
+
+    g_logger->info("successfully created %s (%lld bytes)", ctx.asm_file.c_str(),
+        system::file_size(ctx.asm_file));
+
+    if (out.assembly && !out.assembly(asm_contents.data(), asm_contents.size())) {
+        return false;
+    }
+
+    if (_opts.compiler.empty()) {
+        auto compiler_phase = g_tracer->begin("detect_compiler");
+        _opts.compiler = system::detect_c_compiler();
+        if (_opts.compiler.empty()) {
+            return false;
+        }
+    }
+
+    g_logger->debug("using %s to generate linker object file...", _opts.compiler.c_str());
+
+    /* the compiler writes to a temporary file, which only becomes the object
+     * file if it succeeds. */
+    auto tmp_obj = system::temp_filename(ctx.obj_file);
+    auto cmd = fmt_str("%s -c -o %s %s", _opts.compiler.c_str(), tmp_obj.c_str(), ctx.asm_file.c_str());
+    auto assemble_phase = g_tracer->begin("assemble", tracer::CAT_PHASE, ctx.obj_file);
+    _track(tmp_obj, file_kind::temporary);
+    bool asm_to_obj = system::execute_system_command(cmd);
+    assemble_phase.end();
+
+    if (!asm_to_obj) {
+        return false;
+    } else if (0 != rename(tmp_obj.c_str(), ctx.obj_file.c_str())) {
+        g_logger->fatal("failed to rename %s to %s: %s", tmp_obj.c_str(), ctx.obj_file.c_str(),
+            system::get_error_message(errno).c_str());
+        return false;
+    }
+
+    _track(ctx.obj_file, file_kind::intermediate);
+
+    g_logger->info("successfully created %s (%lld bytes)", ctx.obj_file.c_str(),
+        system::file_size(ctx.obj_file));
+
+    return _deliver_file(ctx.obj_file, out.object);
+#else
+# error "support for this platform is not implemented. please contact the author."
+#endif
+}
+
+bool generator::_stream_object(context& ctx, const outputs& out) {
+#if defined(__MACOS__)
+    (void)ctx;
+    (void)out;
+    return false;
+#else
+    auto object_phase = g_tracer->begin("write_object", tracer::CAT_PHASE, ctx.obj_file);
+
+    /* the object file is needed even if it is not to be kept, since its
+     * header can't be written until the blob has been. */
+    _track(ctx.obj_file, file_kind::intermediate);
+
+    bool read_ok = false;
+    auto wrote = system::write_file_contents(ctx.obj_file, ios::out | ios::trunc | ios::binary,
+        [&ctx, &read_ok](ostream& strm) {
+        auto placeholder = elf_object::header(ctx.lname, 0);
+        strm.write(placeholder.data(), static_cast<streamsize>(placeholder.size()));
+
+        read_ok = _read_fd(ctx.fd, [&strm](const char* data, size_t len) {
+            strm.write(data, static_cast<streamsize>(len));
+            return true;
+        }, ctx.len);
+
+        auto trailer = elf_object::trailer(ctx.lname, ctx.len);
+        auto header  = elf_object::header(ctx.lname, ctx.len);
+        strm.write(trailer.data(), static_cast<streamsize>(trailer.size()));
+        strm.seekp(0);
+        strm.write(header.data(), static_cast<streamsize>(header.size()));
+        strm.seekp(0, ios::end);
+    });
+
+    if (!read_ok || wrote == -1) {
+        g_logger->fatal("failed to write %s", ctx.obj_file.c_str());
+        return false;
+    } else if (ctx.len == 0) {
+        g_logger->fatal("the input (%s) is empty", _opts.name.c_str());
+        return false;
+    } else if (_opts.element_type != element::type::none &&
+        0 != ctx.len % element::width(_opts.element_type)) {
+        g_logger->fatal("the size of the input (%zu bytes) is not a multiple of the element size (%zu bytes)",
+            ctx.len, element::width(_opts.element_type));
+        return false;
+    }
+
+    object_phase.end();
+
+    g_tracer->add_input(_opts.name, static_cast<int64_t>(ctx.len));
+    ctx.blob_file_size = static_cast<off_t>(ctx.len);
+    g_logger->info("successfully created %s (%lld bytes) from %zu bytes of input", ctx.obj_file.c_str(),
+        system::file_size(ctx.obj_file), ctx.len);
+
+    return _deliver_file(ctx.obj_file, out.object);
+#endif
+}
+
+bool generator::_read_fd(int fd, const sink& to, size_t& total) {
+    total = 0;
+    vector<char> buf(READ_CHUNK);
+    for (;;) {
+        auto got = read(fd, buf.data(), buf.size());
+        if (got == -1 && errno == EINTR) {
+            continue;
+        } else if (got == -1) {
+            g_logger->fatal("failed to read from file descriptor %d: %s", fd,
+                system::get_error_message(errno).c_str());
+            return false;
+        } else if (got == 0) {
+            return true;
+        }
+
+        if (!to(buf.data(), static_cast<size_t>(got))) {
+            return false;
+        }
+
+        total += static_cast<size_t>(got);
+    }
+}
+
+bool generator::_deliver_file(const string& fname, const sink& to) const {
+    if (!to) {
+        return true;
+    }
+
+    ifstream strm(fname, ios::in | ios::binary);
+    if (!strm.is_open()) {
+        g_logger->error("failed to open %s: %s", fname.c_str(), system::get_error_message(errno).c_str());
+        return false;
+    }
+
+    vector<char> buf(1024 * 1024);
+    while (strm) {
+        strm.read(buf.data(), static_cast<streamsize>(buf.size()));
+        if (auto got = static_cast<size_t>(strm.gcount()); got > 0 && !to(buf.data(), got)) {
+            return false;
+        }
+    }
+
+    if (strm.bad()) {
+        g_logger->error("failed to read %s", fname.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void generator::_track(const string& fname, file_kind kind) {
+    auto it = ranges::find_if(_files, [&fname](const auto& f) { return f.first == fname; });
+    if (it == _files.end()) {
+        _files.emplace_back(fname, kind);
+    }
+}
+
+void generator::_cleanup(bool success) {
+    for (const auto& [fname, kind] : _files) {
+        bool keep = success && (kind == file_kind::product ||
+            (kind == file_kind::intermediate && _opts.keep_intermediates));
+        if (keep) {
+            _created.push_back(fname);
+        } else if (system::file_exists(fname) && system::delete_file(fname) && !success) {
+            g_logger->info("deleted '%s'", fname.c_str());
+        }
+    }
+
+    _files.clear();
+}
@@ -0,0 +1,181 @@
+/*
+ * archive_test.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "emblob/archive.hh"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+
+/*
+ * Checks that archive_reader rejects sizes which an archive cannot back (before
+ * allocating anything for them), and that it reads a zip64 archive holding a
+ * stored member of more than 4 GiB. The large member is mostly a hole in a
+ * sparse file, but it is read (and its CRC checked) in full, so this needs as
+ * much memory as the member is large.
+ */
+
+using namespace emblob;
+
+namespace
+{
+    constexpr uint64_t BIG_MEMBER_SIZE = (UINT64_C(1) << 32) + 4096;
+    constexpr char BIG_MEMBER_NAME[] = "big.bin";
+    constexpr char BIG_MEMBER_TAIL[] = "the end";
+
+    int failures = 0;
+
+    void check(bool ok, const char* what) {
+        std::printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+        failures += ok ? 0 : 1;
+    }
+
+    std::string le(uint64_t value, size_t len) {
+        std::string out;
+        for (size_t n = 0; n < len; n++) {
+            out += static_cast<char>((value >> (n * 8)) & 0xff);
+        }
+
+        return out;
+    }
+
+    bool write_file(const std::string& fname, const std::string& contents) {
+        std::ofstream strm(fname, std::ios::out | std::ios::trunc | std::ios::binary);
+        strm.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        return strm.good();
+    }
+
+    bool read_all(const std::string& fname) {
+        return archive_reader::read(fname, [](const std::string&) { return true; },
+            [](const std::string&, std::string&&) { return true; });
+    }
+
+    /* an end of central directory record alone, which claims a central
+     * directory of almost 4 GiB. */
+    void bad_zip() {
+        auto eocd = le(0x06054b50, 4) + le(0, 2) + le(0, 2) + le(1, 2) + le(1, 2) + le(0xfffffff0, 4) +
+            le(0, 4) + le(0, 2);
+        check(write_file("bad_cd_size.zip", eocd) && !read_all("bad_cd_size.zip"),
+            "zip with an oversized central directory is rejected");
+        unlink("bad_cd_size.zip");
+    }
+
+    /* a ustar header which claims an 8 GiB member, followed by nothing. */
+    void bad_tar() {
+        std::string header(archive_reader::BLOCK_SIZE, '\0');
+        header.replace(0, 5, "big.x");
+        header.replace(100, 8, "0000644", 8);
+        header.replace(124, 12, "100000000000");
+        header[156] = '0';
+        header.replace(257, 6, "ustar", 6);
+        header.replace(148, 8, "        ");
+
+        unsigned sum = 0;
+        for (char c : header) {
+            sum += static_cast<unsigned char>(c);
+        }
+
+        char checksum[8];
+        std::snprintf(checksum, sizeof(checksum), "%06o", sum);
+        header.replace(148, 7, checksum, 7);
+
+        check(write_file("bad_size.tar", header + std::string(3 * archive_reader::BLOCK_SIZE, '\0')) &&
+            !read_all("bad_size.tar"), "tar with an oversized member is rejected");
+        unlink("bad_size.tar");
+    }
+
+    /* a zip64 archive holding one stored member of BIG_MEMBER_SIZE bytes: zeros
+     * (a hole), and then BIG_MEMBER_TAIL. */
+    bool write_big_zip(const std::string& fname) {
+        uint32_t crc = 0;
+#if defined(EMBLOB_HAVE_ZLIB)
+        std::string zeros(archive_reader::READ_CHUNK, '\0');
+        uLong running = ::crc32(0, nullptr, 0);
+        for (uint64_t left = BIG_MEMBER_SIZE - strlen(BIG_MEMBER_TAIL); left > 0;) {
+            auto len = static_cast<uInt>(std::min<uint64_t>(left, zeros.size()));
+            running = ::crc32(running, reinterpret_cast<const Bytef*>(zeros.data()), len);
+            left -= len;
+        }
+
+        running = ::crc32(running, reinterpret_cast<const Bytef*>(BIG_MEMBER_TAIL),
+            static_cast<uInt>(strlen(BIG_MEMBER_TAIL)));
+        crc = static_cast<uint32_t>(running);
+#endif
+
+        std::string name = BIG_MEMBER_NAME;
+        auto local = le(0x04034b50, 4) + le(45, 2) + le(0, 2) + le(0, 2) + le(0, 4) + le(crc, 4) +
+            le(0xffffffff, 4) + le(0xffffffff, 4) + le(name.size(), 2) + le(20, 2) + name +
+            le(0x0001, 2) + le(16, 2) + le(BIG_MEMBER_SIZE, 8) + le(BIG_MEMBER_SIZE, 8);
+
+        uint64_t cd_offset = local.size() + BIG_MEMBER_SIZE;
+        auto central = le(0x02014b50, 4) + le(45, 2) + le(45, 2) + le(0, 2) + le(0, 2) + le(0, 4) +
+            le(crc, 4) + le(0xffffffff, 4) + le(0xffffffff, 4) + le(name.size(), 2) + le(20, 2) +
+            le(0, 2) + le(0, 2) + le(0, 2) + le(0, 4) + le(0, 4) + name +
+            le(0x0001, 2) + le(16, 2) + le(BIG_MEMBER_SIZE, 8) + le(BIG_MEMBER_SIZE, 8);
+
+        uint64_t eocd64_offset = cd_offset + central.size();
+        auto trailer = le(0x06064b50, 4) + le(44, 8) + le(45, 2) + le(45, 2) + le(0, 4) + le(0, 4) +
+            le(1, 8) + le(1, 8) + le(central.size(), 8) + le(cd_offset, 8) +
+            le(0x07064b50, 4) + le(0, 4) + le(eocd64_offset, 8) + le(1, 4) +
+            le(0x06054b50, 4) + le(0, 2) + le(0, 2) + le(0xffff, 2) + le(0xffff, 2) +
+            le(0xffffffff, 4) + le(0xffffffff, 4) + le(0, 2);
+
+        std::ofstream strm(fname, std::ios::out | std::ios::trunc | std::ios::binary);
+        strm.write(local.data(), static_cast<std::streamsize>(local.size()));
+        strm.seekp(static_cast<std::streamoff>(cd_offset - strlen(BIG_MEMBER_TAIL)));
+        strm << BIG_MEMBER_TAIL << central << trailer;
+        return strm.good();
+    }
+
+    void big_zip64() {
+        const std::string fname = "big_zip64.zip";
+        if (!write_big_zip(fname)) {
+            check(false, "write a zip64 archive");
+            unlink(fname.c_str());
+            return;
+        }
+
+        bool seen = false;
+        bool ok = archive_reader::read(fname, [](const std::string&) { return true; },
+            [&seen](const std::string& name, std::string&& data) {
+            seen = name == BIG_MEMBER_NAME && data.size() == BIG_MEMBER_SIZE &&
+                data.ends_with(BIG_MEMBER_TAIL) && data.find_first_not_of('\0') ==
+                data.size() - strlen(BIG_MEMBER_TAIL);
+            return true;
+        });
+
+        check(ok && seen, "zip64 archive with a member larger than 4 GiB is read intact");
+        unlink(fname.c_str());
+    }
+} // !namespace
+
+int main() {
+    bad_zip();
+    bad_tar();
+    big_zip64();
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,71 @@
+/*
+ * names_test.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "emblob_names.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+/*
+ * Checks the C++ member table of a directory (see names in CMakeLists.txt)
+ * whose member names contain characters which are special in a regex
+ * replacement format, or which look like the generator's placeholders: each
+ * name must appear in the table verbatim, and in order.
+ */
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool ok, const char* what) {
+        std::printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+        failures += ok ? 0 : 1;
+    }
+
+    template<emblob::literal N>
+    void check_member(const char* contents) {
+        auto index = emblob::names::index_of<N>();
+        auto ref = emblob::names::get<N>();
+        check(emblob_names_find(N.str) == static_cast<int64_t>(index) &&
+            std::string_view(reinterpret_cast<const char*>(ref.data), ref.size) == contents, N.str);
+    }
+} // !namespace
+
+int main() {
+    check_member<"a$&b.txt">("one");
+    check_member<"$1.txt">("two");
+    check_member<"{lname}$$.txt">("three");
+    check_member<"plain.txt">("four");
+
+    bool sorted = true;
+    for (std::size_t n = 1; n < std::size(emblob::names::members); n++) {
+        sorted = sorted && emblob::names::members[n - 1].name < emblob::names::members[n].name;
+    }
+
+    check(sorted, "the member table is in order of name");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
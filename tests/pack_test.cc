@@ -0,0 +1,147 @@
+/*
+ * pack_test.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "emblob_pack_site.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+
+/*
+ * Checks that a pack file (see pack_site in CMakeLists.txt) is rejected, rather
+ * than trusted, if its header or tables describe anything which does not lie
+ * within it; and that the accessors then see an empty pack.
+ */
+
+namespace
+{
+    constexpr char CORRUPT_PACK[] = "corrupt.pak";
+
+    int failures = 0;
+
+    void check(bool ok, const char* what) {
+        std::printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+        failures += ok ? 0 : 1;
+    }
+
+    std::string read_file(const char* fname) {
+        std::ifstream strm(fname, std::ios::in | std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+    }
+
+    bool write_file(const char* fname, const std::string& contents) {
+        std::ofstream strm(fname, std::ios::out | std::ios::trunc | std::ios::binary);
+        strm.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        return strm.good();
+    }
+
+    /* the header, and the words of the first member's record and HTTP metadata,
+     * of a copy of the pack, to be corrupted. */
+    struct pack_image {
+        std::string bytes;
+
+        emblob_pack_header& header() {
+            return *reinterpret_cast<emblob_pack_header*>(bytes.data());
+        }
+
+        uint64_t* words(uint64_t offset) {
+            return reinterpret_cast<uint64_t*>(bytes.data() + offset);
+        }
+
+        uint32_t* slots() {
+            return reinterpret_cast<uint32_t*>(bytes.data() + header().slots_offset);
+        }
+    };
+
+    bool rejected(const std::string& valid, const std::function<void(pack_image&)>& corrupt) {
+        pack_image image { valid };
+        corrupt(image);
+
+        int err = 0;
+        const emblob_pack_header* hdr = nullptr;
+        if (write_file(CORRUPT_PACK, image.bytes)) {
+            hdr = emblob_pack_map(CORRUPT_PACK, EMBLOB_PACK_HTTP, &err);
+        }
+
+        unlink(CORRUPT_PACK);
+        return hdr == nullptr && err == EINVAL;
+    }
+} // !namespace
+
+int main() {
+    const std::string valid = read_file(PACK_TEST_PATH);
+    const auto& hdr = *reinterpret_cast<const emblob_pack_header*>(valid.data());
+
+    int err = -1;
+    check(valid.size() > sizeof(emblob_pack_header) && hdr.member_count == 2 &&
+        emblob_pack_map(PACK_TEST_PATH, EMBLOB_PACK_HTTP, &err) != nullptr && err == 0,
+        "a valid pack is mapped");
+
+    check(rejected(valid, [](pack_image& p) { p.header().members_offset = p.header().file_size - 8; }),
+        "members table past the end of the file");
+    check(rejected(valid, [](pack_image& p) { p.header().member_count = UINT64_MAX / 2; }),
+        "more members than the file holds");
+    check(rejected(valid, [](pack_image& p) { p.header().slot_mask = 0xfffffff; }),
+        "hash table past the end of the file");
+    check(rejected(valid, [](pack_image& p) { p.header().names_offset = p.header().file_size + 1; }),
+        "names past the end of the file");
+    check(rejected(valid, [](pack_image& p) { p.header().dictionary_size = p.header().file_size; }),
+        "dictionary past the end of the file");
+    check(rejected(valid, [](pack_image& p) { p.header().http_offset = p.header().file_size - 16; }),
+        "HTTP metadata past the end of the file");
+    check(rejected(valid, [](pack_image& p) { p.header().http_strings_offset = UINT64_MAX; }),
+        "HTTP strings past the end of the file");
+    check(rejected(valid, [](pack_image& p) { p.words(p.header().members_offset)[2] = p.header().blob_size; }),
+        "member stored past the end of the blob");
+    check(rejected(valid, [](pack_image& p) { p.words(p.header().members_offset)[3] = UINT64_MAX; }),
+        "member whose stored size overflows");
+    check(rejected(valid, [](pack_image& p) { p.words(p.header().members_offset)[0] = p.header().file_size; }),
+        "member name past the end of the file");
+    check(rejected(valid, [](pack_image& p) { p.words(p.header().http_offset)[1] = UINT64_MAX - 1; }),
+        "ETag past the end of the file");
+    check(rejected(valid, [](pack_image& p) {
+        for (uint64_t n = 0; n <= p.header().slot_mask; n++) {
+            p.slots()[n] = 1;
+        }
+    }), "hash table without an empty slot");
+    check(rejected(valid, [](pack_image& p) { p.slots()[0] = static_cast<uint32_t>(p.header().member_count + 1); }),
+        "hash table referring to a member which does not exist");
+
+    /* the accessors fall back to an empty pack. */
+    pack_image image { valid };
+    image.header().members_offset = image.header().file_size - 8;
+    check(write_file(CORRUPT_PACK, image.bytes) && emblob_pack_site_pack_open(CORRUPT_PACK) == -1 &&
+        emblob_pack_site_pack_error() == EINVAL && emblob_pack_site_member_count() == 0 &&
+        emblob_pack_site_find("index.html") == -1, "a corrupt pack is empty");
+    unlink(CORRUPT_PACK);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,76 @@
+/*
+ * registry_test.cc
+ *
+ * Author:    Ryan M. Lederman <lederman@gmail.com>
+ * Copyright: Copyright (c) 2018-2024
+ * Version:   2.0.1
+ * License:   The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "emblob_alpha.h"
+#include "emblob_beta.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+/*
+ * Checks that an executable and a shared library which both contain registered
+ * blobs each see (and sort, and search) only their own: the executable links
+ * beta and alpha, and the library zeta and mid, each in that order, so that
+ * neither section is sorted to begin with.
+ */
+
+extern "C" {
+    size_t registry_lib_count();
+    const emblob_registry_entry* registry_lib_at(size_t i);
+    const emblob_registry_entry* registry_lib_find(const char* name);
+}
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool ok, const char* what) {
+        std::printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+        failures += ok ? 0 : 1;
+    }
+
+    bool named(const emblob_registry_entry* entry, const char* name) {
+        return entry != nullptr && std::strcmp(entry->name, name) == 0;
+    }
+} // !namespace
+
+int main() {
+    /* the executable's registry is sorted first; the library's must not then
+     * be taken to be sorted already. */
+    check(emblob_registry_count() == 2, "the executable has two registered blobs");
+    check(named(emblob_registry_at(0), "alpha") && named(emblob_registry_at(1), "beta"),
+        "the executable's blobs are in order of name");
+    check(named(emblob_registry_find("beta"), "beta") && emblob_registry_find("zeta") == nullptr,
+        "the executable finds only its own blobs");
+
+    check(registry_lib_count() == 2, "the library has two registered blobs");
+    check(named(registry_lib_at(0), "mid") && named(registry_lib_at(1), "zeta"),
+        "the library's blobs are in order of name");
+    check(named(registry_lib_find("zeta"), "zeta") && named(registry_lib_find("mid"), "mid") &&
+        registry_lib_find("alpha") == nullptr, "the library finds only its own blobs");
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}